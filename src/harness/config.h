@@ -0,0 +1,178 @@
+#ifndef HDFS_BENCHMARK_HARNESS_CONFIG_H
+#define HDFS_BENCHMARK_HARNESS_CONFIG_H
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * One section of a harness config: settings such as the command to run,
+ * and a matrix of parameters whose cross product is benchmarked.
+ *
+ *   # comment
+ *   max_runs = 20             (global defaults before the first section)
+ *   [buffer_size]
+ *   command = ./build/hdfs_reader -f {file} -b {buffer} -t {type}
+ *   param buffer = 1024 4096 65536
+ *   param type = standard scr
+ */
+struct Experiment {
+    string name;
+    map<string, string> settings;
+    vector<pair<string, vector<string>>> params;
+
+    string get(const string &key, const string &defaultValue = "") const {
+        auto it = settings.find(key);
+        return it == settings.end() ? defaultValue : it->second;
+    }
+
+    double getDouble(const string &key, double defaultValue) const {
+        auto it = settings.find(key);
+        return it == settings.end() ? defaultValue : stod(it->second);
+    }
+
+    /**
+     * Throws if a setting is not one of `known`, so that a misspelled key
+     * does not silently fall back to its default.
+     */
+    void checkSettings(const vector<string> &known) const {
+        for (auto &setting : settings) {
+            if (find(known.begin(), known.end(), setting.first) == known.end()) {
+                throw runtime_error("[" + name + "] unknown setting " + setting.first);
+            }
+        }
+    }
+
+    /**
+     * Throws if a parameter is not used as `{name}` in any setting, since
+     * every value of it would run the same benchmark.
+     */
+    void checkParams() const {
+        for (auto &param : params) {
+            string placeholder = "{" + param.first + "}";
+            bool used = false;
+            for (auto &setting : settings) {
+                used |= setting.second.find(placeholder) != string::npos;
+            }
+            if (!used) {
+                throw runtime_error("[" + name + "] param " + param.first + " is not used by any setting");
+            }
+        }
+    }
+
+    /**
+     * Returns every combination of parameter values.
+     */
+    vector<map<string, string>> points() const {
+        vector<map<string, string>> points(1);
+        for (auto &param : params) {
+            vector<map<string, string>> expanded;
+            for (auto &point : points) {
+                for (auto &value : param.second) {
+                    map<string, string> p(point);
+                    p[param.first] = value;
+                    expanded.push_back(p);
+                }
+            }
+            points.swap(expanded);
+        }
+        return points;
+    }
+};
+
+static string trim(const string &s) {
+    size_t start = s.find_first_not_of(" \t\r");
+    if (start == string::npos) {
+        return "";
+    }
+    size_t end = s.find_last_not_of(" \t\r");
+    return s.substr(start, end - start + 1);
+}
+
+/**
+ * Replaces all `{name}` placeholders in `s` with the value of `name` in
+ * `point`.
+ */
+string substitute(const string &s, const map<string, string> &point) {
+    string result;
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] == '{') {
+            size_t end = s.find('}', i);
+            if (end != string::npos) {
+                auto it = point.find(s.substr(i + 1, end - i - 1));
+                if (it != point.end()) {
+                    result += it->second;
+                    i = end;
+                    continue;
+                }
+            }
+        }
+        result += s[i];
+    }
+    return result;
+}
+
+vector<Experiment> parseConfig(const string &path) {
+    ifstream in(path);
+    if (!in) {
+        throw runtime_error("Cannot open config " + path);
+    }
+
+    Experiment defaults;
+    vector<Experiment> experiments;
+    Experiment *current = &defaults;
+
+    string line;
+    unsigned lineNo = 0;
+    while (getline(in, line)) {
+        lineNo++;
+        line = trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        if (line[0] == '[') {
+            if (line.back() != ']') {
+                throw runtime_error(path + ":" + to_string(lineNo) + ": invalid section");
+            }
+            Experiment experiment(defaults);
+            experiment.name = trim(line.substr(1, line.size() - 2));
+            experiments.push_back(experiment);
+            current = &experiments.back();
+            continue;
+        }
+
+        size_t eq = line.find('=');
+        if (eq == string::npos) {
+            throw runtime_error(path + ":" + to_string(lineNo) + ": expected key = value");
+        }
+        string key = trim(line.substr(0, eq));
+        string value = trim(line.substr(eq + 1));
+
+        if (key.compare(0, 6, "param ") == 0) {
+            vector<string> values;
+            stringstream ss(value);
+            string v;
+            while (ss >> v) {
+                values.push_back(v);
+            }
+            current->params.push_back(make_pair(trim(key.substr(6)), values));
+        } else {
+            current->settings[key] = value;
+        }
+    }
+
+    if (experiments.empty()) {
+        defaults.name = path;
+        experiments.push_back(defaults);
+    }
+    return experiments;
+}
+
+#endif //HDFS_BENCHMARK_HARNESS_CONFIG_H
@@ -0,0 +1,337 @@
+#include <iostream>
+#include <fstream>
+#include <memory>
+#include <chrono>
+#include <ctime>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "../queries/HdfsReader.h"
+#include "../queries/log.h"
+#include "config.h"
+#include "stats.h"
+
+using namespace std;
+
+static const char *DEFAULT_DROP_CACHES = "sync && echo 3 > /proc/sys/vm/drop_caches";
+
+// The settings read by runExperiment() and the runners
+static const vector<string> KNOWN_SETTINGS = {
+        "runner", "cache", "min_runs", "max_runs", "warmup", "target", "drop_caches", "output", "format", "label",
+        "command", "metric", "namenode", "port", "socket", "path", "threads", "buffer"
+};
+
+/**
+ * Runs `command` with /bin/sh and returns its stdout.
+ */
+string runProcess(const string &command) {
+    FILE *pipe = popen(command.c_str(), "r");
+    if (pipe == NULL) {
+        throw runtime_error("popen failed: " + string(strerror(errno)));
+    }
+
+    string output;
+    char buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), pipe)) > 0) {
+        output.append(buffer, read);
+    }
+
+    int status = pclose(pipe);
+    if (status != 0) {
+        throw runtime_error("'" + command + "' exited with status " + to_string(WEXITSTATUS(status)));
+    }
+    return output;
+}
+
+/**
+ * Extracts the measured value from a child's output. `metric` is either
+ * `field N` (the N-th number, e.g. of hdfs_reader's "speed speed2" line)
+ * or `duration` (the "duration ...ms" line of the queries).
+ */
+double parseMetric(const string &output, const string &metric) {
+    if (metric == "duration") {
+        size_t pos = output.rfind("duration ");
+        if (pos == string::npos) {
+            throw runtime_error("No duration in output: " + output);
+        }
+        return stod(output.substr(pos + 9));
+    }
+
+    unsigned field = 0;
+    if (metric.compare(0, 6, "field ") == 0) {
+        field = stoul(metric.substr(6));
+    } else if (!metric.empty()) {
+        throw runtime_error("Unknown metric " + metric);
+    }
+
+    stringstream ss(output);
+    string token;
+    unsigned idx = 0;
+    while (ss >> token) {
+        char *end;
+        double value = strtod(token.c_str(), &end);
+        if (end != token.c_str() && *end == 0) {
+            if (idx++ == field) {
+                return value;
+            }
+        }
+    }
+    throw runtime_error("No field " + to_string(field) + " in output: " + output);
+}
+
+class Runner {
+public:
+    virtual ~Runner() {
+
+    }
+
+    /**
+     * Performs one run at `point` and returns its measured value.
+     */
+    virtual double run(const Experiment &experiment, const map<string, string> &point) = 0;
+};
+
+/**
+ * Runs `command` as a child process and parses `metric` from its output;
+ * `metric = wall` uses the wall clock time of the child in ms instead.
+ */
+class ProcessRunner : public Runner {
+public:
+    double run(const Experiment &experiment, const map<string, string> &point) {
+        string command = substitute(experiment.get("command"), point);
+        if (command.empty()) {
+            throw runtime_error("[" + experiment.name + "] has no command");
+        }
+
+        auto start = chrono::high_resolution_clock::now();
+        string output = runProcess(command);
+        auto stop = chrono::high_resolution_clock::now();
+
+        string metric = experiment.get("metric", "field 0");
+        if (metric == "wall") {
+            return chrono::duration_cast<chrono::microseconds>(stop - start).count() / 1000.0;
+        }
+        return parseMetric(output, metric);
+    }
+};
+
+/**
+ * Reads `path` in-process with `HdfsReader` and returns MB/s. Connections
+ * are kept open across runs, so no JVM or namenode handshake is measured.
+ */
+class HdfsReadRunner : public Runner {
+public:
+    double run(const Experiment &experiment, const map<string, string> &point) {
+        string namenode = substitute(experiment.get("namenode", "localhost"), point);
+        int port = stoi(substitute(experiment.get("port", "9000"), point));
+        string socket = substitute(experiment.get("socket", ""), point);
+        string path = substitute(experiment.get("path"), point);
+        unsigned threads = stoul(substitute(experiment.get("threads", "1"), point));
+        size_t bufferSize = stoull(substitute(experiment.get("buffer", "4096"), point));
+
+        string key = namenode + ":" + to_string(port) + ":" + socket;
+        auto &reader = readers[key];
+        if (!reader) {
+            reader.reset(new HdfsReader(namenode, port, socket));
+            reader->connect();
+        }
+        reader->setBufferSize(bufferSize);
+
+        auto start = chrono::high_resolution_clock::now();
+        boost::atomic<size_t> len(0);
+        reader->read(path, nullptr, [&](Block &block) {
+            len += block.fileInfo.mSize;
+        }, threads);
+        auto stop = chrono::high_resolution_clock::now();
+
+        double seconds = chrono::duration_cast<chrono::microseconds>(stop - start).count() / 1e6;
+        return ((double) len) / (1024.0 * 1024.0) / seconds;
+    }
+
+private:
+    map<string, unique_ptr<HdfsReader>> readers;
+};
+
+string formatParams(const map<string, string> &point) {
+    string s;
+    for (auto &p : point) {
+        s += (s.empty() ? "" : ";") + p.first + "=" + p.second;
+    }
+    return s;
+}
+
+/**
+ * Quotes a CSV field if it contains a comma, quote or line break.
+ */
+string csvField(const string &s) {
+    if (s.find_first_of(",\"\r\n") == string::npos) {
+        return s;
+    }
+    string result = "\"";
+    for (char c : s) {
+        if (c == '"') {
+            result += '"';
+        }
+        result += c;
+    }
+    return result + "\"";
+}
+
+string jsonEscape(const string &s) {
+    string result;
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+        }
+        result += c;
+    }
+    return result;
+}
+
+/**
+ * Appends one result row. CSV files get a header when they are created,
+ * JSON output is one object per line, so that results of repeated
+ * invocations accumulate in the same file.
+ */
+void writeResult(const string &path, bool json, const string &label, const Experiment &experiment,
+                 const map<string, string> &point, const string &cache, const Summary &s, bool converged) {
+    char host[256] = {0};
+    gethostname(host, sizeof(host) - 1);
+    char timestamp[32];
+    time_t now = time(NULL);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+    bool exists = ifstream(path).good();
+    ofstream out(path, ios::app);
+    if (!out) {
+        throw runtime_error("Cannot write " + path);
+    }
+
+    if (json) {
+        out << "{\"timestamp\":\"" << timestamp << "\",\"host\":\"" << jsonEscape(host) << "\",\"label\":\""
+        << jsonEscape(label) << "\",\"experiment\":\"" << jsonEscape(experiment.name) << "\",\"params\":{";
+        bool first = true;
+        for (auto &p : point) {
+            out << (first ? "" : ",") << "\"" << jsonEscape(p.first) << "\":\"" << jsonEscape(p.second) << "\"";
+            first = false;
+        }
+        out << "},\"cache\":\"" << cache << "\",\"n\":" << s.n << ",\"median\":" << s.median << ",\"mad\":" << s.mad
+        << ",\"ci_low\":" << s.ciLow << ",\"ci_high\":" << s.ciHigh << ",\"mean\":" << s.mean << ",\"stddev\":"
+        << s.stddev << ",\"min\":" << s.min << ",\"max\":" << s.max << ",\"converged\":"
+        << (converged ? "true" : "false") << "}" << endl;
+    } else {
+        if (!exists) {
+            out << "timestamp,host,label,experiment,params,cache,n,median,mad,ci_low,ci_high,mean,stddev,min,max,"
+                    "converged" << endl;
+        }
+        out << timestamp << "," << csvField(host) << "," << csvField(label) << "," << csvField(experiment.name) << ","
+        << csvField(formatParams(point)) << "," << cache << "," << s.n << "," << s.median << "," << s.mad << "," << s.ciLow << "," << s.ciHigh
+        << "," << s.mean << "," << s.stddev << "," << s.min << "," << s.max << "," << (converged ? 1 : 0) << endl;
+    }
+}
+
+void runExperiment(const Experiment &experiment, Runner &runner) {
+    experiment.checkSettings(KNOWN_SETTINGS);
+    experiment.checkParams();
+
+    string cacheSetting = experiment.get("cache", "hot");
+    vector<string> caches;
+    if (cacheSetting == "both") {
+        caches = {"hot", "cold"};
+    } else if (cacheSetting == "hot" || cacheSetting == "cold") {
+        caches = {cacheSetting};
+    } else {
+        throw runtime_error("[" + experiment.name + "] cache must be hot, cold or both");
+    }
+
+    unsigned minRuns = stoul(experiment.get("min_runs", "3"));
+    unsigned maxRuns = stoul(experiment.get("max_runs", "20"));
+    unsigned warmup = stoul(experiment.get("warmup", "1"));
+    double target = experiment.getDouble("target", 0.05);
+    string dropCaches = experiment.get("drop_caches", DEFAULT_DROP_CACHES);
+    string output = experiment.get("output");
+    string format = experiment.get("format", output.size() > 5 && output.substr(output.size() - 5) == ".json"
+                                             ? "json" : "csv");
+    string label = experiment.get("label");
+
+    for (auto &point : experiment.points()) {
+        for (auto &cache : caches) {
+            bool cold = cache == "cold";
+
+            if (!cold) {
+                for (unsigned i = 0; i < warmup; i++) {
+                    runner.run(experiment, point);
+                }
+            }
+
+            // Sample until the relative MAD is below target
+            vector<double> samples;
+            Summary summary;
+            bool converged = false;
+            while (samples.size() < maxRuns) {
+                if (cold && system(dropCaches.c_str()) != 0) {
+                    throw runtime_error("'" + dropCaches + "' failed, are you root?");
+                }
+                samples.push_back(runner.run(experiment, point));
+                summary = summarize(samples);
+                if (samples.size() >= minRuns && summary.mad <= target * fabs(summary.median)) {
+                    converged = true;
+                    break;
+                }
+            }
+
+            cout << experiment.name << " " << formatParams(point) << " " << cache << ": median " << summary.median
+            << " MAD " << summary.mad << " CI [" << summary.ciLow << ", " << summary.ciHigh << "] n=" << summary.n
+            << (converged ? "" : " (not converged)") << endl;
+
+            if (!output.empty()) {
+                writeResult(output, format == "json", label, experiment, point, cache, summary, converged);
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    initLogging();
+    if (argc < 2) {
+        cout << "Usage: " << argv[0] << " CONFIG [EXPERIMENT...]" << endl;
+        exit(1);
+    }
+
+    try {
+        vector<Experiment> experiments = parseConfig(argv[1]);
+
+        ProcessRunner processRunner;
+        HdfsReadRunner hdfsReadRunner;
+
+        for (auto &experiment : experiments) {
+            if (argc > 2) {
+                bool selected = false;
+                for (int i = 2; i < argc; i++) {
+                    selected |= experiment.name == argv[i];
+                }
+                if (!selected) {
+                    continue;
+                }
+            }
+
+            string runner = experiment.get("runner", "process");
+            if (runner == "process") {
+                runExperiment(experiment, processRunner);
+            } else if (runner == "hdfs_read") {
+                runExperiment(experiment, hdfsReadRunner);
+            } else {
+                throw runtime_error("[" + experiment.name + "] unknown runner " + runner);
+            }
+        }
+    } catch (exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
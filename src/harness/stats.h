@@ -0,0 +1,76 @@
+#ifndef HDFS_BENCHMARK_HARNESS_STATS_H
+#define HDFS_BENCHMARK_HARNESS_STATS_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Robust summary of repeated measurements. The confidence interval is the
+ * distribution-free 95% interval of the median, taken from the order
+ * statistics of the samples.
+ */
+struct Summary {
+    size_t n = 0;
+    double median = 0;
+    double mad = 0;
+    double ciLow = 0;
+    double ciHigh = 0;
+    double mean = 0;
+    double stddev = 0;
+    double min = 0;
+    double max = 0;
+};
+
+static double medianOf(vector<double> values) {
+    sort(values.begin(), values.end());
+    size_t n = values.size();
+    if (n == 0) {
+        return 0;
+    }
+    return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2.0;
+}
+
+Summary summarize(const vector<double> &samples) {
+    Summary s;
+    s.n = samples.size();
+    if (s.n == 0) {
+        return s;
+    }
+
+    vector<double> sorted(samples);
+    sort(sorted.begin(), sorted.end());
+    s.min = sorted.front();
+    s.max = sorted.back();
+    s.median = medianOf(sorted);
+
+    vector<double> deviations;
+    for (double v : sorted) {
+        deviations.push_back(fabs(v - s.median));
+    }
+    s.mad = medianOf(deviations);
+
+    double sum = 0;
+    for (double v : sorted) {
+        sum += v;
+    }
+    s.mean = sum / s.n;
+    double variance = 0;
+    for (double v : sorted) {
+        variance += (v - s.mean) * (v - s.mean);
+    }
+    s.stddev = s.n > 1 ? sqrt(variance / (s.n - 1)) : 0;
+
+    // Ranks n/2 -+ 1.96 * sqrt(n)/2 of the binomial approximation
+    double spread = 1.96 * sqrt((double) s.n) / 2.0;
+    long low = (long) floor(s.n / 2.0 - spread);
+    long high = (long) ceil(s.n / 2.0 + spread);
+    s.ciLow = sorted[max(0l, min(low, (long) s.n - 1))];
+    s.ciHigh = sorted[max(0l, min(high, (long) s.n - 1))];
+
+    return s;
+}
+
+#endif //HDFS_BENCHMARK_HARNESS_STATS_H
@@ -0,0 +1,207 @@
+#ifndef HDFS_BENCHMARK_AUTOTUNE_H
+#define HDFS_BENCHMARK_AUTOTUNE_H
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include "common.h"
+
+using namespace std;
+
+/**
+ * A buffer size to be evaluated, together with the throughput samples
+ * (MB/s) measured for it so far.
+ */
+struct candidate_t {
+    size_t buffer_size;
+    bool block_aligned;
+    vector<double> samples;
+    bool eliminated = false;
+
+    candidate_t(size_t buffer_size, bool block_aligned) : buffer_size(buffer_size), block_aligned(block_aligned) {
+
+    }
+
+    double mean() const {
+        double sum = 0;
+        for (double s : samples) {
+            sum += s;
+        }
+        return samples.empty() ? 0 : sum / samples.size();
+    }
+
+    /**
+     * Half width of the 95% confidence interval of the mean, using
+     * Student's t-distribution.
+     */
+    double half_width() const {
+        static const double t95[] = {0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                     2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                     2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+        size_t n = samples.size();
+        if (n < 2) {
+            return INFINITY;
+        }
+        double m = mean(), variance = 0;
+        for (double s : samples) {
+            variance += (s - m) * (s - m);
+        }
+        variance /= (n - 1);
+        double t = n - 1 <= 30 ? t95[n - 1] : 1.96;
+        return t * sqrt(variance / n);
+    }
+
+    double lower() const {
+        return mean() - half_width();
+    }
+
+    double upper() const {
+        return mean() + half_width();
+    }
+};
+
+/**
+ * Reads the whole file with `hdfsRead` and returns the throughput in MB/s.
+ * With `block_aligned` no single read crosses an HDFS block boundary.
+ */
+double autotune_run(options_t &options, hdfsFS fs, hdfsFileInfo *fileInfo, char *buffer, candidate_t &candidate) {
+    uint64_t start = now_ns();
+
+    hdfsFile file = hdfsOpenFile(fs, options.path, O_RDONLY, candidate.buffer_size, 0, 0);
+    EXPECT_NONZERO(file, "hdfsOpenFile")
+
+    tOffset block_size = fileInfo->mBlockSize > 0 ? fileInfo->mBlockSize : fileInfo->mSize;
+    tOffset total_read = 0;
+    tSize read = 0;
+    do {
+        tSize length = (tSize) candidate.buffer_size;
+        if (candidate.block_aligned) {
+            length = (tSize) min((tOffset) length, block_size - total_read % block_size);
+        }
+        read = hdfsRead(fs, file, buffer, length);
+        EXPECT_NONNEGATIVE(read, "hdfsRead")
+
+        if (read > 0) {
+            useData(buffer, read);
+        }
+        total_read += read;
+    } while (read > 0);
+
+    hdfsCloseFile(fs, file);
+
+    if (total_read != fileInfo->mSize) {
+        fprintf(stderr, "Failed to read file to full size\n");
+        exit(1);
+    }
+
+    return (total_read / (1024.0 * 1024.0)) / ((now_ns() - start) / 1e9);
+}
+
+/**
+ * Measures all `candidates` in rounds until each one's confidence interval
+ * is narrower than `options.ci_target` of its mean, it reached
+ * `options.max_runs` samples, or its upper bound falls below the lower
+ * bound of the best candidate. Returns the best candidate.
+ */
+candidate_t &autotune_stage(options_t &options, hdfsFS fs, hdfsFileInfo *fileInfo, char *buffer,
+                            vector<candidate_t> &candidates) {
+    const unsigned min_runs = 3;
+
+    bool pending = true;
+    while (pending) {
+        pending = false;
+        for (auto &candidate : candidates) {
+            if (candidate.eliminated || candidate.samples.size() >= options.max_runs) {
+                continue;
+            }
+            if (candidate.samples.size() >= min_runs &&
+                candidate.half_width() <= options.ci_target * candidate.mean()) {
+                continue;
+            }
+            candidate.samples.push_back(autotune_run(options, fs, fileInfo, buffer, candidate));
+            pending = true;
+        }
+
+        candidate_t *best = &candidates[0];
+        for (auto &candidate : candidates) {
+            if (candidate.mean() > best->mean()) {
+                best = &candidate;
+            }
+        }
+        for (auto &candidate : candidates) {
+            if (&candidate != best && candidate.samples.size() >= min_runs && best->samples.size() >= min_runs &&
+                candidate.upper() < best->lower()) {
+                candidate.eliminated = true;
+            }
+        }
+    }
+
+    candidate_t *best = &candidates[0];
+    for (auto &candidate : candidates) {
+        if (options.verbose) {
+            printf("  %10lu %-9s %4lu runs %10.2f MB/s +- %.2f%s\n", (unsigned long) candidate.buffer_size,
+                   candidate.block_aligned ? "aligned" : "unaligned", (unsigned long) candidate.samples.size(),
+                   candidate.mean(), candidate.half_width(), candidate.eliminated ? " (eliminated)" : "");
+        }
+        if (candidate.mean() > best->mean()) {
+            best = &candidate;
+        }
+    }
+    return *best;
+}
+
+/**
+ * Searches the buffer size with the highest throughput in one process over
+ * one connection: first on a coarse grid of powers of 4 from 1 KB up to
+ * 512 MB (or the file size), then on powers of 2 around the best coarse
+ * size, with and without reads aligned to HDFS blocks.
+ */
+void run_autotune(options_t &options) {
+    hdfsFS fs = connect_hdfs(options, options.type != type_t::standard);
+
+    hdfsFileInfo *fileInfo = hdfsGetPathInfo(fs, options.path);
+    EXPECT_NONZERO(fileInfo, "hdfsGetPathInfo")
+
+    size_t max_size = 512 * 1024 * 1024;
+    while (max_size / 2 >= (size_t) fileInfo->mSize && max_size > 1024) {
+        max_size /= 2;
+    }
+    char *buffer = (char *) malloc(max_size);
+    EXPECT_NONZERO(buffer, "malloc")
+
+    vector<candidate_t> coarse;
+    for (size_t size = 1024; size <= max_size; size *= 4) {
+        coarse.push_back(candidate_t(size, false));
+    }
+    if (options.verbose) {
+        printf("Coarse search:\n");
+    }
+    size_t coarse_best = autotune_stage(options, fs, fileInfo, buffer, coarse).buffer_size;
+
+    vector<candidate_t> fine;
+    for (size_t size = max((size_t) 1024, coarse_best / 4); size <= min(max_size, coarse_best * 4); size *= 2) {
+        fine.push_back(candidate_t(size, false));
+        fine.push_back(candidate_t(size, true));
+    }
+    if (options.verbose) {
+        printf("Fine search:\n");
+    }
+    candidate_t best = autotune_stage(options, fs, fileInfo, buffer, fine);
+
+    if (options.verbose) {
+        printf("Best buffer size %lu (%s): %f MB/s, 95%% CI [%f, %f], %lu runs\n",
+               (unsigned long) best.buffer_size, best.block_aligned ? "block aligned" : "unaligned",
+               best.mean(), best.lower(), best.upper(), (unsigned long) best.samples.size());
+    } else {
+        printf("%lu %d %f %f %f\n", (unsigned long) best.buffer_size, best.block_aligned ? 1 : 0, best.mean(),
+               best.lower(), best.upper());
+    }
+
+    free(buffer);
+    hdfsFreeFileInfo(fileInfo, 1);
+    hdfsDisconnect(fs);
+}
+
+#endif //HDFS_BENCHMARK_AUTOTUNE_H
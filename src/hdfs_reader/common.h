@@ -0,0 +1,102 @@
+#ifndef HDFS_BENCHMARK_HDFS_READER_COMMON_H
+#define HDFS_BENCHMARK_HDFS_READER_COMMON_H
+
+#include <cassert>
+#include <cstdint>
+
+#include <string.h>
+#include <time.h>
+#ifdef HAS_LIBHDFS
+#include <hdfs.h>
+#else
+#include <hdfs/hdfs.h>
+#endif
+
+#include "options.h"
+
+// On Mac OS X clock_gettime is not available
+#ifdef __MACH__
+#include <mach/mach_time.h>
+
+#define CLOCK_MONOTONIC 0
+int clock_gettime(int clk_id, struct timespec *t){
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    uint64_t time;
+    time = mach_absolute_time();
+    double nseconds = ((double)time * (double)timebase.numer)/((double)timebase.denom);
+    double seconds = ((double)time * (double)timebase.numer)/((double)timebase.denom * 1e9);
+    t->tv_sec = seconds;
+    t->tv_nsec = nseconds;
+    return 0;
+}
+#endif
+
+#define EXPECT_NONZERO(r, func) if(r==NULL) { \
+                                    fprintf(stderr, "%s failed: %s\n", func, strerror(errno)); \
+                                    exit(1); \
+                                }
+
+#define EXPECT_NONNEGATIVE(r, func) if(r < 0) { \
+                                    fprintf(stderr, "%s failed: %s\n", func, strerror(errno)); \
+                                    exit(1); \
+                                }
+
+timespec timespec_diff(timespec start, timespec end) {
+    timespec temp;
+    if ((end.tv_nsec - start.tv_nsec) < 0) {
+        temp.tv_sec = end.tv_sec - start.tv_sec - 1;
+        temp.tv_nsec = 1000000000 + end.tv_nsec - start.tv_nsec;
+    } else {
+        temp.tv_sec = end.tv_sec - start.tv_sec;
+        temp.tv_nsec = end.tv_nsec - start.tv_nsec;
+    }
+    return temp;
+}
+
+inline uint64_t timespec_ns(timespec t) {
+    return ((uint64_t) t.tv_sec) * 1000000000ull + t.tv_nsec;
+}
+
+inline uint64_t now_ns() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return timespec_ns(t);
+}
+
+inline void useData(void *buffer, tSize len) __attribute__((__always_inline__));
+inline void useData(void *buffer, tSize len) {
+    uint64_t sum  = 0;
+    for (size_t i = 0; i < len/sizeof(uint64_t); i++) {
+        sum += *(((uint64_t*) buffer) + i);
+    }
+    assert(sum);
+}
+
+/**
+ * Connects to the namenode in `options`, with short circuit reads enabled
+ * if `short_circuit` is set.
+ */
+hdfsFS connect_hdfs(options_t &options, bool short_circuit) {
+    struct hdfsBuilder *hdfsBuilder = hdfsNewBuilder();
+    hdfsBuilderSetNameNode(hdfsBuilder, options.namenode);
+    hdfsBuilderSetNameNodePort(hdfsBuilder, options.namenode_port);
+    if(short_circuit) {
+        hdfsBuilderConfSetStr(hdfsBuilder, "dfs.client.read.shortcircuit", "true");
+        hdfsBuilderConfSetStr(hdfsBuilder, "dfs.domain.socket.path", options.socket);
+        // TODO Test
+        //hdfsBuilderConfSetStr(hdfsBuilder, "dfs.client.domain.socket.data.traffic", "true");
+        //hdfsBuilderConfSetStr(hdfsBuilder, "dfs.client.read.shortcircuit.streams.cache.size", "4000");
+        hdfsBuilderConfSetStr(hdfsBuilder, "dfs.client.read.shortcircuit.skip.checksum", options.skip_checksums > 0 ? "true" : "false");
+    } else {
+        hdfsBuilderConfSetStr(hdfsBuilder, "dfs.client.read.shortcircuit", "false");
+    }
+
+    hdfsFS fs = hdfsBuilderConnect(hdfsBuilder);
+    EXPECT_NONZERO(fs, "hdfsBuilderConnect")
+    //hdfsFreeBuilder(hdfsBuilder); // SEGFAULT's
+
+    return fs;
+}
+
+#endif //HDFS_BENCHMARK_HDFS_READER_COMMON_H
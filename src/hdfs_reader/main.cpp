@@ -1,68 +1,14 @@
 #include <iostream>
 #include <cassert>
 
-#include <string.h>
-#ifdef HAS_LIBHDFS
-#include <hdfs.h>
-#else
-#include <hdfs/hdfs.h>
-#endif
-
-#include "options.h"
+#include "common.h"
+#include "pread.h"
+#include "ranges.h"
+#include "autotune.h"
+#include "tree.h"
 
 using namespace std;
 
-// On Mac OS X clock_gettime is not available
-#ifdef __MACH__
-#include <mach/mach_time.h>
-
-#define CLOCK_MONOTONIC 0
-int clock_gettime(int clk_id, struct timespec *t){
-    mach_timebase_info_data_t timebase;
-    mach_timebase_info(&timebase);
-    uint64_t time;
-    time = mach_absolute_time();
-    double nseconds = ((double)time * (double)timebase.numer)/((double)timebase.denom);
-    double seconds = ((double)time * (double)timebase.numer)/((double)timebase.denom * 1e9);
-    t->tv_sec = seconds;
-    t->tv_nsec = nseconds;
-    return 0;
-}
-#endif
-
-#define EXPECT_NONZERO(r, func) if(r==NULL) { \
-                                    fprintf(stderr, "%s failed: %s\n", func, strerror(errno)); \
-                                    exit(1); \
-                                }
-
-#define EXPECT_NONNEGATIVE(r, func) if(r < 0) { \
-                                    fprintf(stderr, "%s failed: %s\n", func, strerror(errno)); \
-                                    exit(1); \
-                                }
-
-timespec timespec_diff(timespec start, timespec end) {
-    timespec temp;
-    if ((end.tv_nsec - start.tv_nsec) < 0) {
-        temp.tv_sec = end.tv_sec - start.tv_sec - 1;
-        temp.tv_nsec = 1000000000 + end.tv_nsec - start.tv_nsec;
-    } else {
-        temp.tv_sec = end.tv_sec - start.tv_sec;
-        temp.tv_nsec = end.tv_nsec - start.tv_nsec;
-    }
-    return temp;
-}
-
-
-
-inline void useData(void *buffer, tSize len) __attribute__((__always_inline__));
-inline void useData(void *buffer, tSize len) {
-    uint64_t sum  = 0;
-    for (size_t i = 0; i < len/sizeof(uint64_t); i++) {
-        sum += *(((uint64_t*) buffer) + i);
-    }
-    assert(sum);
-}
-
 
 bool readHdfsZcr(options_t &options, hdfsFS fs, hdfsFile file, hdfsFileInfo *fileInfo) {
 #ifdef HAS_LIBHDFS
@@ -153,28 +99,39 @@ int main(int argc, char *argv[]) {
         cout << "Buffer:    " << options.buffer_size << endl;
         cout << "Checksums: " << (options.skip_checksums ? "false" : "true") << endl;
         cout << "Type:      " << options.type << endl;
+        cout << "Jobs:      " << options.jobs << endl;
     }
 
-    struct hdfsBuilder *hdfsBuilder = hdfsNewBuilder();
-    hdfsBuilderSetNameNode(hdfsBuilder, options.namenode);
-    hdfsBuilderSetNameNodePort(hdfsBuilder, options.namenode_port);
-    if(options.type == type_t::undefined || options.type == type_t::scr || options.type == type_t::zcr) {
-        hdfsBuilderConfSetStr(hdfsBuilder, "dfs.client.read.shortcircuit", "true");
-        hdfsBuilderConfSetStr(hdfsBuilder, "dfs.domain.socket.path", options.socket);
-        // TODO Test
-        //hdfsBuilderConfSetStr(hdfsBuilder, "dfs.client.domain.socket.data.traffic", "true");
-        //hdfsBuilderConfSetStr(hdfsBuilder, "dfs.client.read.shortcircuit.streams.cache.size", "4000");
-        hdfsBuilderConfSetStr(hdfsBuilder, "dfs.client.read.shortcircuit.skip.checksum", options.skip_checksums > 0 ? "true" : "false");
-    } else {
-        hdfsBuilderConfSetStr(hdfsBuilder, "dfs.client.read.shortcircuit", "false");
+    if(options.tree) {
+        if(options.type == type_t::zcr || options.type == type_t::pread) {
+            printf("--tree supports standard and scr reads only\n");
+            exit(1);
+        }
+        run_tree(options);
+        return 0;
+    }
+
+    if(options.autotune) {
+        if(options.type == type_t::zcr || options.type == type_t::pread) {
+            printf("--autotune supports standard and scr reads only\n");
+            exit(1);
+        }
+        run_autotune(options);
+        return 0;
+    }
+
+    if(options.type == type_t::pread) {
+        run_pread(options);
+        return 0;
     }
 
     // Connect
-    hdfsFS fs = hdfsBuilderConnect(hdfsBuilder);
-	EXPECT_NONZERO(fs, "hdfsBuilderConnect")
+    hdfsFS fs = connect_hdfs(options, options.type == type_t::undefined || options.type == type_t::scr ||
+                                      options.type == type_t::zcr);
 
     struct timespec start, end, start2, end2;
     tOffset fileSize = 0;
+    vector<range_t> ranges;
 
     // Check if the file exists
     if (hdfsExists(fs, options.path) != 0) {
@@ -204,7 +161,9 @@ int main(int argc, char *argv[]) {
 
         clock_gettime(CLOCK_MONOTONIC, &start2);
 
-        if(options.type == type_t::undefined) {
+        if(options.jobs > 1 && options.type != type_t::zcr) {
+            ranges = readHdfsRanges(options, fs, fileInfo);
+        } else if(options.type == type_t::undefined) {
             if (!readHdfsZcr(options, fs, file, fileInfo)) {
                 cout << "Falling back to standard read" << endl;
                 readHdfsStandard(options, fs, file, fileInfo);
@@ -220,12 +179,27 @@ int main(int argc, char *argv[]) {
         // Get Statistics
 #ifdef HAS_LIBHDFS
         if(options.verbose) {
-            struct hdfsReadStatistics *stats;
-            hdfsFileGetReadStatistics(file, &stats);
+            uint64_t total = 0, local = 0, shortCircuit = 0, zeroCopy = 0;
+            if (ranges.empty()) {
+                struct hdfsReadStatistics *stats;
+                hdfsFileGetReadStatistics(file, &stats);
+                total = stats->totalBytesRead;
+                local = stats->totalLocalBytesRead;
+                shortCircuit = stats->totalShortCircuitBytesRead;
+                zeroCopy = stats->totalZeroCopyBytesRead;
+                hdfsFileFreeReadStatistics(stats);
+            } else {
+                // Ranges are read through their own handles
+                for (auto &range : ranges) {
+                    total += range.bytes_total;
+                    local += range.bytes_local;
+                    shortCircuit += range.bytes_short_circuit;
+                    zeroCopy += range.bytes_zero_copy;
+                }
+            }
             printf("Statistics:\n\tTotal: %lu\n\tLocal: %lu\n\tShort Circuit: %lu\n\tZero Copy Read: %lu\n",
-                   stats->totalBytesRead, stats->totalLocalBytesRead, stats->totalShortCircuitBytesRead,
-                   stats->totalZeroCopyBytesRead);
-            hdfsFileFreeReadStatistics(stats);
+                   (unsigned long) total, (unsigned long) local, (unsigned long) shortCircuit,
+                   (unsigned long) zeroCopy);
         }
 #endif
 
@@ -242,11 +216,15 @@ int main(int argc, char *argv[]) {
     if(options.verbose) {
         printf("Read %f MB with %lfMB/s (%lfMB/s)\n", ((double) fileSize) / (1024.0 * 1024.0), speed, speed2);
     } else {
-        printf("%f %f\n", speed, speed2);
+        // Per-thread throughput of range reads follows the aggregate
+        printf("%f %f", speed, speed2);
+        for (auto &range : ranges) {
+            printf(" %f", ((double) (range.end - range.start)) / (range.ns / 1e9) / (1024.0 * 1024.0));
+        }
+        printf("\n");
     }
 
     hdfsDisconnect(fs);
-    //hdfsFreeBuilder(hdfsBuilder); // SEGFAULT's
 
     return 0;
 }
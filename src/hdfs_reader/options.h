@@ -1,9 +1,25 @@
+#ifndef HDFS_BENCHMARK_OPTIONS_H
+#define HDFS_BENCHMARK_OPTIONS_H
+
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <getopt.h>
 
 typedef enum {
-    undefined = 0, standard, scr, zcr
+    undefined = 0, standard, scr, zcr, pread
 } type_t;
 
+typedef enum {
+    uniform = 0, zipf, strided
+} pattern_t;
+
+static const char *pattern_s[] = {
+        "uniform", "zipf", "strided"
+};
+
 typedef struct {
     const char *path = NULL;
     const char *socket = "/var/lib/hadoop-hdfs/dn_socket";
@@ -14,18 +30,62 @@ typedef struct {
     int skip_checksums = false;
     int sample = false;
     type_t type = type_t::undefined;
+    unsigned jobs = 1;
+
+    // read all files in the directory tree at path
+    int tree = false;
+
+    // buffer size autotuning
+    int autotune = false;
+    double ci_target = 0.05;
+    unsigned max_runs = 10;
+
+    // pread benchmark
+    std::vector<size_t> pread_sizes = {4096, 65536, 1048576};
+    pattern_t pattern = pattern_t::uniform;
+    double zipf_theta = 0.99;
+    size_t stride = 1048576;
+    unsigned requests = 1000;
+    unsigned pread_threads = 1;
 } options_t;
 
+std::vector<size_t> parse_sizes(const char *arg) {
+    std::vector<size_t> sizes;
+    char *end = NULL;
+    do {
+        size_t size = strtoull(arg, &end, 10);
+        if (end == arg || size == 0) {
+            printf("%s is not a valid list of sizes\n", arg);
+            exit(1);
+        }
+        sizes.push_back(size);
+        arg = end + 1;
+    } while (*end == ',');
+    return sizes;
+}
+
 void print_usage() {
-    printf("hdfs_benchmark -f FILE [-b BUFFER_SIZE] [-t TYPE] [-n NAMENODE] [-p NAMENODE_PORT]\n"
-                   "  -f, --file           File to read\n"
+    printf("hdfs_benchmark -f FILE [-b BUFFER_SIZE] [-t TYPE] [-j JOBS] [-n NAMENODE] [-p NAMENODE_PORT]\n"
+                   "  -f, --file           File (or directory with --tree) to read\n"
                    "  -b, --buffer         Buffer size, defaults to 4096\n"
-                   "  -t, --type           One of standard, sc, zcr\n"
+                   "  -t, --type           One of standard, scr, zcr, pread\n"
+                   "  -j, --jobs           Read the file in JOBS ranges concurrently (standard, scr), default: 1\n"
                    "  -n, --namenode       Namenode hostname, default: localhost\n"
                    "  -p, --namenode-port  Namenode port, default: 9000\n"
                    "  -s, --socket         The short circuit socket\n"
                    "  -v, --verbose        Verbose output, e.g. statistics, formatted speed\n"
-                   "  -x, --sample         Sample the copy speed every 1s\n");
+                   "  -x, --sample         Sample the copy speed every 1s\n"
+                   "  --tree               Read all files below the directory FILE, JOBS files at a time\n"
+                   "  --autotune           Search the buffer size with the highest throughput (standard, scr)\n"
+                   "  --ci-target FRACTION Stop sampling once the 95%% CI is within FRACTION of the mean, default: 0.05\n"
+                   "  --max-runs N         Maximum samples per buffer size, default: 10\n"
+                   "pread options (-t pread, runs standard and short circuit reads):\n"
+                   "  --sizes LIST         Comma separated request sizes, default: 4096,65536,1048576\n"
+                   "  --pattern PATTERN    One of uniform, zipf, strided, default: uniform\n"
+                   "  --zipf-theta THETA   Skew of the zipf pattern, default: 0.99\n"
+                   "  --stride BYTES       Distance between strided requests, default: 1048576\n"
+                   "  --requests N         Requests per thread, default: 1000\n"
+                   "  --pread-threads N    Concurrent readers, default: 1\n");
 }
 
 options_t parse_options(int argc, char *argv[]) {
@@ -36,12 +96,23 @@ options_t parse_options(int argc, char *argv[]) {
             {"buffer", optional_argument, 0,                'b'},
             {"help",   optional_argument, 0,                'h'},
             {"type",   optional_argument, 0,                't'},
+            {"jobs",   required_argument, 0,                'j'},
             {"socket", optional_argument, 0,                's'},
             {"namenode", optional_argument, 0,              'n'},
             {"namenode-port", optional_argument, 0,         'p'},
             {"verbose",      no_argument,       &options.verbose, 'v'},
             {"sample",      no_argument,       &options.sample, 'x'},
             {"skip-checksums",     no_argument, &options.skip_checksums, 1},
+            {"tree",          no_argument, &options.tree, 1},
+            {"autotune",      no_argument, &options.autotune, 1},
+            {"ci-target",     required_argument, 0,         1006},
+            {"max-runs",      required_argument, 0,         1007},
+            {"sizes",         required_argument, 0,         1000},
+            {"pattern",       required_argument, 0,         1001},
+            {"zipf-theta",    required_argument, 0,         1002},
+            {"stride",        required_argument, 0,         1003},
+            {"requests",      required_argument, 0,         1004},
+            {"pread-threads", required_argument, 0,         1005},
 
             {0, 0,                        0,                0}
     };
@@ -49,7 +120,7 @@ options_t parse_options(int argc, char *argv[]) {
     int c = 0;
     while (c >= 0) {
         int option_index;
-        c = getopt_long(argc, argv, "f:b:n:p:t:s:v", options_config, &option_index);
+        c = getopt_long(argc, argv, "f:b:n:p:t:s:j:v", options_config, &option_index);
 
         switch (c) {
             case 'v':
@@ -61,6 +132,13 @@ options_t parse_options(int argc, char *argv[]) {
             case 'b':
                 options.buffer_size = atoi(optarg);
                 break;
+            case 'j':
+                options.jobs = atoi(optarg);
+                if (options.jobs == 0) {
+                    printf("-j must be at least 1\n");
+                    exit(1);
+                }
+                break;
             case 'n':
                 options.namenode = optarg;
                 break;
@@ -83,11 +161,58 @@ options_t parse_options(int argc, char *argv[]) {
                     options.type = type_t::scr;
                 } else  if(strcmp(optarg, "zcr") == 0) {
                     options.type = type_t::zcr;
+                } else  if(strcmp(optarg, "pread") == 0) {
+                    options.type = type_t::pread;
                 } else {
                     printf("%s is not a valid type\n", optarg);
                     exit(1);
                 }
                 break;
+            case 1000:
+                options.pread_sizes = parse_sizes(optarg);
+                break;
+            case 1001:
+                if(strcmp(optarg, "uniform") == 0) {
+                    options.pattern = pattern_t::uniform;
+                } else if(strcmp(optarg, "zipf") == 0) {
+                    options.pattern = pattern_t::zipf;
+                } else if(strcmp(optarg, "strided") == 0) {
+                    options.pattern = pattern_t::strided;
+                } else {
+                    printf("%s is not a valid pattern\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 1002:
+                options.zipf_theta = atof(optarg);
+                if (options.zipf_theta <= 0 || options.zipf_theta == 1.0) {
+                    printf("zipf theta must be positive and not 1\n");
+                    exit(1);
+                }
+                break;
+            case 1003:
+                options.stride = strtoull(optarg, NULL, 10);
+                break;
+            case 1004:
+                options.requests = atoi(optarg);
+                break;
+            case 1005:
+                options.pread_threads = atoi(optarg);
+                if (options.pread_threads == 0) {
+                    printf("--pread-threads must be at least 1\n");
+                    exit(1);
+                }
+                break;
+            case 1006:
+                options.ci_target = atof(optarg);
+                break;
+            case 1007:
+                options.max_runs = atoi(optarg);
+                if (options.max_runs < 3) {
+                    printf("--max-runs must be at least 3\n");
+                    exit(1);
+                }
+                break;
             default:
                 break;
         }
@@ -98,5 +223,12 @@ options_t parse_options(int argc, char *argv[]) {
         exit(1);
     }
 
+    if (options.jobs > 1 && options.type == type_t::zcr) {
+        printf("-j supports standard and scr reads only\n");
+        exit(1);
+    }
+
     return options;
-}
\ No newline at end of file
+}
+
+#endif //HDFS_BENCHMARK_OPTIONS_H
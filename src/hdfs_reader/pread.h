@@ -0,0 +1,207 @@
+#ifndef HDFS_BENCHMARK_PREAD_H
+#define HDFS_BENCHMARK_PREAD_H
+
+#include <iostream>
+#include <map>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+#include <cmath>
+
+#include "common.h"
+#include "../queries/Histogram.h"
+
+using namespace std;
+
+/**
+ * Draws ranks in [0, n) following a zipf distribution with skew `theta`,
+ * as described by Gray et al. in "Quickly Generating Billion-Record
+ * Synthetic Databases".
+ */
+class ZipfGenerator {
+public:
+    ZipfGenerator(uint64_t n, double theta) : n(n), theta(theta) {
+        zetan = zeta(n, theta);
+        alpha = 1.0 / (1.0 - theta);
+        eta = (1.0 - pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta(2, theta) / zetan);
+    }
+
+    uint64_t next(double u) const {
+        double uz = u * zetan;
+        if (uz < 1.0) {
+            return 0;
+        }
+        if (uz < 1.0 + pow(0.5, theta)) {
+            return 1;
+        }
+        uint64_t rank = (uint64_t) (n * pow(eta * u - eta + 1.0, alpha));
+        return rank < n ? rank : n - 1;
+    }
+
+private:
+    static double zeta(uint64_t n, double theta) {
+        double sum = 0;
+        for (uint64_t i = 1; i <= n; i++) {
+            sum += 1.0 / pow((double) i, theta);
+        }
+        return sum;
+    }
+
+    uint64_t n;
+    double theta, zetan, alpha, eta;
+};
+
+/**
+ * Produces the offsets of positioned reads within a file of `file_size`
+ * bytes according to `options.pattern`.
+ */
+class OffsetGenerator {
+public:
+    OffsetGenerator(options_t &options, tOffset file_size, const ZipfGenerator *zipf, uint64_t slots,
+                    unsigned thread_idx) :
+            options(options), file_size(file_size), zipf(zipf), slots(slots), random(thread_idx + 1) {
+        position = (file_size / options.pread_threads) * thread_idx;
+    }
+
+    tOffset next(size_t size) {
+        tOffset last = file_size > (tOffset) size ? file_size - size : 0;
+        tOffset offset = 0;
+        switch (options.pattern) {
+            case pattern_t::uniform:
+                offset = random() % (last + 1);
+                break;
+            case pattern_t::zipf: {
+                // Scatter the popular slots over the file instead of
+                // clustering them at its beginning
+                uint64_t rank = zipf->next(uniform01(random));
+                uint64_t slot = (rank * 0x9E3779B97F4A7C15ull) % slots;
+                offset = slot * (file_size / slots);
+                break;
+            }
+            case pattern_t::strided:
+                offset = position % (last + 1);
+                position += options.stride;
+                break;
+        }
+        return offset > last ? last : offset;
+    }
+
+private:
+    options_t &options;
+    tOffset file_size;
+    const ZipfGenerator *zipf;
+    uint64_t slots;
+    tOffset position;
+    mt19937_64 random;
+    uniform_real_distribution<double> uniform01;
+};
+
+struct pread_result_t {
+    map<size_t, LatencyHistogram> latencies;
+    uint64_t bytes = 0;
+};
+
+void pread_thread(options_t &options, hdfsFS fs, tOffset file_size, const ZipfGenerator *zipf, uint64_t slots,
+                  unsigned thread_idx, pread_result_t &result) {
+    hdfsFile file = hdfsOpenFile(fs, options.path, O_RDONLY, options.buffer_size, 0, 0);
+    EXPECT_NONZERO(file, "hdfsOpenFile")
+
+    size_t max_size = *max_element(options.pread_sizes.begin(), options.pread_sizes.end());
+    char *buffer = (char *) malloc(max_size);
+
+    OffsetGenerator offsets(options, file_size, zipf, slots, thread_idx);
+    mt19937 random(thread_idx);
+    uniform_int_distribution<size_t> size_idx(0, options.pread_sizes.size() - 1);
+
+    for (unsigned i = 0; i < options.requests; i++) {
+        size_t size = options.pread_sizes[size_idx(random)];
+        if ((tOffset) size > file_size) {
+            size = file_size;
+        }
+        tOffset offset = offsets.next(size);
+
+        uint64_t start = now_ns();
+        tSize read = 0, total_read = 0;
+        do {
+            read = hdfsPread(fs, file, offset + total_read, buffer + total_read, size - total_read);
+            EXPECT_NONNEGATIVE(read, "hdfsPread")
+            total_read += read;
+        } while (read > 0 && (size_t) total_read < size);
+        uint64_t end = now_ns();
+
+        useData(buffer, total_read);
+        result.latencies[size].record(end - start);
+        result.bytes += total_read;
+    }
+
+    free(buffer);
+    hdfsCloseFile(fs, file);
+}
+
+/**
+ * Issues `options.requests` positioned reads from each of
+ * `options.pread_threads` threads, once with standard and once with short
+ * circuit reads, and prints the latency distribution per request size.
+ */
+void run_pread(options_t &options) {
+    static const char *read_types[] = {"standard", "scr"};
+
+    for (unsigned short_circuit = 0; short_circuit < 2; short_circuit++) {
+        hdfsFS fs = connect_hdfs(options, short_circuit);
+
+        hdfsFileInfo *fileInfo = hdfsGetPathInfo(fs, options.path);
+        EXPECT_NONZERO(fileInfo, "hdfsGetPathInfo")
+        tOffset file_size = fileInfo->mSize;
+        hdfsFreeFileInfo(fileInfo, 1);
+
+        // The zipf pattern picks among slots as large as the largest request
+        size_t max_size = *max_element(options.pread_sizes.begin(), options.pread_sizes.end());
+        uint64_t slots = max((tOffset) 1, file_size / (tOffset) max_size);
+        ZipfGenerator zipf(slots, options.zipf_theta);
+
+        vector<pread_result_t> results(options.pread_threads);
+        vector<thread> threads;
+
+        uint64_t start = now_ns();
+        for (unsigned i = 0; i < options.pread_threads; i++) {
+            threads.push_back(thread(pread_thread, ref(options), fs, file_size, &zipf, slots, i, ref(results[i])));
+        }
+        for (auto &t : threads) {
+            t.join();
+        }
+        uint64_t end = now_ns();
+
+        pread_result_t total;
+        for (auto &result : results) {
+            for (auto &latency : result.latencies) {
+                total.latencies[latency.first].merge(latency.second);
+            }
+            total.bytes += result.bytes;
+        }
+
+        double seconds = (end - start) / 1e9;
+        if (options.verbose) {
+            printf("%s: %u threads, %s pattern, %lu requests, %f MB with %lfMB/s\n", read_types[short_circuit],
+                   options.pread_threads, pattern_s[options.pattern],
+                   (unsigned long) options.requests * options.pread_threads,
+                   total.bytes / (1024.0 * 1024.0), total.bytes / (1024.0 * 1024.0) / seconds);
+            printf("%-8s %10s %8s %10s %10s %10s %10s %10s %10s %10s (us)\n", "type", "size", "count",
+                   "min", "mean", "p50", "p90", "p99", "p99.9", "max");
+        }
+        for (auto &latency : total.latencies) {
+            LatencyHistogram &h = latency.second;
+            printf("%-8s %10lu %8lu %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", read_types[short_circuit],
+                   (unsigned long) latency.first, (unsigned long) h.getCount(), h.getMin() / 1000.0,
+                   h.mean() / 1000.0, h.percentile(0.5) / 1000.0, h.percentile(0.9) / 1000.0,
+                   h.percentile(0.99) / 1000.0, h.percentile(0.999) / 1000.0, h.getMax() / 1000.0);
+            if (options.verbose) {
+                h.print(stdout);
+            }
+        }
+
+        hdfsDisconnect(fs);
+    }
+}
+
+#endif //HDFS_BENCHMARK_PREAD_H
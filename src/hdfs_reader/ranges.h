@@ -0,0 +1,109 @@
+#ifndef HDFS_BENCHMARK_RANGES_H
+#define HDFS_BENCHMARK_RANGES_H
+
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "common.h"
+
+using namespace std;
+
+struct range_t {
+    tOffset start;
+    tOffset end;
+    uint64_t ns = 0;
+    // Read statistics of the range's file handle
+    uint64_t bytes_total = 0;
+    uint64_t bytes_local = 0;
+    uint64_t bytes_short_circuit = 0;
+    uint64_t bytes_zero_copy = 0;
+};
+
+/**
+ * Splits `[0, file_size)` into `jobs` ranges. Boundaries are aligned to the
+ * HDFS block size if every range spans at least one block, so that threads
+ * read from different blocks, and to `alignment` otherwise.
+ */
+vector<range_t> split_ranges(tOffset file_size, tOffset block_size, size_t alignment, unsigned jobs) {
+    tOffset range_size = (file_size + jobs - 1) / jobs;
+    tOffset align = (block_size > 0 && range_size >= block_size) ? block_size : max((tOffset) alignment, (tOffset) 1);
+    range_size = ((range_size + align - 1) / align) * align;
+
+    vector<range_t> ranges;
+    for (tOffset start = 0; start < file_size; start += range_size) {
+        range_t range;
+        range.start = start;
+        range.end = min(start + range_size, file_size);
+        ranges.push_back(range);
+    }
+    return ranges;
+}
+
+void read_range(options_t &options, hdfsFS fs, range_t &range) {
+    uint64_t start = now_ns();
+
+    hdfsFile file = hdfsOpenFile(fs, options.path, O_RDONLY, options.buffer_size, 0, 0);
+    EXPECT_NONZERO(file, "hdfsOpenFile")
+
+    char *buffer = (char *) malloc(sizeof(char) * options.buffer_size);
+    tOffset offset = range.start;
+    while (offset < range.end) {
+        tSize length = (tSize) min((tOffset) options.buffer_size, range.end - offset);
+        tSize read = hdfsPread(fs, file, offset, buffer, length);
+        EXPECT_NONNEGATIVE(read, "hdfsPread")
+        if (read == 0) {
+            fprintf(stderr, "Unexpected end of file at offset %ld\n", (long) offset);
+            exit(1);
+        }
+
+        useData(buffer, read);
+        offset += read;
+    }
+
+    free(buffer);
+
+#ifdef HAS_LIBHDFS
+    if (options.verbose) {
+        struct hdfsReadStatistics *stats;
+        hdfsFileGetReadStatistics(file, &stats);
+        range.bytes_total = stats->totalBytesRead;
+        range.bytes_local = stats->totalLocalBytesRead;
+        range.bytes_short_circuit = stats->totalShortCircuitBytesRead;
+        range.bytes_zero_copy = stats->totalZeroCopyBytesRead;
+        hdfsFileFreeReadStatistics(stats);
+    }
+#endif
+    hdfsCloseFile(fs, file);
+
+    range.ns = now_ns() - start;
+}
+
+/**
+ * Reads the file with `options.jobs` threads, each reading one contiguous
+ * range through its own `hdfsFile` handle with `hdfsPread`. Prints the
+ * throughput of each thread and returns the ranges.
+ */
+vector<range_t> readHdfsRanges(options_t &options, hdfsFS fs, hdfsFileInfo *fileInfo) {
+    vector<range_t> ranges = split_ranges(fileInfo->mSize, fileInfo->mBlockSize, options.buffer_size, options.jobs);
+
+    vector<thread> threads;
+    for (auto &range : ranges) {
+        threads.push_back(thread(read_range, ref(options), fs, ref(range)));
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    if (options.verbose) {
+        for (unsigned i = 0; i < ranges.size(); i++) {
+            double mb = (ranges[i].end - ranges[i].start) / (1024.0 * 1024.0);
+            printf("Thread %u: [%ld, %ld) %f MB with %lfMB/s\n", i, (long) ranges[i].start, (long) ranges[i].end,
+                   mb, mb / (ranges[i].ns / 1e9));
+        }
+        cout << "Performed Standard/SCR with " << ranges.size() << " ranges" << endl;
+    }
+    return ranges;
+}
+
+#endif //HDFS_BENCHMARK_RANGES_H
@@ -0,0 +1,169 @@
+#ifndef HDFS_BENCHMARK_TREE_H
+#define HDFS_BENCHMARK_TREE_H
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common.h"
+#include "../queries/Histogram.h"
+
+using namespace std;
+
+typedef enum {
+    phase_list = 0, phase_path_info, phase_hosts, phase_open, phase_read, phase_close, phase_count
+} phase_t;
+
+static const char *phase_s[] = {
+        "list", "getPathInfo", "getHosts", "open", "read", "close"
+};
+
+struct tree_result_t {
+    LatencyHistogram phases[phase_t::phase_count];
+    uint64_t files = 0;
+    uint64_t bytes = 0;
+};
+
+/**
+ * Lists `path` recursively, appending all files to `files`. Every
+ * `hdfsListDirectory` call is recorded in `result`.
+ */
+void list_tree(hdfsFS fs, const char *path, vector<string> &files, tree_result_t &result) {
+    int entries = 0;
+    uint64_t start = now_ns();
+    errno = 0;
+    hdfsFileInfo *fileInfos = hdfsListDirectory(fs, path, &entries);
+    result.phases[phase_t::phase_list].record(now_ns() - start);
+    if (fileInfos == NULL) {
+        // Empty directories are reported as NULL with errno 0
+        if (errno != 0) {
+            fprintf(stderr, "hdfsListDirectory failed: %s\n", strerror(errno));
+            exit(1);
+        }
+        return;
+    }
+
+    for (int i = 0; i < entries; i++) {
+        if (fileInfos[i].mKind == tObjectKind::kObjectKindDirectory) {
+            list_tree(fs, fileInfos[i].mName, files, result);
+        } else {
+            files.push_back(fileInfos[i].mName);
+        }
+    }
+    hdfsFreeFileInfo(fileInfos, entries);
+}
+
+void read_tree_files(options_t &options, hdfsFS fs, vector<string> &files, atomic<size_t> &next,
+                     tree_result_t &result) {
+    char *buffer = (char *) malloc(sizeof(char) * options.buffer_size);
+
+    for (size_t idx = next++; idx < files.size(); idx = next++) {
+        const char *path = files[idx].c_str();
+
+        uint64_t t0 = now_ns();
+        hdfsFileInfo *fileInfo = hdfsGetPathInfo(fs, path);
+        EXPECT_NONZERO(fileInfo, "hdfsGetPathInfo")
+        uint64_t t1 = now_ns();
+        char ***blockHosts = hdfsGetHosts(fs, path, 0, fileInfo->mSize);
+        uint64_t t2 = now_ns();
+        hdfsFile file = hdfsOpenFile(fs, path, O_RDONLY, options.buffer_size, 0, 0);
+        EXPECT_NONZERO(file, "hdfsOpenFile")
+        uint64_t t3 = now_ns();
+
+        tSize read = 0;
+        do {
+            read = hdfsRead(fs, file, buffer, options.buffer_size);
+            EXPECT_NONNEGATIVE(read, "hdfsRead")
+            if (read > 0) {
+                useData(buffer, read);
+            }
+            result.bytes += read;
+        } while (read > 0);
+        uint64_t t4 = now_ns();
+
+        hdfsCloseFile(fs, file);
+        uint64_t t5 = now_ns();
+
+        result.phases[phase_t::phase_path_info].record(t1 - t0);
+        result.phases[phase_t::phase_hosts].record(t2 - t1);
+        result.phases[phase_t::phase_open].record(t3 - t2);
+        result.phases[phase_t::phase_read].record(t4 - t3);
+        result.phases[phase_t::phase_close].record(t5 - t4);
+        result.files++;
+
+        // Empty files have no blocks and no hosts
+        if (blockHosts != NULL) {
+            hdfsFreeHosts(blockHosts);
+        }
+        hdfsFreeFileInfo(fileInfo, 1);
+    }
+
+    free(buffer);
+}
+
+/**
+ * Lists the directory tree at `options.path` and reads every file in it,
+ * `options.jobs` files at a time. Reports the time spent in each namenode
+ * and datanode operation, and the rate of files read.
+ */
+void run_tree(options_t &options) {
+    hdfsFS fs = connect_hdfs(options, options.type != type_t::standard);
+
+    uint64_t start = now_ns();
+
+    vector<string> files;
+    tree_result_t total;
+    list_tree(fs, options.path, files, total);
+
+    vector<tree_result_t> results(options.jobs);
+    vector<thread> threads;
+    atomic<size_t> next(0);
+    for (unsigned i = 0; i < options.jobs; i++) {
+        threads.push_back(thread(read_tree_files, ref(options), fs, ref(files), ref(next), ref(results[i])));
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    double seconds = (now_ns() - start) / 1e9;
+
+    for (auto &result : results) {
+        for (unsigned p = 0; p < phase_t::phase_count; p++) {
+            total.phases[p].merge(result.phases[p]);
+        }
+        total.files += result.files;
+        total.bytes += result.bytes;
+    }
+
+    double phase_total = 0;
+    for (unsigned p = 0; p < phase_t::phase_count; p++) {
+        phase_total += total.phases[p].getSum();
+    }
+
+    if (options.verbose) {
+        printf("Read %lu files (%f MB) with %u jobs in %f s: %f files/s, %lfMB/s\n", (unsigned long) total.files,
+               total.bytes / (1024.0 * 1024.0), options.jobs, seconds, total.files / seconds,
+               total.bytes / (1024.0 * 1024.0) / seconds);
+        printf("%-12s %8s %12s %7s %10s %10s %10s\n", "phase", "calls", "total (ms)", "share", "mean (us)",
+               "p50 (us)", "p99 (us)");
+        for (unsigned p = 0; p < phase_t::phase_count; p++) {
+            LatencyHistogram &h = total.phases[p];
+            double ms = h.getSum() / 1e6;
+            printf("%-12s %8lu %12.1f %6.1f%% %10.1f %10.1f %10.1f\n", phase_s[p], (unsigned long) h.getCount(),
+                   ms, phase_total > 0 ? 100.0 * ms * 1e6 / phase_total : 0, h.mean() / 1000.0,
+                   h.percentile(0.5) / 1000.0, h.percentile(0.99) / 1000.0);
+        }
+    } else {
+        // files/s, then the total milliseconds spent in each phase
+        printf("%f", total.files / seconds);
+        for (unsigned p = 0; p < phase_t::phase_count; p++) {
+            printf(" %f", total.phases[p].getSum() / 1e6);
+        }
+        printf("\n");
+    }
+
+    hdfsDisconnect(fs);
+}
+
+#endif //HDFS_BENCHMARK_TREE_H
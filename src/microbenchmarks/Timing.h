@@ -0,0 +1,37 @@
+#ifndef HDFS_BENCHMARK_TIMING_H
+#define HDFS_BENCHMARK_TIMING_H
+
+#include <chrono>
+
+/**
+ * Timing helpers shared by the microbenchmarks.
+ */
+namespace timing {
+    /**
+     * The shortest of `runs` runs of `f()` in ns. `setup()` runs before
+     * every run and is not timed, e.g. to restore input that `f()` consumes.
+     */
+    template<typename Setup, typename F>
+    double bestOf(unsigned runs, Setup setup, F f) {
+        double best = 0;
+        for (unsigned run = 0; run < runs; run++) {
+            setup();
+            auto start = std::chrono::high_resolution_clock::now();
+            f();
+            auto stop = std::chrono::high_resolution_clock::now();
+            double ns = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+            if (run == 0 || ns < best) {
+                best = ns;
+            }
+        }
+        return best;
+    }
+
+    template<typename F>
+    double bestOf(unsigned runs, F f) {
+        return bestOf(runs, []() {
+        }, f);
+    }
+}
+
+#endif //HDFS_BENCHMARK_TIMING_H
@@ -0,0 +1,89 @@
+#include <iostream>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <new>
+#include <vector>
+
+#include "../queries/ParquetFile.h"
+
+using namespace std;
+
+// Heap allocations per row group when reading all INT32, INT64, FLOAT, DOUBLE
+// and BYTE_ARRAY columns of a local Parquet file with readBatch(), counted by
+// replacing the global operator new. The first pass warms up the readers'
+// buffers; in later passes readers reuse the states released to the
+// thread's ReaderPool and should not allocate at all.
+
+static atomic<uint64_t> allocations(0);
+
+void *operator new(size_t size) {
+    allocations++;
+    if (void *p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+template<typename T>
+static void readColumn(benchmark::RowGroup &rowGroup, unsigned col, vector<T> &values) {
+    auto reader = rowGroup.getColumn(col).getReader();
+    while (reader.readBatch(values.data(), values.size())) {
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        cerr << "usage: " << argv[0] << " FILE [PASSES]" << endl;
+        return 1;
+    }
+    unsigned passes = argc > 2 ? atoi(argv[2]) : 5;
+
+    ifstream in(argv[1], ios::binary);
+    vector<uint8_t> data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    ParquetFile file(data.data(), data.size());
+    auto &schema = file.getFileMetaData()->schema;
+
+    vector<int32_t> int32s(BATCH_SIZE);
+    vector<int64_t> int64s(BATCH_SIZE);
+    vector<float> floats(BATCH_SIZE);
+    vector<double> doubles(BATCH_SIZE);
+    vector<ByteArray> byteArrays(BATCH_SIZE);
+
+    cout << fixed << setprecision(2);
+    for (unsigned pass = 1; pass <= passes; pass++) {
+        uint64_t before = allocations;
+        for (auto &rowGroup : file.getRowGroups()) {
+            for (unsigned col = 0; col < rowGroup.getNumberOfColumns(); col++) {
+                switch (schema[col + 1].type) {
+                    case Type::INT32:
+                        readColumn(rowGroup, col, int32s);
+                        break;
+                    case Type::INT64:
+                        readColumn(rowGroup, col, int64s);
+                        break;
+                    case Type::FLOAT:
+                        readColumn(rowGroup, col, floats);
+                        break;
+                    case Type::DOUBLE:
+                        readColumn(rowGroup, col, doubles);
+                        break;
+                    case Type::BYTE_ARRAY:
+                        readColumn(rowGroup, col, byteArrays);
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+        uint64_t count = allocations - before;
+        cout << "pass " << pass << ": " << setw(8) << count << " allocations, " << setw(10)
+             << count / (double) file.getRowGroups().size() << " per row group" << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+
+#include "../queries/ParquetFile.h"
+#include "Timing.h"
+
+using namespace std;
+
+// Decode throughput of ColumnChunk::Reader::read<T>() (one ColumnReader call
+// per value) compared to readBatch<T>() for the first INT32, INT64, DOUBLE and
+// BYTE_ARRAY column of a local Parquet file, e.g. a lineitem file.
+
+static const unsigned RUNS = 5;
+
+template<typename T>
+static uint64_t checksum(const T &v) {
+    return static_cast<uint64_t>(v);
+}
+
+static uint64_t checksum(const ByteArray &v) {
+    return v.len;
+}
+
+template<typename T>
+static void compare(ParquetFile &file, unsigned col, const char *type, size_t batchSize) {
+    uint64_t rows = file.getFileMetaData()->num_rows;
+    uint64_t perRowSum = 0, batchSum = 0;
+
+    double perRow = timing::bestOf(RUNS, [&]() {
+        perRowSum = 0;
+        for (auto &rowGroup : file.getRowGroups()) {
+            auto reader = rowGroup.getColumn(col).getReader();
+            while (reader.hasNext()) {
+                perRowSum += checksum(reader.read<T>());
+            }
+        }
+    });
+
+    vector<T> values(batchSize);
+    double batch = timing::bestOf(RUNS, [&]() {
+        batchSum = 0;
+        for (auto &rowGroup : file.getRowGroups()) {
+            auto reader = rowGroup.getColumn(col).getReader();
+            while (size_t n = reader.readBatch(values.data(), batchSize)) {
+                for (size_t i = 0; i < n; i++) {
+                    batchSum += checksum(values[i]);
+                }
+            }
+        }
+    });
+
+    if (perRowSum != batchSum) {
+        cerr << file.getFileMetaData()->schema[col + 1].name << ": checksums differ" << endl;
+        exit(1);
+    }
+
+    cout << left << setw(12) << type << setw(20) << file.getFileMetaData()->schema[col + 1].name << right
+         << fixed << setprecision(2)
+         << setw(12) << perRow / rows << " ns/value"
+         << setw(12) << batch / rows << " ns/value"
+         << setw(10) << perRow / batch << "x" << endl;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        cout << "Usage: " << argv[0] << " PARQUET-FILE [BATCH-SIZE]" << endl;
+        exit(1);
+    }
+    size_t batchSize = argc > 2 ? atoi(argv[2]) : BATCH_SIZE;
+
+    ifstream in(argv[1], ios::binary);
+    vector<uint8_t> buffer((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    ParquetFile file(buffer.data(), buffer.size());
+
+    cout << left << setw(12) << "type" << setw(20) << "column" << right
+         << setw(21) << "read<T>()" << setw(21) << "readBatch()" << setw(11) << "speedup" << endl;
+
+    bool done[4] = {false, false, false, false};
+    auto &schema = file.getFileMetaData()->schema;
+    for (unsigned col = 0; col + 1 < schema.size(); col++) {
+        switch (schema[col + 1].type) {
+            case Type::INT32:
+                if (!done[0]) compare<int32_t>(file, col, "INT32", batchSize);
+                done[0] = true;
+                break;
+            case Type::INT64:
+                if (!done[1]) compare<int64_t>(file, col, "INT64", batchSize);
+                done[1] = true;
+                break;
+            case Type::DOUBLE:
+                if (!done[2]) compare<double>(file, col, "DOUBLE", batchSize);
+                done[2] = true;
+                break;
+            case Type::BYTE_ARRAY:
+                if (!done[3]) compare<ByteArray>(file, col, "BYTE_ARRAY", batchSize);
+                done[3] = true;
+                break;
+            default:
+                break;
+        }
+    }
+
+    return 0;
+}
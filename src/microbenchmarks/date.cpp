@@ -0,0 +1,85 @@
+#include <iostream>
+#include <chrono>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+#include <stdio.h>
+
+#include "../queries/Date.h"
+
+using namespace std;
+using namespace benchmark;
+
+// Cost per value of parsing `YYYY-MM-DD` byte arrays as the queries used to
+// (copy to a terminated string and sscanf), value by value with parseDate()
+// and in batches with parseDates().
+
+static const size_t VALUES = 1 << 20;
+static const unsigned RUNS = 5;
+
+template<typename F>
+static double nsPerValue(F f) {
+    double best = 0;
+    for (unsigned run = 0; run < RUNS; run++) {
+        auto start = chrono::high_resolution_clock::now();
+        f();
+        auto stop = chrono::high_resolution_clock::now();
+        double ns = chrono::duration_cast<chrono::nanoseconds>(stop - start).count();
+        if (run == 0 || ns < best) {
+            best = ns;
+        }
+    }
+    return best / VALUES;
+}
+
+int main(int argc, char **argv) {
+    // Dates laid out as in a PLAIN encoded page: 4 byte length, then the value
+    vector<uint8_t> page(VALUES * 14);
+    vector<ByteArray> values(VALUES);
+    mt19937 random(42);
+    uniform_int_distribution<int> year(1992, 1998), month(1, 12), day(1, 28);
+    for (size_t i = 0; i < VALUES; i++) {
+        uint8_t *value = page.data() + i * 14;
+        *reinterpret_cast<uint32_t *>(value) = 10;
+        char date[11];
+        snprintf(date, sizeof(date), "%04d-%02d-%02d", year(random), month(random), day(random));
+        memcpy(value + 4, date, 10);
+        values[i].len = 10;
+        values[i].ptr = value + 4;
+    }
+
+    vector<Date> expected(VALUES), dates(VALUES);
+    double scanf = nsPerValue([&]() {
+        char str[11];
+        for (size_t i = 0; i < VALUES; i++) {
+            memcpy(str, values[i].ptr, 10);
+            str[10] = 0;
+            int a = 0, b = 0, c = 0;
+            sscanf(str, "%d-%d-%d", &a, &b, &c);
+            expected[i].value = (a * 10000) + (b * 100) + c;
+        }
+    });
+    double scalar = nsPerValue([&]() {
+        for (size_t i = 0; i < VALUES; i++) {
+            dates[i] = parseDate(values[i]);
+        }
+    });
+    double batch = nsPerValue([&]() {
+        parseDates(values.data(), dates.data(), VALUES);
+    });
+
+    for (size_t i = 0; i < VALUES; i++) {
+        if (dates[i].value != expected[i].value) {
+            cerr << "value " << i << ": " << dates[i].value << " != " << expected[i].value << endl;
+            return 1;
+        }
+    }
+
+    cout << fixed << setprecision(2);
+    cout << "sscanf       " << scanf << " ns/value" << endl;
+    cout << "parseDate()  " << scalar << " ns/value" << endl;
+    cout << "parseDates() " << batch << " ns/value" << endl;
+
+    return 0;
+}
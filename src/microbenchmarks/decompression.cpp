@@ -0,0 +1,151 @@
+#include <iostream>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <snappy.h>
+#include <zlib.h>
+
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#endif
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "../queries/Arena.h"
+#include "../queries/Compression.h"
+
+using namespace std;
+using namespace benchmark;
+
+// Decompression throughput of `decompress()` per codec on pages resembling
+// lineitem columns: PLAIN encoded ascending keys, prices and dates.
+
+static const size_t PAGE_SIZE = 1 << 20;
+static const size_t PAGES = 64;
+static const unsigned RUNS = 5;
+
+static vector<uint8_t> makePage(mt19937 &random, unsigned kind) {
+    vector<uint8_t> page(PAGE_SIZE);
+    uniform_int_distribution<int> step(0, 3), price(90000, 10500000), year(1992, 1998), month(1, 12), day(1, 28);
+    static int32_t key = 0;
+    for (size_t i = 0; i + 14 <= PAGE_SIZE;) {
+        switch (kind % 3) {
+            case 0:
+                key += step(random);
+                memcpy(&page[i], &key, 4);
+                i += 4;
+                break;
+            case 1: {
+                double value = price(random) / 100.0;
+                memcpy(&page[i], &value, 8);
+                i += 8;
+                break;
+            }
+            default: {
+                uint32_t length = 10;
+                char date[11];
+                snprintf(date, sizeof(date), "%04d-%02d-%02d", year(random), month(random), day(random));
+                memcpy(&page[i], &length, 4);
+                memcpy(&page[i + 4], date, 10);
+                i += 14;
+                break;
+            }
+        }
+    }
+    return page;
+}
+
+struct Codec {
+    int codec;
+    function<vector<uint8_t>(const vector<uint8_t> &)> compress;
+};
+
+int main(int argc, char **argv) {
+    mt19937 random(42);
+    vector<vector<uint8_t>> pages;
+    for (size_t i = 0; i < PAGES; i++) {
+        pages.push_back(makePage(random, i));
+    }
+
+    vector<Codec> codecs;
+    codecs.push_back({parquet::CompressionCodec::SNAPPY, [](const vector<uint8_t> &page) {
+        string out;
+        snappy::Compress(reinterpret_cast<const char *>(page.data()), page.size(), &out);
+        return vector<uint8_t>(out.begin(), out.end());
+    }});
+    codecs.push_back({parquet::CompressionCodec::GZIP, [](const vector<uint8_t> &page) {
+        uLongf length = compressBound(page.size());
+        vector<uint8_t> out(length);
+        compress2(out.data(), &length, page.data(), page.size(), Z_DEFAULT_COMPRESSION);
+        out.resize(length);
+        return out;
+    }});
+#ifdef HAVE_LZ4
+    codecs.push_back({CODEC_LZ4, [](const vector<uint8_t> &page) {
+        vector<uint8_t> out(LZ4_compressBound(page.size()));
+        int length = LZ4_compress_default(reinterpret_cast<const char *>(page.data()),
+                                          reinterpret_cast<char *>(out.data()), page.size(), out.size());
+        out.resize(length);
+        return out;
+    }});
+#endif
+#ifdef HAVE_ZSTD
+    codecs.push_back({CODEC_ZSTD, [](const vector<uint8_t> &page) {
+        vector<uint8_t> out(ZSTD_compressBound(page.size()));
+        out.resize(ZSTD_compress(out.data(), out.size(), page.data(), page.size(), 1));
+        return out;
+    }});
+#endif
+
+    cout << fixed << setprecision(1);
+    Arena arena;
+    for (auto &codec : codecs) {
+        vector<vector<uint8_t>> compressed;
+        size_t compressedSize = 0;
+        for (auto &page : pages) {
+            compressed.push_back(codec.compress(page));
+            compressedSize += compressed.back().size();
+        }
+
+        double best = 0;
+        for (unsigned run = 0; run < RUNS; run++) {
+            arena.reset();
+            auto start = chrono::high_resolution_clock::now();
+            for (size_t i = 0; i < PAGES; i++) {
+                uint8_t *out = arena.allocate(PAGE_SIZE);
+                decompress((parquet::CompressionCodec::type) codec.codec, compressed[i].data(),
+                           compressed[i].size(), out, PAGE_SIZE);
+            }
+            auto stop = chrono::high_resolution_clock::now();
+            double seconds = chrono::duration_cast<chrono::nanoseconds>(stop - start).count() / 1e9;
+            if (run == 0 || seconds < best) {
+                best = seconds;
+            }
+
+            for (size_t i = 0; i < PAGES && run == 0; i++) {
+                uint8_t *out = arena.allocate(PAGE_SIZE);
+                decompress((parquet::CompressionCodec::type) codec.codec, compressed[i].data(),
+                           compressed[i].size(), out, PAGE_SIZE);
+                if (memcmp(out, pages[i].data(), PAGE_SIZE) != 0) {
+                    cerr << codecName(codec.codec) << ": page " << i << " differs" << endl;
+                    return 1;
+                }
+            }
+        }
+
+        cout << setw(8) << left << codecName(codec.codec) << " ratio " << setw(5) << right
+             << PAGES * PAGE_SIZE / (double) compressedSize << "  " << setw(7)
+             << PAGES * PAGE_SIZE / (1024.0 * 1024.0) / best << " MB/s" << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+#include <stdlib.h>
+
+#include "../queries/HashJoin.h"
+#include "Timing.h"
+
+using namespace std;
+using namespace benchmark;
+
+// Builds the join index of q14's l_partkey from tuples that the workers of
+// a MorselPool collected, with each HashBuild strategy and 1 to 32 threads,
+// and the CsrIndex that q14 uses by default.
+// By default the tuples are those of q14 at scale factor 100: 7738727
+// lineitems of September 1995 with part keys out of 20000000.
+
+static const unsigned RUNS = 5;
+
+int main(int argc, char **argv) {
+    size_t tupleCount = argc > 1 ? atol(argv[1]) : 7738727;
+    unsigned keyCount = argc > 2 ? atoi(argv[2]) : 20000000;
+    unsigned maxThreads = argc > 3 ? atoi(argv[3]) : 32;
+    if (tupleCount == 0 || keyCount == 0 || maxThreads == 0) {
+        cerr << "usage: " << argv[0] << " [TUPLES] [KEYS] [MAX-THREADS]" << endl;
+        return 1;
+    }
+
+    mt19937_64 random(42);
+    uniform_int_distribution<int32_t> keys(1, keyCount);
+    vector<pair<int32_t, uint64_t>> tuples(tupleCount);
+    uint64_t checksum = 0;
+    for (size_t i = 0; i < tupleCount; i++) {
+        tuples[i] = make_pair(keys(random), i);
+        checksum += i;
+    }
+
+    const HashBuild builds[] = {HashBuild::SERIAL, HashBuild::MUTEX, HashBuild::PARTITIONED, HashBuild::CAS};
+    cout << tupleCount << " tuples, " << keyCount << " keys, ms (M tuples/s)" << endl;
+    cout << "threads";
+    for (HashBuild build : builds) {
+        cout << setw(20) << hashBuildName(build);
+    }
+    cout << setw(20) << "csr" << endl;
+
+    cout << fixed << setprecision(1);
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        MorselPool pool(threads);
+        PerWorker<vector<pair<int32_t, uint64_t>>> collected(pool);
+        for (unsigned w = 0; w < threads; w++) {
+            collected[w].assign(tuples.begin() + tupleCount * w / threads,
+                                tuples.begin() + tupleCount * (w + 1) / threads);
+        }
+
+        cout << setw(7) << threads;
+        for (HashBuild build : builds) {
+            unique_ptr<JoinIndex<uint64_t>> index;
+            double ns = timing::bestOf(RUNS, [&]() {
+                index = buildJoinIndex(pool, collected, build);
+            });
+
+            // Every tuple is found through its key exactly once
+            uint64_t sum = 0;
+            for (unsigned key = 1; key <= keyCount; key++) {
+                for (uint32_t t = index->find(key); t != NO_ENTRY; t = index->next(t)) {
+                    sum += index->value(t);
+                }
+            }
+            if (sum != checksum) {
+                cerr << hashBuildName(build) << " build lost tuples" << endl;
+                return 1;
+            }
+
+            cout << setw(11) << ns / 1e6 << " (" << setw(5) << tupleCount / (ns / 1e3) << ")";
+        }
+
+        unique_ptr<CsrIndex<uint64_t>> csr;
+        double ns = timing::bestOf(RUNS, [&]() {
+            csr = buildCsrIndex(pool, collected);
+        });
+        uint64_t sum = 0;
+        for (unsigned key = 1; key <= keyCount; key++) {
+            if (auto range = csr->ranges.find(key)) {
+                for (uint32_t t = range->begin; t < range->end; t++) {
+                    sum += csr->values[t];
+                }
+            }
+        }
+        if (sum != checksum) {
+            cerr << "csr build lost tuples" << endl;
+            return 1;
+        }
+        cout << setw(11) << ns / 1e6 << " (" << setw(5) << tupleCount / (ns / 1e3) << ")" << endl;
+    }
+    return 0;
+}
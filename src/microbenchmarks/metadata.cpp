@@ -0,0 +1,147 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stdlib.h>
+
+#include <boost/shared_ptr.hpp>
+#include <thrift/protocol/TCompactProtocol.h>
+#include <thrift/transport/TBufferTransports.h>
+
+#include "../queries/ParquetFile.h"
+#include "Timing.h"
+
+using namespace std;
+using namespace apache::thrift::protocol;
+using namespace apache::thrift::transport;
+
+// Cost of opening a Parquet file with many row groups and columns: parsing
+// the footer, building the row group views, and deep-copying the row groups
+// as RowGroup used to. The file only consists of the footer.
+
+static const unsigned RUNS = 20;
+
+static vector<uint8_t> makeFile(unsigned rowGroupCount, unsigned columnCount) {
+    FileMetaData metaData;
+    metaData.version = 1;
+    metaData.num_rows = 0;
+
+    SchemaElement root;
+    root.name = "schema";
+    root.num_children = columnCount;
+    root.__isset.num_children = true;
+    metaData.schema.push_back(root);
+    for (unsigned col = 0; col < columnCount; col++) {
+        SchemaElement column;
+        column.name = "column_" + to_string(col);
+        column.type = Type::INT64;
+        column.__isset.type = true;
+        column.repetition_type = FieldRepetitionType::REQUIRED;
+        column.__isset.repetition_type = true;
+        metaData.schema.push_back(column);
+    }
+
+    int64_t offset = 4;
+    for (unsigned i = 0; i < rowGroupCount; i++) {
+        parquet::RowGroup rowGroup;
+        rowGroup.num_rows = 100000;
+        rowGroup.total_byte_size = 0;
+        for (unsigned col = 0; col < columnCount; col++) {
+            parquet::ColumnChunk chunk;
+            chunk.file_offset = offset;
+            ColumnMetaData &columnMetaData = chunk.meta_data;
+            columnMetaData.type = Type::INT64;
+            columnMetaData.encodings.push_back(Encoding::PLAIN);
+            columnMetaData.path_in_schema.push_back(metaData.schema[col + 1].name);
+            columnMetaData.codec = CompressionCodec::SNAPPY;
+            columnMetaData.num_values = rowGroup.num_rows;
+            columnMetaData.total_uncompressed_size = 8 * rowGroup.num_rows;
+            columnMetaData.total_compressed_size = 4 * rowGroup.num_rows;
+            columnMetaData.data_page_offset = offset;
+            int64_t min = i * rowGroup.num_rows, max = min + rowGroup.num_rows - 1;
+            columnMetaData.statistics.min = string(reinterpret_cast<const char *>(&min), 8);
+            columnMetaData.statistics.max = string(reinterpret_cast<const char *>(&max), 8);
+            columnMetaData.statistics.__isset.min = true;
+            columnMetaData.statistics.__isset.max = true;
+            columnMetaData.__isset.statistics = true;
+            chunk.__isset.meta_data = true;
+            offset += columnMetaData.total_compressed_size;
+            rowGroup.total_byte_size += columnMetaData.total_uncompressed_size;
+            rowGroup.columns.push_back(chunk);
+        }
+        metaData.num_rows += rowGroup.num_rows;
+        metaData.row_groups.push_back(rowGroup);
+    }
+
+    boost::shared_ptr<TMemoryBuffer> buffer(new TMemoryBuffer());
+    TCompactProtocolFactoryT<TMemoryBuffer> factory;
+    boost::shared_ptr<TProtocol> protocol = factory.getProtocol(buffer);
+    metaData.write(protocol.get());
+    uint8_t *footer;
+    uint32_t footerLength;
+    buffer->getBuffer(&footer, &footerLength);
+
+    vector<uint8_t> file(PARQUET_MAGIC, PARQUET_MAGIC + 4);
+    file.insert(file.end(), footer, footer + footerLength);
+    file.insert(file.end(), reinterpret_cast<uint8_t *>(&footerLength), reinterpret_cast<uint8_t *>(&footerLength) + 4);
+    file.insert(file.end(), PARQUET_MAGIC, PARQUET_MAGIC + 4);
+    return file;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        cerr << "usage: " << argv[0] << " ROW-GROUPS COLUMNS [THREADS]" << endl;
+        return 1;
+    }
+    unsigned rowGroupCount = atoi(argv[1]), columnCount = atoi(argv[2]);
+    unsigned threadCount = argc > 3 ? atoi(argv[3]) : thread::hardware_concurrency();
+
+    vector<uint8_t> data = makeFile(rowGroupCount, columnCount);
+
+    double deserialize = timing::bestOf(RUNS, [&]() {
+        FileMetaData metaData;
+        uint32_t length = *reinterpret_cast<const uint32_t *>(&data[data.size() - FOOTER_SIZE]);
+        DeserializeThriftMsg(&data[data.size() - FOOTER_SIZE - length], &length, &metaData);
+    });
+    double open = timing::bestOf(RUNS, [&]() {
+        ParquetFile file(data.data(), data.size());
+    });
+
+    ParquetFile file(data.data(), data.size());
+    double copy = timing::bestOf(RUNS, [&]() {
+        vector<parquet::RowGroup> rowGroups;
+        for (auto &rowGroup : file.getFileMetaData()->row_groups) {
+            rowGroups.push_back(rowGroup);
+        }
+    });
+
+    // Many threads asking for the columns of the same row groups
+    double columns = timing::bestOf(RUNS, [&]() {
+        ParquetFile file(data.data(), data.size());
+        vector<thread> threads;
+        for (unsigned t = 0; t < threadCount; t++) {
+            threads.push_back(thread([&]() {
+                for (auto &rowGroup : file.getRowGroups()) {
+                    if (rowGroup.allColumns().size() != columnCount) {
+                        cerr << "allColumns() returned a wrong number of columns" << endl;
+                        exit(1);
+                    }
+                }
+            }));
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    });
+
+    cout << rowGroupCount << " row groups, " << columnCount << " columns, footer "
+         << fixed << setprecision(1) << data.size() / 1024.0 << " KB" << endl;
+    cout << setprecision(1)
+         << "deserialize footer  " << setw(10) << deserialize / 1000 << " us" << endl
+         << "open ParquetFile    " << setw(10) << open / 1000 << " us" << endl
+         << "copy row groups     " << setw(10) << copy / 1000 << " us" << endl
+         << "allColumns, " << setw(2) << threadCount << " thr " << setw(10) << columns / 1000 << " us" << endl;
+    return 0;
+}
@@ -0,0 +1,552 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <stdlib.h>
+
+#include "../queries/HashJoin.h"
+#include "../queries/Operators.h"
+#include "../queries/Pipeline.h"
+#include "../queries/Q1.h"
+#include "../queries/Q14.h"
+#include "../queries/Q17.h"
+#include "../queries/RadixSort.h"
+#include "../queries/Tpch.h"
+#include "Timing.h"
+
+using namespace std;
+using namespace benchmark;
+
+// The work of q1, q14 and q17 after the Parquet scan, as written by hand in
+// q1.cpp, q14.cpp and q17.cpp, as composed of the operators of
+// q1_operators.cpp, q14_operators.cpp and q17_operators.cpp, and for q1 and
+// q14 as the pipelines of q1_pipeline.cpp and q14_pipeline.cpp. All
+// variants consume the same in-memory lineitem and part columns (SF 1 by
+// default: 6000000 lineitems, 200000 parts) in morsels of 65536 rows,
+// pushed in batches of BATCH_SIZE rows like a Scan does, so the difference
+// is what the composition costs, not decoding.
+
+static const unsigned RUNS = 5;
+static const size_t MORSEL_SIZE = 65536;
+
+// Ship dates are days, q1 keeps all but the last 118 days, q14 one month
+static const int32_t DAYS = 2526;
+static const int32_t Q1_MAX_SHIPDATE = DAYS - 118;
+static const int32_t Q14_MIN_SHIPDATE = 1339, Q14_MAX_SHIPDATE = 1368;
+
+static const uint8_t LETTERS[] = "AFNOR";
+static const uint8_t PROMO_TYPE[] = "PROMO BRUSHED COPPER";
+static const uint8_t OTHER_TYPE[] = "STANDARD BRUSHED COPPER";
+
+struct Lineitem {
+    vector<int32_t> partkey;
+    vector<int32_t> shipdate;
+    vector<double> quantity;
+    vector<double> extendedprice;
+    vector<double> discount;
+    vector<double> tax;
+    vector<ByteArray> returnflag;
+    vector<ByteArray> linestatus;
+    // Both also dictionary encoded, as in the Parquet files
+    vector<ByteArray> returnflagDictionary;
+    vector<ByteArray> linestatusDictionary;
+    vector<uint32_t> returnflagCode;
+    vector<uint32_t> linestatusCode;
+};
+
+struct Part {
+    vector<int32_t> partkey;
+    vector<ByteArray> type;
+    // Brand#23 and MED BOX
+    vector<uint8_t> matches;
+};
+
+static ByteArray letter(char c) {
+    ByteArray b;
+    b.len = 1;
+    b.ptr = LETTERS + (strchr((const char *) LETTERS, c) - (const char *) LETTERS);
+    return b;
+}
+
+static uint32_t code(const vector<ByteArray> &dictionary, char c) {
+    uint32_t code = 0;
+    while (dictionary[code].ptr[0] != c) {
+        code++;
+    }
+    return code;
+}
+
+static void generate(size_t rows, Lineitem &lineitem, Part &part) {
+    size_t parts = max(rows / 30, size_t(1));
+    mt19937 random(42);
+    uniform_int_distribution<int32_t> partkeys(1, parts), days(0, DAYS - 1), quantities(1, 50);
+    uniform_real_distribution<double> unit(0, 1);
+    for (char c : {'A', 'N', 'R'}) {
+        lineitem.returnflagDictionary.push_back(letter(c));
+    }
+    for (char c : {'F', 'O'}) {
+        lineitem.linestatusDictionary.push_back(letter(c));
+    }
+
+    for (size_t i = 0; i < rows; i++) {
+        int32_t quantity = quantities(random);
+        int32_t shipdate = days(random);
+        lineitem.partkey.push_back(partkeys(random));
+        lineitem.shipdate.push_back(shipdate);
+        lineitem.quantity.push_back(quantity);
+        lineitem.extendedprice.push_back(quantity * (900 + 100 * unit(random)));
+        lineitem.discount.push_back(0.01 * (int) (11 * unit(random)));
+        lineitem.tax.push_back(0.01 * (int) (9 * unit(random)));
+        // Shipped lines before the last ~3.5 years are final
+        bool open = shipdate > DAYS / 2;
+        double flag = unit(random);
+        char returnflag = open ? 'N' : flag < 0.49 ? 'A' : flag < 0.98 ? 'R' : 'N';
+        char linestatus = open ? 'O' : 'F';
+        lineitem.returnflag.push_back(letter(returnflag));
+        lineitem.linestatus.push_back(letter(linestatus));
+        lineitem.returnflagCode.push_back(code(lineitem.returnflagDictionary, returnflag));
+        lineitem.linestatusCode.push_back(code(lineitem.linestatusDictionary, linestatus));
+    }
+
+    for (size_t p = 1; p <= parts; p++) {
+        ByteArray type;
+        bool promo = unit(random) < 1.0 / 6;
+        type.ptr = promo ? PROMO_TYPE : OTHER_TYPE;
+        type.len = promo ? sizeof(PROMO_TYPE) - 1 : sizeof(OTHER_TYPE) - 1;
+        part.partkey.push_back(p);
+        part.type.push_back(type);
+        part.matches.push_back(unit(random) < 0.001);
+    }
+}
+
+/**
+ * Calls `f(worker, begin, end)` for the batches of `rows` rows on the pool,
+ * in morsels of `MORSEL_SIZE` rows and batches of up to `BATCH_SIZE` rows
+ * like a `Scan` pushes them.
+ */
+template<typename F>
+static void forEachMorsel(MorselPool &pool, size_t rows, F f) {
+    for (size_t begin = 0; begin < rows; begin += MORSEL_SIZE) {
+        pool.push([=](unsigned worker) {
+            size_t end = min(begin + MORSEL_SIZE, rows);
+            for (size_t first = begin; first < end; first += BATCH_SIZE) {
+                f(worker, first, min(first + BATCH_SIZE, end));
+            }
+        });
+    }
+    pool.wait();
+}
+
+/**
+ * The positions in [0, count) with `predicate(i)`, what a scan passes on.
+ */
+template<typename P>
+static size_t select(size_t count, uint32_t *selection, P predicate) {
+    size_t selected = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        selection[selected] = i;
+        selected += predicate(i) ? 1 : 0;
+    }
+    return selected;
+}
+
+using q1::Group;
+
+static double q1Handwritten(MorselPool &pool, const Lineitem &l) {
+    PerWorker<vector<Group>> groups(pool);
+    for (unsigned worker = 0; worker < groups.size(); worker++) {
+        groups[worker].resize(q1::GROUP_COUNT);
+    }
+    // q1.cpp looks the groups up once per row group, the dictionaries of
+    // all morsels are the same here
+    vector<uint8_t> groupIdByCode;
+    q1::groupIdsByCode(l.returnflagDictionary.data(), l.returnflagDictionary.size(), l.linestatusDictionary.data(),
+                       l.linestatusDictionary.size(), groupIdByCode);
+    size_t linestatusSize = l.linestatusDictionary.size();
+
+    forEachMorsel(pool, l.partkey.size(), [&](unsigned worker, size_t begin, size_t end) {
+        uint32_t selection[BATCH_SIZE];
+        const int32_t *shipdate = l.shipdate.data() + begin;
+        size_t count = select(end - begin, selection, [&](uint32_t i) { return shipdate[i] <= Q1_MAX_SHIPDATE; });
+        const uint32_t *returnflag = l.returnflagCode.data() + begin;
+        const uint32_t *linestatus = l.linestatusCode.data() + begin;
+        q1::aggregate(groups[worker].data(), selection, count, l.quantity.data() + begin,
+                      l.extendedprice.data() + begin, l.discount.data() + begin, l.tax.data() + begin,
+                      [&](size_t i) {
+                          return groupIdByCode[returnflag[i] * linestatusSize + linestatus[i]];
+                      });
+    });
+
+    double sum = 0;
+    for (unsigned worker = 0; worker < groups.size(); worker++) {
+        for (auto &g : groups[worker]) {
+            sum += g.sum4;
+        }
+    }
+    return sum;
+}
+
+static double q1Operators(MorselPool &pool, const Lineitem &l) {
+    const unsigned quantity = 0, extendedprice = 1, discount = 2, tax = 3, returnflag = 4, linestatus = 5;
+    unsigned discPrice, charge;
+    auto aggregate = hashAggregate<unsigned, Group>(pool, [&](const Batch &batch, uint32_t i) {
+        return (unsigned) ((batch.column<ByteArray>(returnflag)[i].ptr[0] << 8) |
+                           batch.column<ByteArray>(linestatus)[i].ptr[0]);
+    }, [&](Group &s, const Batch &batch, uint32_t i) {
+        s.sum1 += batch.column<double>(quantity)[i];
+        s.sum2 += batch.column<double>(extendedprice)[i];
+        s.sum3 += batch.column<double>(discPrice)[i];
+        s.sum4 += batch.column<double>(charge)[i];
+        s.sum5 += batch.column<double>(discount)[i];
+        s.count++;
+    }, q1::merge);
+
+    Project project(pool, 6, aggregate);
+    discPrice = project.add<double>([=](const Batch &batch, uint32_t i) {
+        return batch.column<double>(extendedprice)[i] * (1.0 - batch.column<double>(discount)[i]);
+    });
+    charge = project.add<double>([=](const Batch &batch, uint32_t i) {
+        return batch.column<double>(discPrice)[i] * (1.0 + batch.column<double>(tax)[i]);
+    });
+
+    forEachMorsel(pool, l.partkey.size(), [&](unsigned worker, size_t begin, size_t end) {
+        uint32_t selection[BATCH_SIZE];
+        const int32_t *shipdate = l.shipdate.data() + begin;
+        Batch batch;
+        batch.worker = worker;
+        batch.size = end - begin;
+        batch.selection = selection;
+        batch.count = select(end - begin, selection, [&](uint32_t i) { return shipdate[i] <= Q1_MAX_SHIPDATE; });
+        batch.addColumn(l.quantity.data() + begin);
+        batch.addColumn(l.extendedprice.data() + begin);
+        batch.addColumn(l.discount.data() + begin);
+        batch.addColumn(l.tax.data() + begin);
+        batch.addColumn(l.returnflag.data() + begin);
+        batch.addColumn(l.linestatus.data() + begin);
+        project.consume(batch);
+    });
+    project.finish();
+
+    double sum = 0;
+    for (auto &group : aggregate.getResult()) {
+        sum += group.second.sum4;
+    }
+    return sum;
+}
+
+struct GroupKey : pipeline::Value<unsigned> {};
+struct DiscPrice : pipeline::Value<double> {};
+struct Charge : pipeline::Value<double> {};
+
+static double q1Pipeline(MorselPool &pool, const Lineitem &l) {
+    using tpch::l_quantity;
+    using tpch::l_extendedprice;
+    using tpch::l_discount;
+    using tpch::l_tax;
+    using tpch::l_returnflag;
+    using tpch::l_linestatus;
+    auto groups = pipeline::aggregate<GroupKey, Group, l_quantity, l_extendedprice, DiscPrice, Charge, l_discount>(
+            pool, [](Group &s, double quantity, double extendedprice, double discPrice, double charge,
+                     double discount) {
+                s.sum1 += quantity;
+                s.sum2 += extendedprice;
+                s.sum3 += discPrice;
+                s.sum4 += charge;
+                s.sum5 += discount;
+                s.count++;
+            }, q1::merge);
+    auto lineitemScan = pipeline::scan<tpch::Lineitem, l_quantity, l_extendedprice, l_discount, l_tax, l_returnflag,
+            l_linestatus>()
+            .map<GroupKey, l_returnflag, l_linestatus>([](const ByteArray &returnflag, const ByteArray &linestatus) {
+                return (unsigned) ((returnflag.ptr[0] << 8) | linestatus.ptr[0]);
+            })
+            .map<DiscPrice, l_extendedprice, l_discount>([](double extendedprice, double discount) {
+                return extendedprice * (1.0 - discount);
+            })
+            .map<Charge, DiscPrice, l_tax>([](double discPrice, double tax) {
+                return discPrice * (1.0 + tax);
+            });
+
+    forEachMorsel(pool, l.partkey.size(), [&](unsigned worker, size_t begin, size_t end) {
+        uint32_t selection[BATCH_SIZE];
+        const int32_t *shipdate = l.shipdate.data() + begin;
+        size_t count = select(end - begin, selection, [&](uint32_t i) { return shipdate[i] <= Q1_MAX_SHIPDATE; });
+        lineitemScan.push(groups, worker, selection, count, l.quantity.data() + begin, l.extendedprice.data() + begin,
+                          l.discount.data() + begin, l.tax.data() + begin, l.returnflag.data() + begin,
+                          l.linestatus.data() + begin);
+    });
+    groups.finish();
+
+    double sum = 0;
+    for (auto &group : groups.getResult()) {
+        sum += group.second.sum4;
+    }
+    return sum;
+}
+
+using q14::Revenue;
+
+static double q14Handwritten(MorselPool &pool, const Lineitem &l, const Part &p) {
+    PerWorker<vector<pair<int32_t, double>>> matches(pool);
+    forEachMorsel(pool, l.partkey.size(), [&](unsigned worker, size_t begin, size_t end) {
+        uint32_t selection[BATCH_SIZE];
+        const int32_t *shipdate = l.shipdate.data() + begin;
+        size_t count = select(end - begin, selection, [&](uint32_t i) {
+            return shipdate[i] >= Q14_MIN_SHIPDATE && shipdate[i] <= Q14_MAX_SHIPDATE;
+        });
+        q14::collect(matches[worker], selection, count, l.partkey.data() + begin, l.extendedprice.data() + begin,
+                     l.discount.data() + begin);
+    });
+    unique_ptr<CsrIndex<double>> index = buildCsrIndex(pool, matches);
+
+    PerWorker<Revenue> revenues(pool);
+    forEachMorsel(pool, p.partkey.size(), [&](unsigned worker, size_t begin, size_t end) {
+        uint32_t selection[BATCH_SIZE];
+        size_t count = select(end - begin, selection, [](uint32_t i) { return true; });
+        q14::probe(*index, revenues[worker], selection, count, p.partkey.data() + begin, p.type.data() + begin);
+    });
+
+    Revenue r;
+    for (unsigned worker = 0; worker < revenues.size(); worker++) {
+        q14::merge(r, revenues[worker]);
+    }
+    return 100 * (r.promo / r.total);
+}
+
+static double q14Operators(MorselPool &pool, const Lineitem &l, const Part &p) {
+    const unsigned l_partkey = 0, l_extendedprice = 1, l_discount = 2;
+    auto build = hashJoinBuild<int32_t, double>(pool, [=](const Batch &batch, uint32_t i) {
+        return batch.column<int32_t>(l_partkey)[i];
+    }, [=](const Batch &batch, uint32_t i) {
+        return batch.column<double>(l_extendedprice)[i] * (1 - batch.column<double>(l_discount)[i]);
+    }, "q14_hash_build");
+    forEachMorsel(pool, l.partkey.size(), [&](unsigned worker, size_t begin, size_t end) {
+        uint32_t selection[BATCH_SIZE];
+        const int32_t *shipdate = l.shipdate.data() + begin;
+        Batch batch;
+        batch.worker = worker;
+        batch.size = end - begin;
+        batch.selection = selection;
+        batch.count = select(end - begin, selection, [&](uint32_t i) {
+            return shipdate[i] >= Q14_MIN_SHIPDATE && shipdate[i] <= Q14_MAX_SHIPDATE;
+        });
+        batch.addColumn(l.partkey.data() + begin);
+        batch.addColumn(l.extendedprice.data() + begin);
+        batch.addColumn(l.discount.data() + begin);
+        build.consume(batch);
+    });
+    build.finish();
+
+    const unsigned p_partkey = 0, p_type = 1;
+    unsigned type, revenue;
+    auto sums = reduce<Revenue>(pool, [&](Revenue &r, const Batch &batch, uint32_t i) {
+        double a = batch.column<double>(revenue)[i];
+        if (q14::isPromo(batch.column<ByteArray>(type)[i])) {
+            r.promo += a;
+        }
+        r.total += a;
+    }, q14::merge);
+    auto probe = hashJoinProbe<int32_t>(pool, build.getIndex(), p_partkey, sums);
+    type = probe.carry<ByteArray>(p_type);
+    revenue = probe.valueSlot();
+
+    forEachMorsel(pool, p.partkey.size(), [&](unsigned worker, size_t begin, size_t end) {
+        uint32_t selection[BATCH_SIZE];
+        Batch batch;
+        batch.worker = worker;
+        batch.size = end - begin;
+        batch.selection = selection;
+        batch.count = select(end - begin, selection, [](uint32_t i) { return true; });
+        batch.addColumn(p.partkey.data() + begin);
+        batch.addColumn(p.type.data() + begin);
+        probe.consume(batch);
+    });
+    probe.finish();
+
+    return 100 * (sums.getResult().promo / sums.getResult().total);
+}
+
+struct l_revenue : pipeline::Value<double> {};
+struct p_promo : pipeline::Value<bool> {};
+
+static double q14Pipeline(MorselPool &pool, const Lineitem &l, const Part &p) {
+    using tpch::l_partkey;
+    using tpch::l_extendedprice;
+    using tpch::l_discount;
+    pipeline::Collect<l_partkey, l_revenue> revenues(pool);
+    auto lineitemScan = pipeline::scan<tpch::Lineitem, l_partkey, l_extendedprice, l_discount>()
+            .map<l_revenue, l_extendedprice, l_discount>([](double extendedprice, double discount) {
+                return extendedprice * (1 - discount);
+            });
+    forEachMorsel(pool, l.partkey.size(), [&](unsigned worker, size_t begin, size_t end) {
+        uint32_t selection[BATCH_SIZE];
+        const int32_t *shipdate = l.shipdate.data() + begin;
+        size_t count = select(end - begin, selection, [&](uint32_t i) {
+            return shipdate[i] >= Q14_MIN_SHIPDATE && shipdate[i] <= Q14_MAX_SHIPDATE;
+        });
+        lineitemScan.push(revenues, worker, selection, count, l.partkey.data() + begin,
+                          l.extendedprice.data() + begin, l.discount.data() + begin);
+    });
+    revenues.finish();
+    unique_ptr<CsrIndex<double>> revenueByPart = buildCsrIndex(pool, revenues.getEntries());
+
+    using tpch::p_partkey;
+    using tpch::p_type;
+    auto sums = pipeline::reduce<Revenue, l_revenue, p_promo>(pool, [](Revenue &r, double revenue, bool isPromo) {
+        if (isPromo) {
+            r.promo += revenue;
+        }
+        r.total += revenue;
+    }, q14::merge);
+    auto partScan = pipeline::scan<tpch::Part, p_partkey, p_type>()
+            .probe<l_revenue, p_partkey>(*revenueByPart)
+            .map<p_promo, p_type>([](const ByteArray &type) {
+                return q14::isPromo(type);
+            });
+    forEachMorsel(pool, p.partkey.size(), [&](unsigned worker, size_t begin, size_t end) {
+        uint32_t selection[BATCH_SIZE];
+        size_t count = select(end - begin, selection, [](uint32_t i) { return true; });
+        partScan.push(sums, worker, selection, count, p.partkey.data() + begin, p.type.data() + begin);
+    });
+    sums.finish();
+
+    return 100 * (sums.getResult().promo / sums.getResult().total);
+}
+
+using q17::LineitemMatch;
+
+static double q17Handwritten(MorselPool &pool, const Lineitem &l, const Part &p) {
+    PerWorker<vector<int32_t>> partkeys(pool);
+    forEachMorsel(pool, p.partkey.size(), [&](unsigned worker, size_t begin, size_t end) {
+        uint32_t selection[BATCH_SIZE];
+        const uint8_t *matches = p.matches.data() + begin;
+        size_t count = select(end - begin, selection, [&](uint32_t i) { return matches[i] != 0; });
+        for (size_t k = 0; k < count; k++) {
+            partkeys[worker].push_back(p.partkey[begin + selection[k]]);
+        }
+    });
+    vector<bool> partMatches(p.partkey.size() + 1);
+    for (unsigned worker = 0; worker < partkeys.size(); worker++) {
+        for (int32_t partkey : partkeys[worker]) {
+            partMatches[partkey] = true;
+        }
+    }
+
+    PerWorker<vector<LineitemMatch>> matches(pool);
+    forEachMorsel(pool, l.partkey.size(), [&](unsigned worker, size_t begin, size_t end) {
+        uint32_t selection[BATCH_SIZE];
+        const int32_t *partkey = l.partkey.data() + begin;
+        size_t count = select(end - begin, selection, [&](uint32_t i) { return partMatches[partkey[i]]; });
+        const double *quantity = l.quantity.data() + begin;
+        const double *extendedprice = l.extendedprice.data() + begin;
+        for (size_t k = 0; k < count; k++) {
+            size_t i = selection[k];
+            matches[worker].push_back({partkey[i], quantity[i], extendedprice[i]});
+        }
+    });
+    vector<LineitemMatch> matched = radixSort(pool, matches, [](const LineitemMatch &match) {
+        return (uint32_t) match.partkey;
+    });
+
+    return q17::parallelAggregate(pool, matched) / 7.0;
+}
+
+static double q17Operators(MorselPool &pool, const Lineitem &l, const Part &p) {
+    const unsigned p_partkey = 0;
+    auto parts = bitmapBuild(pool, [=](const Batch &batch, uint32_t i) {
+        return (uint32_t) batch.column<int32_t>(p_partkey)[i];
+    }, "q17_bitmap_build");
+    forEachMorsel(pool, p.partkey.size(), [&](unsigned worker, size_t begin, size_t end) {
+        uint32_t selection[BATCH_SIZE];
+        const uint8_t *matches = p.matches.data() + begin;
+        Batch batch;
+        batch.worker = worker;
+        batch.size = end - begin;
+        batch.selection = selection;
+        batch.count = select(end - begin, selection, [&](uint32_t i) { return matches[i] != 0; });
+        batch.addColumn(p.partkey.data() + begin);
+        parts.consume(batch);
+    });
+    parts.finish();
+
+    // The semi join is pushed into the scan like in q17_operators.cpp
+    const KeyBitmap &bitmap = parts.getBitmap();
+    const unsigned l_partkey = 0, l_quantity = 1, l_extendedprice = 2;
+    auto sorted = sortBy<LineitemMatch>(pool, [=](const Batch &batch, uint32_t i) {
+        return LineitemMatch{batch.column<int32_t>(l_partkey)[i], batch.column<double>(l_quantity)[i],
+                             batch.column<double>(l_extendedprice)[i]};
+    }, [](const LineitemMatch &match) {
+        return (uint32_t) match.partkey;
+    }, "q17_sort");
+    forEachMorsel(pool, l.partkey.size(), [&](unsigned worker, size_t begin, size_t end) {
+        uint32_t selection[BATCH_SIZE];
+        const int32_t *partkey = l.partkey.data() + begin;
+        Batch batch;
+        batch.worker = worker;
+        batch.size = end - begin;
+        batch.selection = selection;
+        batch.count = select(end - begin, selection, [&](uint32_t i) { return bitmap.contains(partkey[i]); });
+        batch.addColumn(l.partkey.data() + begin);
+        batch.addColumn(l.quantity.data() + begin);
+        batch.addColumn(l.extendedprice.data() + begin);
+        sorted.consume(batch);
+    });
+    sorted.finish();
+
+    return q17::parallelAggregate(pool, sorted.getResult()) / 7.0;
+}
+
+int main(int argc, char **argv) {
+    size_t rows = argc > 1 ? strtoull(argv[1], NULL, 10) : 6000000;
+    unsigned threads = argc > 2 ? atoi(argv[2]) : max(thread::hardware_concurrency(), 1u);
+    if (rows == 0 || threads == 0) {
+        cerr << "usage: " << argv[0] << " [ROWS] [THREADS]" << endl;
+        return 1;
+    }
+
+    Lineitem lineitem;
+    Part part;
+    generate(rows, lineitem, part);
+    MorselPool pool(threads);
+
+    cout << fixed << setprecision(1);
+    cout << rows << " lineitems, " << part.partkey.size() << " parts, " << threads << " threads, ms" << endl;
+    cout << "query  hand written  operators  pipeline" << endl;
+    const char *names[] = {"q1", "q14", "q17"};
+    for (unsigned q = 0; q < 3; q++) {
+        // q17 has no pipeline variant
+        double expected = 0, result = 0, pipelined = 0, handwritten = 0, operators = 0, pipeline = 0;
+        if (q == 0) {
+            handwritten = timing::bestOf(RUNS, [&]() { expected = q1Handwritten(pool, lineitem); });
+            operators = timing::bestOf(RUNS, [&]() { result = q1Operators(pool, lineitem); });
+            pipeline = timing::bestOf(RUNS, [&]() { pipelined = q1Pipeline(pool, lineitem); });
+        } else if (q == 1) {
+            handwritten = timing::bestOf(RUNS, [&]() { expected = q14Handwritten(pool, lineitem, part); });
+            operators = timing::bestOf(RUNS, [&]() { result = q14Operators(pool, lineitem, part); });
+            pipeline = timing::bestOf(RUNS, [&]() { pipelined = q14Pipeline(pool, lineitem, part); });
+        } else {
+            handwritten = timing::bestOf(RUNS, [&]() { expected = q17Handwritten(pool, lineitem, part); });
+            operators = timing::bestOf(RUNS, [&]() { result = q17Operators(pool, lineitem, part); });
+            pipelined = expected;
+        }
+
+        for (double r : {result, pipelined}) {
+            if (fabs(r - expected) > 1e-9 * fabs(expected)) {
+                cerr << names[q] << " results differ: " << expected << " and " << r << endl;
+                return 1;
+            }
+        }
+        cout << setw(5) << names[q] << setw(14) << handwritten / 1e6 << setw(11) << operators / 1e6;
+        if (q < 2) {
+            cout << setw(10) << pipeline / 1e6 << endl;
+        } else {
+            cout << setw(10) << "-" << endl;
+        }
+    }
+    return 0;
+}
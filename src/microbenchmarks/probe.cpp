@@ -0,0 +1,110 @@
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+#include <stdlib.h>
+
+#include "../queries/HashJoin.h"
+#include "../queries/InlineHashTable.h"
+#include "Timing.h"
+
+using namespace std;
+using namespace benchmark;
+
+// Probe throughput of the hash tables of the joins with tables of 2^16 to
+// 2^24 keys, i.e. from tables in L2 to tables well larger than the LLC:
+// JoinIndex (one slot per key, values and chains in separate arrays),
+// InlineHashTable with one lookup at a time, and InlineHashTable with
+// batched lookups that prefetch the groups of 32 keys before comparing.
+// Half of the probed keys are in the tables, probes come in batches of
+// 2048 keys like the rows of a scan.
+
+static const unsigned RUNS = 3;
+static const size_t PROBES = 1 << 24;
+static const size_t BATCH = 2048;
+
+int main(int argc, char **argv) {
+    vector<size_t> sizes;
+    for (int i = 1; i < argc; i++) {
+        sizes.push_back(atol(argv[i]));
+    }
+    if (sizes.empty()) {
+        sizes = {1 << 16, 1 << 20, 1 << 22, 1 << 24};
+    }
+
+    MorselPool pool(1);
+    mt19937 random(42);
+    vector<uint32_t> selection(BATCH);
+    for (size_t i = 0; i < BATCH; i++) {
+        selection[i] = i;
+    }
+
+    cout << "keys        M probes/s: JoinIndex  InlineHashTable  batched" << endl;
+    cout << fixed << setprecision(1);
+    for (size_t keyCount : sizes) {
+        // Keys 0, 2, 4, ... are in the tables, values are the keys
+        PerWorker<vector<pair<uint32_t, uint32_t>>> tuples(pool);
+        InlineHashTable<uint32_t> table(keyCount);
+        table.clear();
+        for (uint32_t key = 0; key < 2 * keyCount; key += 2) {
+            tuples[0].push_back(make_pair(key, key));
+            table.insert(key) = key;
+        }
+        unique_ptr<JoinIndex<uint32_t>> index = buildJoinIndex(pool, tuples, HashBuild::SERIAL);
+
+        uniform_int_distribution<uint32_t> keys(0, 2 * keyCount - 1);
+        vector<uint32_t> probes(PROBES);
+        uint64_t expected = 0;
+        for (auto &probe : probes) {
+            probe = keys(random);
+            expected += probe % 2 == 0 ? probe : 0;
+        }
+
+        uint64_t sum = 0;
+        double joinIndex = timing::bestOf(RUNS, [&]() {
+            sum = 0;
+            for (size_t begin = 0; begin < PROBES; begin += BATCH) {
+                for (size_t k = 0; k < BATCH; k++) {
+                    uint32_t t = index->find(probes[begin + selection[k]]);
+                    if (t != NO_ENTRY) {
+                        sum += index->value(t);
+                    }
+                }
+            }
+        });
+        bool correct = sum == expected;
+
+        double inlineTable = timing::bestOf(RUNS, [&]() {
+            sum = 0;
+            for (size_t begin = 0; begin < PROBES; begin += BATCH) {
+                for (size_t k = 0; k < BATCH; k++) {
+                    const uint32_t *value = table.find(probes[begin + selection[k]]);
+                    if (value != 0) {
+                        sum += *value;
+                    }
+                }
+            }
+        });
+        correct &= sum == expected;
+
+        double batched = timing::bestOf(RUNS, [&]() {
+            sum = 0;
+            for (size_t begin = 0; begin < PROBES; begin += BATCH) {
+                table.findBatch(&probes[begin], selection.data(), BATCH, [&](uint32_t i, const uint32_t &value) {
+                    sum += value;
+                });
+            }
+        });
+        correct &= sum == expected;
+
+        if (!correct) {
+            cerr << "Lookups of " << keyCount << " keys disagree" << endl;
+            return 1;
+        }
+        cout << setw(10) << keyCount << " (" << setw(6) << table.getGroupCount() * 64 / (1 << 20) << " MB)"
+             << setw(14) << PROBES / (joinIndex / 1e3) << setw(17) << PROBES / (inlineTable / 1e3)
+             << setw(9) << PROBES / (batched / 1e3) << endl;
+    }
+    return 0;
+}
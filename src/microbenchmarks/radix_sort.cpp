@@ -0,0 +1,93 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+#include <stdlib.h>
+
+#include "../queries/Q17.h"
+#include "../queries/RadixSort.h"
+#include "Timing.h"
+
+using namespace std;
+using namespace benchmark;
+
+// The sort and aggregation of q17's lineitem matches with 1 to 32 threads,
+// at the match volumes of scale factors 100 and 1000: 0.1% of the part
+// keys (Brand#23 and MED BOX) match, with 30 lineitems each on average.
+// Compares concatenating the workers' matches, std::sort and a serial
+// aggregation (q17 before) with radixSort() and one aggregation range per
+// worker (q17 now).
+
+static const unsigned RUNS = 5;
+
+using q17::LineitemMatch;
+
+static bool byPartkey(const LineitemMatch &a, const LineitemMatch &b) {
+    return a.partkey < b.partkey;
+}
+
+int main(int argc, char **argv) {
+    unsigned maxThreads = argc > 1 ? atoi(argv[1]) : 32;
+    if (maxThreads == 0) {
+        cerr << "usage: " << argv[0] << " [MAX-THREADS]" << endl;
+        return 1;
+    }
+
+    cout << fixed << setprecision(1);
+    for (unsigned scaleFactor : {100, 1000}) {
+        size_t partCount = 200000ull * scaleFactor;
+        size_t matchCount = 6000000ull * scaleFactor / 1000;
+        mt19937 random(scaleFactor);
+        vector<int32_t> parts(partCount / 1000);
+        uniform_int_distribution<int32_t> partkeys(1, partCount);
+        for (auto &part : parts) {
+            part = partkeys(random);
+        }
+        uniform_int_distribution<size_t> partIndex(0, parts.size() - 1);
+        uniform_int_distribution<int> quantities(1, 50);
+        vector<LineitemMatch> matches(matchCount);
+        for (auto &match : matches) {
+            int quantity = quantities(random);
+            match = LineitemMatch{parts[partIndex(random)], (double) quantity, quantity * 1000.0};
+        }
+
+        cout << "SF " << scaleFactor << ", " << matchCount << " matches of " << parts.size() << " parts, ms" << endl;
+        cout << "threads  std::sort + serial  radixSort + parallel" << endl;
+        for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+            MorselPool pool(threads);
+            PerWorker<vector<LineitemMatch>> collected(pool);
+            auto collect = [&]() {
+                for (unsigned w = 0; w < threads; w++) {
+                    collected[w].assign(matches.begin() + matchCount * w / threads,
+                                        matches.begin() + matchCount * (w + 1) / threads);
+                }
+            };
+
+            double expected = 0, result = 0;
+            double before = timing::bestOf(RUNS, collect, [&]() {
+                vector<LineitemMatch> matched;
+                for (unsigned w = 0; w < threads; w++) {
+                    matched.insert(matched.end(), collected[w].begin(), collected[w].end());
+                }
+                sort(matched.begin(), matched.end(), byPartkey);
+                expected = q17::aggregate(matched, 0, matched.size());
+            });
+            double after = timing::bestOf(RUNS, collect, [&]() {
+                vector<LineitemMatch> matched = radixSort(pool, collected, [](const LineitemMatch &match) {
+                    return (uint32_t) match.partkey;
+                });
+                result = q17::parallelAggregate(pool, matched);
+            });
+
+            if (fabs(result - expected) > 1e-9 * fabs(expected)) {
+                cerr << "Results differ: " << expected << " and " << result << endl;
+                return 1;
+            }
+            cout << setw(7) << threads << setw(20) << before / 1e6 << setw(22) << after / 1e6 << endl;
+        }
+    }
+    return 0;
+}
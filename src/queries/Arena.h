@@ -0,0 +1,98 @@
+#ifndef HDFS_BENCHMARK_ARENA_H
+#define HDFS_BENCHMARK_ARENA_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include <stdint.h>
+
+using namespace std;
+
+namespace benchmark {
+    /**
+     * Bump allocator whose memory is reused after `reset()`. Allocations are
+     * 64 byte aligned. When an arena needed several blocks, `reset()`
+     * replaces them with one block of their total size, so that it settles
+     * on a single block after a few rounds.
+     */
+    class Arena {
+    public:
+        static const size_t ALIGNMENT = 64;
+        static const size_t MIN_BLOCK_SIZE = 1 << 20;
+
+        Arena() {
+
+        }
+
+        Arena(const Arena &) = delete;
+
+        Arena &operator=(const Arena &) = delete;
+
+        uint8_t *allocate(size_t n) {
+            n = (n + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+            if (this->blocks.empty() || this->used + n > this->blocks.back().size) {
+                size_t size = this->capacity > MIN_BLOCK_SIZE ? this->capacity : MIN_BLOCK_SIZE;
+                this->addBlock(max(n, size));
+            }
+            uint8_t *p = this->blocks.back().data.get() + this->used;
+            this->used += n;
+            return p;
+        }
+
+        /**
+         * Frees all allocations at once.
+         */
+        void reset() {
+            if (this->blocks.size() > 1) {
+                size_t total = this->capacity;
+                this->blocks.clear();
+                this->capacity = 0;
+                this->addBlock(total);
+            }
+            this->used = 0;
+        }
+
+        size_t getCapacity() const {
+            return this->capacity;
+        }
+
+        /**
+         * The arena of the calling thread.
+         */
+        static Arena &local() {
+            static thread_local Arena arena;
+            return arena;
+        }
+
+    private:
+        struct Free {
+            void operator()(uint8_t *p) const {
+                free(p);
+            }
+        };
+
+        struct Block {
+            unique_ptr<uint8_t, Free> data;
+            size_t size;
+        };
+
+        void addBlock(size_t size) {
+            void *p = 0;
+            if (posix_memalign(&p, ALIGNMENT, size) != 0) {
+                throw bad_alloc();
+            }
+            this->blocks.push_back(Block{unique_ptr<uint8_t, Free>(static_cast<uint8_t *>(p)), size});
+            this->capacity += size;
+            this->used = 0;
+        }
+
+        vector<Block> blocks;
+        size_t used = 0;
+        size_t capacity = 0;
+    };
+};
+
+#endif //HDFS_BENCHMARK_ARENA_H
@@ -0,0 +1,438 @@
+#ifndef HDFS_BENCHMARK_BINARYLOG_H
+#define HDFS_BENCHMARK_BINARYLOG_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+/**
+ * An asynchronous logger for hot paths. A log call copies its printf-style
+ * format pointer and its raw arguments into a per-thread ring buffer; a
+ * background thread formats and prints them. Calls below
+ * BLOG_COMPILE_LEVEL are removed at compile time, calls below the runtime
+ * level cost a load and a branch and do not evaluate their arguments.
+ *
+ *   BLOG_DEBUG("Thread-%u downloaded %s (%f MB/s)", i, name, speed);
+ *
+ * Strings are copied into the record in full, all other arguments must
+ * be trivially copyable. When a ring buffer is full, records are dropped
+ * and counted rather than blocking the caller. The ring of a thread is
+ * freed after the thread exited and its records were printed.
+ */
+#define BLOG_LEVEL_DEBUG 0
+#define BLOG_LEVEL_INFO 1
+#define BLOG_LEVEL_WARNING 2
+
+#ifndef BLOG_COMPILE_LEVEL
+#define BLOG_COMPILE_LEVEL BLOG_LEVEL_DEBUG
+#endif
+
+#define BLOG(level, ...) do { \
+        if ((level) >= BLOG_COMPILE_LEVEL && (level) >= blog::runtimeLevel().load(std::memory_order_relaxed)) { \
+            blog::log((level), __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define BLOG_DEBUG(...) BLOG(BLOG_LEVEL_DEBUG, __VA_ARGS__)
+#define BLOG_INFO(...) BLOG(BLOG_LEVEL_INFO, __VA_ARGS__)
+#define BLOG_WARNING(...) BLOG(BLOG_LEVEL_WARNING, __VA_ARGS__)
+
+namespace blog {
+    inline std::atomic<int> &runtimeLevel() {
+        static std::atomic<int> level(BLOG_LEVEL_INFO);
+        return level;
+    }
+
+    inline void setLevel(int level) {
+        runtimeLevel().store(level);
+    }
+
+    struct Record;
+    typedef void (*FormatFunction)(FILE *out, const Record &record);
+
+    /**
+     * A log record, followed by the tuple of its encoded arguments and the
+     * bytes of its string arguments. Records are padded to a multiple of 8
+     * bytes; a record without format function marks the unused end of a
+     * ring.
+     */
+    struct alignas(8) Record {
+        FormatFunction format;
+        const char *fmt;
+        uint64_t ts;
+        int level;
+        unsigned tid;
+        uint32_t size;
+
+        unsigned char *payload() {
+            return reinterpret_cast<unsigned char *>(this + 1);
+        }
+
+        const unsigned char *payload() const {
+            return reinterpret_cast<const unsigned char *>(this + 1);
+        }
+    };
+
+    /**
+     * Appends the bytes of string arguments behind a record's payload.
+     */
+    struct StringWriter {
+        unsigned char *record;
+        uint32_t position;
+
+        uint32_t append(const char *value, size_t length) {
+            uint32_t offset = position;
+            memcpy(record + position, value, length);
+            record[position + length] = 0;
+            position += length + 1;
+            return offset;
+        }
+    };
+
+    /**
+     * A string argument: its offset from the start of the record and its
+     * length without the terminating 0.
+     */
+    struct StringRef {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    /**
+     * How an argument of type T is stored in a record and passed to printf.
+     * `size()` is the number of bytes it needs behind the payload.
+     */
+    template<typename T>
+    struct Encoding {
+        typedef T type;
+
+        static size_t size(const T &value) {
+            return 0;
+        }
+
+        static T encode(const T &value, StringWriter &writer) {
+            return value;
+        }
+
+        static const T &decode(const T &value, const Record &record) {
+            return value;
+        }
+    };
+
+    template<>
+    struct Encoding<const char *> {
+        typedef StringRef type;
+
+        static const char *string(const char *value) {
+            return value ? value : "(null)";
+        }
+
+        static size_t size(const char *value) {
+            return strlen(string(value)) + 1;
+        }
+
+        static StringRef encode(const char *value, StringWriter &writer) {
+            const char *s = string(value);
+            size_t length = strlen(s);
+            StringRef ref;
+            ref.offset = writer.append(s, length);
+            ref.length = length;
+            return ref;
+        }
+
+        static const char *decode(const StringRef &value, const Record &record) {
+            return reinterpret_cast<const char *>(&record) + value.offset;
+        }
+    };
+
+    template<>
+    struct Encoding<char *> : Encoding<const char *> {
+    };
+
+    template<>
+    struct Encoding<std::string> : Encoding<const char *> {
+        static size_t size(const std::string &value) {
+            return value.size() + 1;
+        }
+
+        static StringRef encode(const std::string &value, StringWriter &writer) {
+            StringRef ref;
+            ref.offset = writer.append(value.data(), value.size());
+            ref.length = value.size();
+            return ref;
+        }
+    };
+
+    template<size_t... I>
+    struct Indices {
+    };
+
+    template<size_t N, size_t... I>
+    struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {
+    };
+
+    template<size_t... I>
+    struct MakeIndices<0, I...> {
+        typedef Indices<I...> type;
+    };
+
+    template<typename... Args>
+    struct Formatter {
+        typedef std::tuple<typename Encoding<Args>::type...> Payload;
+
+        static void format(FILE *out, const Record &record) {
+            const Payload &payload = *reinterpret_cast<const Payload *>(record.payload());
+            print(out, record, payload, typename MakeIndices<sizeof...(Args)>::type());
+        }
+
+        template<size_t... I>
+        static void print(FILE *out, const Record &record, const Payload &payload, Indices<I...>) {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-security"
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+            fprintf(out, record.fmt, Encoding<Args>::decode(std::get<I>(payload), record)...);
+#pragma GCC diagnostic pop
+        }
+    };
+
+    /**
+     * A single-producer single-consumer ring of variable size records,
+     * written by its thread and drained by the logger thread. A record
+     * never wraps around the end of the ring: if it does not fit, the rest
+     * of the ring is skipped. `head` and `tail` count bytes.
+     */
+    class Ring {
+    public:
+        static const size_t CAPACITY = 1 << 19;
+
+        Ring(unsigned tid) : tid(tid), data(new uint64_t[CAPACITY / sizeof(uint64_t)]) {
+
+        }
+
+        /**
+         * Space for a record of `size` bytes, 0 if the ring is full.
+         */
+        Record *acquire(size_t size) {
+            uint64_t h = head.load(std::memory_order_relaxed);
+            size_t offset = h & (CAPACITY - 1);
+            size_t skip = CAPACITY - offset < size ? CAPACITY - offset : 0;
+            if (h + skip + size - tail.load(std::memory_order_acquire) > CAPACITY) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return 0;
+            }
+            if (skip >= sizeof(Record)) {
+                at(h)->format = 0;
+            }
+            next = h + skip + size;
+            return at(h + skip);
+        }
+
+        void publish() {
+            head.store(next, std::memory_order_release);
+        }
+
+        /**
+         * The record at `position`, or 0 if the ring is skipped from there
+         * to its end.
+         */
+        Record *read(uint64_t position) {
+            size_t offset = position & (CAPACITY - 1);
+            if (CAPACITY - offset < sizeof(Record) || at(position)->format == 0) {
+                return 0;
+            }
+            return at(position);
+        }
+
+        /**
+         * The position of the next record after `position`.
+         */
+        uint64_t advance(uint64_t position) {
+            Record *record = read(position);
+            return record != 0 ? position + record->size : (position | (CAPACITY - 1)) + 1;
+        }
+
+        unsigned tid;
+        std::atomic<uint64_t> head{0};
+        std::atomic<uint64_t> tail{0};
+        std::atomic<uint64_t> dropped{0};
+        // Set when the thread exits, the ring is freed once it is drained
+        std::atomic<bool> retired{false};
+
+    private:
+        Record *at(uint64_t position) {
+            return reinterpret_cast<Record *>(reinterpret_cast<unsigned char *>(data.get()) +
+                                              (position & (CAPACITY - 1)));
+        }
+
+        std::unique_ptr<uint64_t[]> data;
+        uint64_t next = 0;
+    };
+
+    class Logger {
+    public:
+        static Logger &get() {
+            static Logger logger;
+            return logger;
+        }
+
+        Logger() : out(stderr), start(now()), flusher(&Logger::run, this) {
+
+        }
+
+        ~Logger() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopped = true;
+            }
+            cv.notify_one();
+            flusher.join();
+            drain();
+        }
+
+        Ring *create() {
+            std::lock_guard<std::mutex> lock(mutex);
+            rings.push_back(std::unique_ptr<Ring>(new Ring(nextTid++)));
+            return rings.back().get();
+        }
+
+        /**
+         * Formats all pending records, ordered by time, and frees the rings
+         * of exited threads.
+         */
+        void drain() {
+            std::lock_guard<std::mutex> lock(drainMutex);
+            std::vector<std::pair<Ring *, uint64_t>> heads;
+            std::vector<Record *> pending;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (auto &ring : rings) {
+                    uint64_t head = ring->head.load(std::memory_order_acquire);
+                    heads.push_back(std::make_pair(ring.get(), head));
+                    for (uint64_t i = ring->tail.load(std::memory_order_relaxed); i < head; i = ring->advance(i)) {
+                        Record *record = ring->read(i);
+                        if (record != 0) {
+                            pending.push_back(record);
+                        }
+                    }
+                }
+            }
+
+            std::sort(pending.begin(), pending.end(), [](const Record *a, const Record *b) {
+                return a->ts < b->ts;
+            });
+
+            static const char *levels[] = {"debug", "info", "warning"};
+            for (Record *r : pending) {
+                fprintf(out, "[%12.6f] [%u] <%s> ", (r->ts - start) / 1e9, r->tid, levels[r->level]);
+                r->format(out, *r);
+                fputc('\n', out);
+            }
+
+            std::lock_guard<std::mutex> ringsLock(mutex);
+            for (auto &h : heads) {
+                h.first->tail.store(h.second, std::memory_order_release);
+            }
+            for (auto ring = rings.begin(); ring != rings.end();) {
+                uint64_t dropped = (*ring)->dropped.exchange(0);
+                if (dropped > 0) {
+                    fprintf(out, "[%u] <warning> dropped %lu log records\n", (*ring)->tid, (unsigned long) dropped);
+                }
+                if ((*ring)->retired.load(std::memory_order_acquire) &&
+                    (*ring)->head.load(std::memory_order_acquire) == (*ring)->tail.load(std::memory_order_relaxed)) {
+                    ring = rings.erase(ring);
+                } else {
+                    ++ring;
+                }
+            }
+            fflush(out);
+        }
+
+        static uint64_t now() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+    private:
+        void run() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!stopped) {
+                cv.wait_for(lock, std::chrono::milliseconds(10));
+                lock.unlock();
+                drain();
+                lock.lock();
+            }
+        }
+
+        FILE *out;
+        const uint64_t start;
+        std::mutex mutex;
+        std::mutex drainMutex;
+        std::condition_variable cv;
+        bool stopped = false;
+        unsigned nextTid = 0;
+        std::vector<std::unique_ptr<Ring>> rings;
+        std::thread flusher;
+    };
+
+    /**
+     * The ring of the calling thread, retired when the thread exits.
+     */
+    class LocalRing {
+    public:
+        LocalRing() : ring(Logger::get().create()) {
+
+        }
+
+        ~LocalRing() {
+            ring->retired.store(true, std::memory_order_release);
+        }
+
+        Ring *ring;
+    };
+
+    inline Ring &local() {
+        static thread_local LocalRing ring;
+        return *ring.ring;
+    }
+
+    template<typename... Args>
+    void log(int level, const char *fmt, const Args &... args) {
+        typedef Formatter<typename std::decay<Args>::type...> F;
+        typedef typename F::Payload Payload;
+        static_assert(alignof(Payload) <= alignof(Record), "Log arguments need a larger alignment");
+
+        size_t sizes[] = {0, Encoding<typename std::decay<Args>::type>::size(args)...};
+        size_t size = sizeof(Record) + sizeof(Payload);
+        for (size_t s : sizes) {
+            size += s;
+        }
+        size = (size + 7) & ~size_t(7);
+
+        Ring &ring = local();
+        Record *record = ring.acquire(size);
+        if (record == 0) {
+            return;
+        }
+        record->format = &F::format;
+        record->fmt = fmt;
+        record->ts = Logger::now();
+        record->level = level;
+        record->tid = ring.tid;
+        record->size = size;
+        StringWriter writer{reinterpret_cast<unsigned char *>(record), uint32_t(sizeof(Record) + sizeof(Payload))};
+        new(record->payload()) Payload(Encoding<typename std::decay<Args>::type>::encode(args, writer)...);
+        ring.publish();
+    }
+}
+
+#endif //HDFS_BENCHMARK_BINARYLOG_H
@@ -36,6 +36,9 @@ public:
     uint32_t idx;
     shared_ptr<void> data;
     string host;
+
+    // When the block was put into the queue of loaded blocks, in ns
+    uint64_t loadedAt = 0;
 };
 
 
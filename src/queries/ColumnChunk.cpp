@@ -3,12 +3,14 @@
 //
 
 #include <sstream>
+#include <stdexcept>
 
 #include <stdint.h>
 
 #include "ColumnChunk.h"
 
 #include "ParquetFile.h"
+#include "Pruning.h"
 
 namespace benchmark {
 
@@ -20,16 +22,288 @@ namespace benchmark {
             }
         }
 
-        const uint8_t *columnBuffer = p->parquetFile->getBuffer() + columnStart;
-        this->input = new InMemoryInputStream(columnBuffer, columnChunk.meta_data.total_compressed_size);
-        this->columnReader = new ColumnReader(&columnChunk.meta_data,
-                                              &p->parquetFile->getFileMetaData()->schema[p->idx + 1], input);
+        // Readers often outlive the ColumnChunk they were created from, keep everything readBatch() needs
+        this->columnBuffer = p->parquetFile->getBuffer() + columnStart;
+        this->columnLength = columnChunk.meta_data.total_compressed_size;
+        this->metaData = &columnChunk.meta_data;
+        this->schema = &p->parquetFile->getFileMetaData()->schema[p->idx + 1];
     }
 
+    ColumnChunk::Reader::~Reader() {
+        if (this->state) {
+            ReaderPool::local().release(move(this->state));
+        }
+    }
+
+    PageReader *ColumnChunk::Reader::getPages() {
+        if (!this->state) {
+            this->state = ReaderPool::local().acquire(this->columnBuffer, this->columnLength, this->metaData,
+                                                      this->schema);
+        }
+        return &this->state->pages;
+    }
+
+    ColumnReader *ColumnChunk::Reader::getColumnReader() {
+        if (!this->columnReader) {
+            this->input.reset(new InMemoryInputStream(this->columnBuffer, this->columnLength));
+            this->columnReader.reset(new ColumnReader(this->metaData, this->schema, this->input.get()));
+        }
+        return this->columnReader.get();
+    }
+
+    unique_ptr<ReaderState> ReaderPool::acquire(const uint8_t *data, size_t length,
+                                                const parquet::ColumnMetaData *metaData,
+                                                const parquet::SchemaElement *schema) {
+        unique_ptr<ReaderState> state;
+        if (this->free.empty()) {
+            state.reset(new ReaderState());
+        } else {
+            state = move(this->free.back());
+            this->free.pop_back();
+        }
+        state->pages.reset(data, length, metaData, schema);
+        // Parsed from the dictionary of the previous column chunk
+        state->dateDictionary.clear();
+        return state;
+    }
+
+    void ReaderPool::release(unique_ptr<ReaderState> state) {
+        if (this->free.size() < MAX_FREE) {
+            this->free.push_back(move(state));
+        }
+    }
+
+    ReaderPool &ReaderPool::local() {
+        static thread_local ReaderPool pool;
+        return pool;
+    }
+
+    template<typename T, typename Decode>
+    size_t ColumnChunk::Reader::readValues(T *out, size_t n, uint8_t *validBits, Decode decode) {
+        PageReader *pages = this->getPages();
+        if (!this->pagesHeld) {
+            pages->releaseRetired();
+        }
+
+        uint32_t maxLevel = pages->getMaxDefinitionLevel();
+        if (validBits) {
+            memset(validBits, 0, (n + 7) / 8);
+        }
+
+        size_t total = 0;
+        while (total < n) {
+            if (pages->valuesLeft() == 0 && !pages->nextPage()) {
+                break;
+            }
+
+            size_t count = min(n - total, pages->valuesLeft());
+            size_t present = count;
+            if (maxLevel > 0) {
+                if (this->state->levels.size() < count) {
+                    this->state->levels.resize(count);
+                }
+                pages->readDefinitionLevels(this->state->levels.data(), count);
+                present = 0;
+                for (size_t i = 0; i < count; i++) {
+                    present += this->state->levels[i] == maxLevel;
+                }
+            }
+
+            T *dest = out + total;
+            decode(dest, present);
+
+            // Spread the present values to their positions, back to front
+            if (present < count) {
+                size_t j = present;
+                for (size_t i = count; i-- > 0;) {
+                    dest[i] = this->state->levels[i] == maxLevel ? dest[--j] : T();
+                }
+            }
+
+            if (validBits) {
+                for (size_t i = 0; i < count; i++) {
+                    if (maxLevel == 0 || this->state->levels[i] == maxLevel) {
+                        validBits[(total + i) / 8] |= 1 << ((total + i) % 8);
+                    }
+                }
+            }
+
+            pages->consume(count);
+            total += count;
+        }
+        this->position += total;
+        return total;
+    }
+
+    template<typename T>
+    size_t ColumnChunk::Reader::readBatch(T *out, size_t n, uint8_t *validBits) {
+        PageReader *pages = this->getPages();
+        return this->readValues(out, n, validBits, [this, pages](T *dest, size_t present) {
+            if (!pages->isDictionaryEncoded()) {
+                pages->readPlain(dest, present);
+                return;
+            }
+
+            if (this->state->indices.size() < present) {
+                this->state->indices.resize(present);
+            }
+            pages->readIndices(this->state->indices.data(), present);
+            const T *dictionary = pages->template getDictionary<T>();
+            uint32_t dictionarySize = pages->getDictionarySize();
+            for (size_t i = 0; i < present; i++) {
+                uint32_t index = this->state->indices[i];
+                if (index >= dictionarySize) {
+                    throw runtime_error("Dictionary index out of range");
+                }
+                dest[i] = dictionary[index];
+            }
+        });
+    }
+
+    template<>
+    size_t ColumnChunk::Reader::readBatch(Date *out, size_t n, uint8_t *validBits) {
+        PageReader *pages = this->getPages();
+        return this->readValues(out, n, validBits, [this, pages](Date *dest, size_t present) {
+            if (!pages->isDictionaryEncoded()) {
+                if (this->state->byteArrays.size() < present) {
+                    this->state->byteArrays.resize(present);
+                }
+                pages->readPlain(this->state->byteArrays.data(), present);
+                parseDates(this->state->byteArrays.data(), dest, present);
+                return;
+            }
+
+            uint32_t dictionarySize = pages->getDictionarySize();
+            if (this->state->dateDictionary.size() != dictionarySize) {
+                this->state->dateDictionary.resize(dictionarySize);
+                parseDates(pages->getDictionary<ByteArray>(), this->state->dateDictionary.data(), dictionarySize);
+            }
+
+            if (this->state->indices.size() < present) {
+                this->state->indices.resize(present);
+            }
+            pages->readIndices(this->state->indices.data(), present);
+            for (size_t i = 0; i < present; i++) {
+                uint32_t index = this->state->indices[i];
+                if (index >= dictionarySize) {
+                    throw runtime_error("Dictionary index out of range");
+                }
+                dest[i] = this->state->dateDictionary[index];
+            }
+        });
+    }
+
+    size_t ColumnChunk::Reader::readCodes(uint32_t *codes, size_t n, uint8_t *validBits) {
+        PageReader *pages = this->getPages();
+        return this->readValues(codes, n, validBits, [pages](uint32_t *dest, size_t present) {
+            if (!pages->isDictionaryEncoded()) {
+                throw runtime_error("readCodes() on a page that is not dictionary encoded");
+            }
+            pages->readIndices(dest, present);
+            uint32_t dictionarySize = pages->getDictionarySize();
+            for (size_t i = 0; i < present; i++) {
+                if (dest[i] >= dictionarySize) {
+                    throw runtime_error("Dictionary index out of range");
+                }
+            }
+        });
+    }
+
+    size_t ColumnChunk::Reader::pageValuesLeft() {
+        return this->getPages()->valuesLeft();
+    }
+
+    template<typename T>
+    size_t ColumnChunk::Reader::skipPages(const T &lower, const T &upper) {
+        PageReader *pages = this->getPages();
+        if (pages->valuesLeft() > 0) {
+            return 0;
+        }
+
+        size_t skipped = 0;
+        while (const parquet::PageHeader *header = pages->peekDataPage()) {
+            auto &dataPageHeader = header->data_page_header;
+            if (!dataPageHeader.__isset.statistics ||
+                pruning::mayContain(dataPageHeader.statistics, lower, upper)) {
+                break;
+            }
+            skipped += dataPageHeader.num_values;
+            pruning::pageSkipped(header->compressed_page_size);
+            pages->skipPage();
+        }
+        pages->nextPage();
+        this->position += skipped;
+        return skipped;
+    }
+
+    template size_t ColumnChunk::Reader::skipPages(const int32_t &lower, const int32_t &upper);
+    template size_t ColumnChunk::Reader::skipPages(const int64_t &lower, const int64_t &upper);
+    template size_t ColumnChunk::Reader::skipPages(const double &lower, const double &upper);
+    template size_t ColumnChunk::Reader::skipPages(const Date &lower, const Date &upper);
+
+    void ColumnChunk::Reader::skip(size_t n) {
+        this->getPages()->skip(n);
+        this->position += n;
+    }
+
+    void ColumnChunk::Reader::releasePages() {
+        this->getPages()->releaseRetired();
+    }
+
+    shared_ptr<DecompressedPages> ColumnChunk::Reader::decompressAhead(Arena &arena) {
+        if (this->metaData->codec == parquet::CompressionCodec::UNCOMPRESSED) {
+            return nullptr;
+        }
+        PageReader *pages = this->getPages();
+        auto decompressed = make_shared<DecompressedPages>(pages->getPosition(), pages->getEnd(),
+                                                           this->metaData->codec, arena);
+        pages->decompressAhead(decompressed);
+        return decompressed;
+    }
+
+    void ColumnChunk::Reader::seek(size_t position) {
+        if (position < this->position) {
+            // Start over, the pages can only be walked forwards
+            this->getPages()->reset(this->columnBuffer, this->columnLength, this->metaData, this->schema);
+            this->position = 0;
+        }
+        this->skip(position - this->position);
+    }
+
+    bool ColumnChunk::Reader::isDictionaryEncoded() {
+        return this->getPages()->allPagesDictionaryEncoded();
+    }
+
+    template<typename T>
+    const T *ColumnChunk::Reader::getDictionary(size_t *size) {
+        PageReader *pages = this->getPages();
+        // The dictionary page precedes the first data page
+        if (pages->valuesLeft() == 0) {
+            pages->nextPage();
+        }
+        if (pages->getDictionarySize() == 0 && !this->isDictionaryEncoded()) {
+            throw runtime_error("Column chunk has no dictionary");
+        }
+        *size = pages->getDictionarySize();
+        return pages->template getDictionary<T>();
+    }
+
+    template size_t ColumnChunk::Reader::readBatch(int32_t *out, size_t n, uint8_t *validBits);
+    template size_t ColumnChunk::Reader::readBatch(int64_t *out, size_t n, uint8_t *validBits);
+    template size_t ColumnChunk::Reader::readBatch(float *out, size_t n, uint8_t *validBits);
+    template size_t ColumnChunk::Reader::readBatch(double *out, size_t n, uint8_t *validBits);
+    template size_t ColumnChunk::Reader::readBatch(ByteArray *out, size_t n, uint8_t *validBits);
+
+    template const int32_t *ColumnChunk::Reader::getDictionary(size_t *size);
+    template const int64_t *ColumnChunk::Reader::getDictionary(size_t *size);
+    template const float *ColumnChunk::Reader::getDictionary(size_t *size);
+    template const double *ColumnChunk::Reader::getDictionary(size_t *size);
+    template const ByteArray *ColumnChunk::Reader::getDictionary(size_t *size);
+
     template<>
     string ColumnChunk::Reader::read() {
         int defLevel, repLevel;
-        ByteArray byteArray = this->columnReader->GetByteArray(&defLevel, &repLevel);
+        ByteArray byteArray = this->getColumnReader()->GetByteArray(&defLevel, &repLevel);
         assert(defLevel >= repLevel);
         return string(reinterpret_cast<const char *>(byteArray.ptr), byteArray.len);
     }
@@ -37,15 +311,20 @@ namespace benchmark {
     template<>
     ByteArray ColumnChunk::Reader::read() {
         int defLevel, repLevel;
-        auto val = this->columnReader->GetByteArray(&defLevel, &repLevel);
+        auto val = this->getColumnReader()->GetByteArray(&defLevel, &repLevel);
         assert(defLevel >= repLevel);
         return val;
     }
 
+    template<>
+    Date ColumnChunk::Reader::read() {
+        return parseDate(this->read<ByteArray>());
+    }
+
     template<>
     double ColumnChunk::Reader::read() {
         int defLevel, repLevel;
-        auto val = this->columnReader->GetDouble(&defLevel, &repLevel);
+        auto val = this->getColumnReader()->GetDouble(&defLevel, &repLevel);
         assert(defLevel >= repLevel);
         return val;
     }
@@ -53,7 +332,7 @@ namespace benchmark {
     template<>
     float ColumnChunk::Reader::read() {
         int defLevel, repLevel;
-        auto val = this->columnReader->GetFloat(&defLevel, &repLevel);
+        auto val = this->getColumnReader()->GetFloat(&defLevel, &repLevel);
         assert(defLevel >= repLevel);
         return val;
     }
@@ -61,7 +340,7 @@ namespace benchmark {
     template<>
     int32_t ColumnChunk::Reader::read() {
         int defLevel, repLevel;
-        auto val = this->columnReader->GetInt32(&defLevel, &repLevel);
+        auto val = this->getColumnReader()->GetInt32(&defLevel, &repLevel);
         assert(defLevel >= repLevel);
         return val;
     }
@@ -69,7 +348,7 @@ namespace benchmark {
     template<>
     int64_t ColumnChunk::Reader::read() {
         int defLevel, repLevel;
-        int64_t val = this->columnReader->GetInt64(&defLevel, &repLevel);
+        int64_t val = this->getColumnReader()->GetInt64(&defLevel, &repLevel);
         assert(defLevel >= repLevel);
         return val;
     }
@@ -77,7 +356,7 @@ namespace benchmark {
     template<>
     bool ColumnChunk::Reader::read() {
         int defLevel, repLevel;
-        auto val = this->columnReader->GetBool(&defLevel, &repLevel);
+        auto val = this->getColumnReader()->GetBool(&defLevel, &repLevel);
         return val;
     }
 
@@ -5,8 +5,14 @@
 #ifndef HDFS_BENCHMARK_COLUMN_H
 #define HDFS_BENCHMARK_COLUMN_H
 
+#include <memory>
+#include <vector>
+
 #include <parquet/parquet.h>
 
+#include "Date.h"
+#include "PageReader.h"
+
 using namespace std;
 using namespace parquet_cpp;
 
@@ -15,6 +21,56 @@ class ParquetFile;
 namespace benchmark {
     class RowGroup;
 
+    /**
+     * Number of values the queries decode per readBatch() call.
+     */
+    const size_t BATCH_SIZE = 2048;
+
+    /**
+     * What a `ColumnChunk::Reader` needs to decode batches: the page reader
+     * with its page and dictionary buffers, and scratch buffers.
+     */
+    struct ReaderState {
+        PageReader pages;
+        vector<uint32_t> levels;
+        vector<uint32_t> indices;
+        vector<ByteArray> byteArrays;
+        vector<Date> dateDictionary;
+    };
+
+    /**
+     * Reader states that were released on a thread, reused by the next
+     * readers created on it, so that reading the row groups of many files
+     * does not allocate once the buffers have grown to the sizes needed.
+     */
+    class ReaderPool {
+    public:
+        /**
+         * Number of states kept at most, more than a scan has columns.
+         */
+        static const size_t MAX_FREE = 64;
+
+        /**
+         * A state reset to the column chunk `[data, data + length)`.
+         */
+        unique_ptr<ReaderState> acquire(const uint8_t *data, size_t length, const parquet::ColumnMetaData *metaData,
+                                        const parquet::SchemaElement *schema);
+
+        void release(unique_ptr<ReaderState> state);
+
+        size_t size() const {
+            return this->free.size();
+        }
+
+        /**
+         * The pool of the calling thread.
+         */
+        static ReaderPool &local();
+
+    private:
+        vector<unique_ptr<ReaderState>> free;
+    };
+
     class ColumnChunk {
     public:
         ColumnChunk(ParquetFile *parquetFile, RowGroup *rowGroup, parquet::ColumnChunk &columnChunk, unsigned int idx) :
@@ -28,48 +84,165 @@ namespace benchmark {
 
             }
             Reader(ColumnChunk *p, parquet::ColumnChunk &columnChunk);
-            Reader(const Reader&& r) : input(r.input), columnReader(r.columnReader), p(r.p) {
+            Reader(Reader&& r) = default;
 
-            }
+            Reader(const Reader &) = delete;
+
+            Reader &operator=(const Reader &) = delete;
+
+            /**
+             * Returns the decoder state to the `ReaderPool` of the thread.
+             */
+            ~Reader();
 
             bool hasNext() {
-                return this->columnReader->HasNext();
+                return this->getColumnReader()->HasNext();
             }
 
             template<typename TR>
             TR read();
 
+            /**
+             * Reads up to `n` values into `out`, decoding whole runs of a page
+             * at a time instead of going through the per-value getters.
+             * Returns the number of values read, which is less than `n` only
+             * at the end of the column chunk.
+             *
+             * Null values are written as `T()`. If `validBits` is given, bit i
+             * is set iff value i is not null (it needs (n + 7) / 8 bytes).
+             *
+             * `ByteArray`s point into the decoded page and stay valid until
+             * the next call of `readBatch`. Don't mix with `read()` on the
+             * same reader.
+             *
+             * `readBatch<Date>()` parses `YYYY-MM-DD` byte arrays, dictionary
+             * entries are parsed once per column chunk.
+             */
+            template<typename T>
+            size_t readBatch(T *out, size_t n, uint8_t *validBits = 0);
+
+            /**
+             * True if every data page of the column chunk is dictionary
+             * encoded, i.e. the writer did not fall back to PLAIN. Only then
+             * `getDictionary()` and `readCodes()` cover the whole chunk.
+             */
+            bool isDictionaryEncoded();
+
+            /**
+             * The dictionary of the column chunk, stores its size in `size`.
+             * Valid as long as the reader.
+             */
+            template<typename T>
+            const T *getDictionary(size_t *size);
+
+            /**
+             * Like `readBatch()`, but reads the dictionary indices instead of
+             * the values they refer to. Nulls get code 0.
+             */
+            size_t readCodes(uint32_t *codes, size_t n, uint8_t *validBits = 0);
+
+            /**
+             * Number of values left in the current page, 0 before the first
+             * page and at page boundaries.
+             */
+            size_t pageValuesLeft();
+
+            /**
+             * At a page boundary, skips the following pages whose statistics
+             * show that none of their values lies in [lower, upper] and
+             * loads the next page. Returns the number of values skipped,
+             * which the caller has to `skip()` in the other columns of the
+             * row group.
+             */
+            template<typename T>
+            size_t skipPages(const T &lower, const T &upper);
+
+            /**
+             * Skips `n` values, whole pages without decompressing them.
+             */
+            void skip(size_t n);
+
+            /**
+             * With `holdPages(true)`, `ByteArray`s stay valid until
+             * `releasePages()` instead of the next `readBatch()`, e.g. to
+             * fill one batch with several calls.
+             */
+            void holdPages(bool hold) {
+                this->pagesHeld = hold;
+            }
+
+            void releasePages();
+
+            /**
+             * Decompresses the remaining pages into `arena` ahead of the
+             * reader once they are submitted to a `DecompressionPool`.
+             * Returns null for uncompressed column chunks.
+             */
+            shared_ptr<DecompressedPages> decompressAhead(Arena &arena);
+
+            /**
+             * Moves to the value at `position` of the column chunk. Seeking
+             * backwards decodes the chunk from its start.
+             */
+            void seek(size_t position);
+
+            /**
+             * Position of the next value read by `readBatch()`,
+             * `readCodes()` or `skip()`.
+             */
+            size_t getPosition() {
+                return this->position;
+            }
+
             string readString(size_t readString = 15);
 
             unsigned getIdx() {
                 return this->p->idx;
             }
 
-            /*~Reader() {
-                if(this->input) {
-                    delete input;
-                }
-                if(this->columnReader) {
-                    delete columnReader;
-                }
-            }*/
-
         private:
+            PageReader *getPages();
+
+            ColumnReader *getColumnReader();
+
+            template<typename T, typename Decode>
+            size_t readValues(T *out, size_t n, uint8_t *validBits, Decode decode);
+
             ColumnChunk *p = 0;
-            InMemoryInputStream *input = 0;
-            ColumnReader *columnReader = 0;
+            // Only created for read<T>() and hasNext()
+            unique_ptr<InMemoryInputStream> input;
+            unique_ptr<ColumnReader> columnReader;
+
+            const uint8_t *columnBuffer = 0;
+            size_t columnLength = 0;
+            const parquet::ColumnMetaData *metaData = 0;
+            const parquet::SchemaElement *schema = 0;
+            unique_ptr<ReaderState> state;
+            size_t position = 0;
+            bool pagesHeld = false;
         };
 
         ColumnChunk::Reader getReader() {
             return Reader(this, this->columnChunk);
         }
 
+        /**
+         * The column chunk's statistics, or null if it has none.
+         */
+        const parquet::Statistics *getStatistics() {
+            auto &metaData = this->columnChunk.meta_data;
+            return metaData.__isset.statistics ? &metaData.statistics : 0;
+        }
+
     private:
         parquet::ColumnChunk &columnChunk;
         ParquetFile *parquetFile;
         RowGroup *rowGroup;
         unsigned int idx;
     };
+
+    template<>
+    size_t ColumnChunk::Reader::readBatch(Date *out, size_t n, uint8_t *validBits);
 };
 
 using namespace benchmark;
@@ -0,0 +1,184 @@
+#include "Compression.h"
+
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <snappy.h>
+#include <zlib.h>
+
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#endif
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace benchmark {
+    /**
+     * Inflate state of a thread, reset for every page instead of being
+     * allocated again.
+     */
+    class Inflater {
+    public:
+        Inflater() {
+            memset(&this->stream, 0, sizeof(this->stream));
+            // 15 window bits, +32 detects zlib and gzip headers
+            if (inflateInit2(&this->stream, 15 + 32) != Z_OK) {
+                throw std::runtime_error("inflateInit2 failed");
+            }
+        }
+
+        ~Inflater() {
+            inflateEnd(&this->stream);
+        }
+
+        void inflate(const uint8_t *in, size_t inLength, uint8_t *out, size_t outLength) {
+            if (inflateReset(&this->stream) != Z_OK) {
+                throw std::runtime_error("inflateReset failed");
+            }
+            this->stream.next_in = const_cast<Bytef *>(in);
+            this->stream.avail_in = inLength;
+            this->stream.next_out = out;
+            this->stream.avail_out = outLength;
+            int r = ::inflate(&this->stream, Z_FINISH);
+            if (r != Z_STREAM_END || this->stream.total_out != outLength) {
+                throw std::runtime_error("Corrupt GZIP page");
+            }
+        }
+
+    private:
+        z_stream stream;
+    };
+
+    static void inflateGzip(const uint8_t *in, size_t inLength, uint8_t *out, size_t outLength) {
+        static thread_local Inflater inflater;
+        inflater.inflate(in, inLength, out, outLength);
+    }
+
+#ifdef HAVE_LZ4
+    static uint32_t readBigEndian(const uint8_t *p) {
+        return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+    }
+
+    static void decompressLz4(const uint8_t *in, size_t inLength, uint8_t *out, size_t outLength) {
+        int length = LZ4_decompress_safe(reinterpret_cast<const char *>(in), reinterpret_cast<char *>(out),
+                                         inLength, outLength);
+        if (length >= 0 && (size_t) length == outLength) {
+            return;
+        }
+
+        // parquet-mr writes LZ4 in Hadoop's framing: blocks prefixed with
+        // their big endian uncompressed and compressed length
+        size_t written = 0;
+        while (inLength >= 8 && written < outLength) {
+            uint32_t blockLength = readBigEndian(in);
+            uint32_t compressedLength = readBigEndian(in + 4);
+            if (compressedLength > inLength - 8 || blockLength > outLength - written) {
+                break;
+            }
+            length = LZ4_decompress_safe(reinterpret_cast<const char *>(in + 8),
+                                         reinterpret_cast<char *>(out + written), compressedLength, blockLength);
+            if (length < 0 || (uint32_t) length != blockLength) {
+                break;
+            }
+            in += 8 + compressedLength;
+            inLength -= 8 + compressedLength;
+            written += blockLength;
+        }
+        if (written != outLength || inLength != 0) {
+            throw std::runtime_error("Corrupt LZ4 page");
+        }
+    }
+#endif
+
+#ifdef HAVE_ZSTD
+    class ZstdContext {
+    public:
+        ZstdContext() : context(ZSTD_createDCtx()) {
+            if (this->context == 0) {
+                throw std::runtime_error("ZSTD_createDCtx failed");
+            }
+        }
+
+        ~ZstdContext() {
+            ZSTD_freeDCtx(this->context);
+        }
+
+        ZSTD_DCtx *context;
+    };
+
+    static void decompressZstd(const uint8_t *in, size_t inLength, uint8_t *out, size_t outLength) {
+        static thread_local ZstdContext context;
+        size_t length = ZSTD_decompressDCtx(context.context, out, outLength, in, inLength);
+        if (ZSTD_isError(length) || length != outLength) {
+            throw std::runtime_error("Corrupt ZSTD page");
+        }
+    }
+#endif
+
+    void decompress(parquet::CompressionCodec::type codec, const uint8_t *in, size_t inLength,
+                    uint8_t *out, size_t outLength) {
+        auto start = std::chrono::steady_clock::now();
+
+        switch ((int) codec) {
+            case parquet::CompressionCodec::UNCOMPRESSED:
+                if (inLength != outLength) {
+                    throw std::runtime_error("Corrupt uncompressed page");
+                }
+                memcpy(out, in, inLength);
+                break;
+            case parquet::CompressionCodec::SNAPPY: {
+                size_t length = 0;
+                if (!snappy::GetUncompressedLength(reinterpret_cast<const char *>(in), inLength, &length) ||
+                    length != outLength ||
+                    !snappy::RawUncompress(reinterpret_cast<const char *>(in), inLength,
+                                           reinterpret_cast<char *>(out))) {
+                    throw std::runtime_error("Corrupt SNAPPY page");
+                }
+                break;
+            }
+            case parquet::CompressionCodec::GZIP:
+                inflateGzip(in, inLength, out, outLength);
+                break;
+#ifdef HAVE_LZ4
+            case CODEC_LZ4:
+                decompressLz4(in, inLength, out, outLength);
+                break;
+#endif
+#ifdef HAVE_ZSTD
+            case CODEC_ZSTD:
+                decompressZstd(in, inLength, out, outLength);
+                break;
+#endif
+            default:
+                throw std::runtime_error("Unsupported compression codec " + std::string(codecName(codec)));
+        }
+
+        auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        decompression::page(codec, inLength, outLength, nanos.count());
+    }
+
+    const char *codecName(int codec) {
+        switch (codec) {
+            case parquet::CompressionCodec::UNCOMPRESSED:
+                return "UNCOMPRESSED";
+            case parquet::CompressionCodec::SNAPPY:
+                return "SNAPPY";
+            case parquet::CompressionCodec::GZIP:
+                return "GZIP";
+            case parquet::CompressionCodec::LZO:
+                return "LZO";
+            case CODEC_BROTLI:
+                return "BROTLI";
+            case CODEC_LZ4:
+                return "LZ4";
+            case CODEC_ZSTD:
+                return "ZSTD";
+            default:
+                return "unknown";
+        }
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef HDFS_BENCHMARK_COMPRESSION_H
+#define HDFS_BENCHMARK_COMPRESSION_H
+
+#include <atomic>
+#include <cstdio>
+
+#include <parquet/parquet.h>
+
+#include <stdint.h>
+
+namespace benchmark {
+    /**
+     * Codecs added to parquet-format after the thrift definitions bundled
+     * with parquet-cpp, by their value in `CompressionCodec`.
+     */
+    const int CODEC_BROTLI = 4;
+    const int CODEC_LZ4 = 5;
+    const int CODEC_ZSTD = 6;
+
+    /**
+     * Decompresses `inLength` bytes at `in` compressed with `codec` into
+     * exactly `outLength` bytes at `out`. Throws on corrupt input or an
+     * unsupported codec. LZ4 and ZSTD are only supported when built with
+     * HAVE_LZ4 and HAVE_ZSTD.
+     */
+    void decompress(parquet::CompressionCodec::type codec, const uint8_t *in, size_t inLength,
+                    uint8_t *out, size_t outLength);
+
+    const char *codecName(int codec);
+};
+
+/**
+ * Counters of the bytes and time spent per codec in `decompress()`, and of
+ * the time consumers waited for pages decompressed ahead of them.
+ */
+namespace decompression {
+    const int CODECS = 7;
+
+    struct Counters {
+        std::atomic<uint64_t> pages[CODECS];
+        std::atomic<uint64_t> compressedBytes[CODECS];
+        std::atomic<uint64_t> bytes[CODECS];
+        std::atomic<uint64_t> nanos[CODECS];
+        std::atomic<uint64_t> waits{0};
+        std::atomic<uint64_t> waitNanos{0};
+        std::atomic<uint64_t> cancelled{0};
+
+        Counters() {
+            for (int i = 0; i < CODECS; i++) {
+                pages[i] = 0;
+                compressedBytes[i] = 0;
+                bytes[i] = 0;
+                nanos[i] = 0;
+            }
+        }
+    };
+
+    inline Counters &counters() {
+        static Counters counters;
+        return counters;
+    }
+
+    inline void page(int codec, uint64_t compressedBytes, uint64_t bytes, uint64_t nanos) {
+        if (codec < 0 || codec >= CODECS) {
+            return;
+        }
+        Counters &c = counters();
+        c.pages[codec]++;
+        c.compressedBytes[codec] += compressedBytes;
+        c.bytes[codec] += bytes;
+        c.nanos[codec] += nanos;
+    }
+
+    /**
+     * A consumer waited `nanos` for a page another thread was decompressing.
+     */
+    inline void waited(uint64_t nanos) {
+        counters().waits++;
+        counters().waitNanos += nanos;
+    }
+
+    /**
+     * A page queued for decompression was skipped before it was started.
+     */
+    inline void cancelled() {
+        counters().cancelled++;
+    }
+
+    inline void print(FILE *out = stderr) {
+        Counters &c = counters();
+        for (int codec = 1; codec < CODECS; codec++) {
+            if (c.pages[codec] == 0) {
+                continue;
+            }
+            double seconds = c.nanos[codec] / 1e9;
+            fprintf(out, "decompression: %s %lu pages, %.1f MB -> %.1f MB, %.1f MB/s\n",
+                    benchmark::codecName(codec), (unsigned long) c.pages[codec],
+                    c.compressedBytes[codec] / (1024.0 * 1024.0), c.bytes[codec] / (1024.0 * 1024.0),
+                    seconds > 0 ? c.bytes[codec] / (1024.0 * 1024.0) / seconds : 0.0);
+        }
+        if (c.waits > 0 || c.cancelled > 0) {
+            fprintf(out, "decompression: consumers waited %lu times, %.1f ms, %lu queued pages skipped\n",
+                    (unsigned long) c.waits, c.waitNanos / 1e6, (unsigned long) c.cancelled);
+        }
+    }
+}
+
+#endif //HDFS_BENCHMARK_COMPRESSION_H
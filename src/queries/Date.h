@@ -0,0 +1,128 @@
+#ifndef HDFS_BENCHMARK_DATE_H
+#define HDFS_BENCHMARK_DATE_H
+
+#include <stdexcept>
+#include <string>
+
+#include <stdint.h>
+#include <string.h>
+
+#include <parquet/parquet.h>
+
+#if defined(__SSSE3__) && defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+
+using namespace parquet_cpp;
+
+namespace benchmark {
+    /**
+     * A date packed as the integer YYYYMMDD, e.g. 19980811, so that dates
+     * compare like integers.
+     */
+    struct Date {
+        uint32_t value = 0;
+
+        Date() {
+        }
+
+        explicit Date(uint32_t value) : value(value) {
+        }
+
+        bool operator<(const Date &other) const {
+            return this->value < other.value;
+        }
+    };
+
+    /**
+     * Parses a `YYYY-MM-DD` byte array.
+     */
+    inline Date parseDate(const ByteArray &byteArray) {
+        const uint8_t *s = byteArray.ptr;
+        if (byteArray.len != 10 || s[4] != '-' || s[7] != '-') {
+            throw std::runtime_error("Invalid date: " +
+                                     std::string(reinterpret_cast<const char *>(s), byteArray.len));
+        }
+        uint32_t value = 0;
+        for (unsigned i = 0; i < 10; i++) {
+            if (i == 4 || i == 7) {
+                continue;
+            }
+            uint32_t digit = s[i] - '0';
+            if (digit > 9) {
+                throw std::runtime_error("Invalid date: " +
+                                         std::string(reinterpret_cast<const char *>(s), byteArray.len));
+            }
+            value = value * 10 + digit;
+        }
+        return Date(value);
+    }
+
+#if defined(__SSSE3__) && defined(__SSE4_1__)
+    /**
+     * Converts the `YYYY-MM-DD` string to digits, i.e. 0..9 in the digit
+     * and 0 in the separator bytes of a valid date. Doesn't read past the
+     * end of the byte array.
+     */
+    inline __m128i loadDate(const ByteArray &byteArray) {
+        uint64_t low;
+        uint16_t high;
+        memcpy(&low, byteArray.ptr, 8);
+        memcpy(&high, byteArray.ptr + 8, 2);
+        // Turn '-' into '0', so that the separators become 0 below
+        const __m128i separators = _mm_setr_epi8(0, 0, 0, 0, '-' ^ '0', 0, 0, '-' ^ '0', 0, 0, 0, 0, 0, 0, 0, 0);
+        __m128i v = _mm_xor_si128(_mm_set_epi64x(high, low), separators);
+        return _mm_sub_epi8(v, _mm_set1_epi8('0'));
+    }
+#endif
+
+    /**
+     * Parses `n` `YYYY-MM-DD` byte arrays, two dates per SSE register.
+     * Throws for byte arrays of other lengths or formats.
+     */
+    inline void parseDates(const ByteArray *in, Date *out, size_t n) {
+        size_t i = 0;
+#if defined(__SSSE3__) && defined(__SSE4_1__)
+        // Upper bound of each byte: 9 for digits, 0 for separators, anything
+        // beyond the 10th byte
+        const __m128i bounds = _mm_setr_epi8(9, 9, 9, 9, 0, 9, 9, 0, 9, 9, -1, -1, -1, -1, -1, -1);
+        // Y Y Y Y - M M - D D -> Y Y Y Y M M D D
+        const __m128i digitsOnly = _mm_setr_epi8(0, 1, 2, 3, 5, 6, 8, 9, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i tens = _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1);
+        const __m128i hundreds = _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1);
+        const __m128i years = _mm_setr_epi32(10000, 1, 10000, 1);
+
+        // Validate the whole batch at once instead of branching per date
+        __m128i valid = _mm_set1_epi8(-1);
+        bool lengths = true;
+        for (; i + 2 <= n; i += 2) {
+            // Shorter byte arrays could end at the end of the page
+            if (in[i].len != 10 || in[i + 1].len != 10) {
+                lengths = false;
+                break;
+            }
+            __m128i a = loadDate(in[i]), b = loadDate(in[i + 1]);
+            valid = _mm_and_si128(valid, _mm_cmpeq_epi8(_mm_max_epu8(a, bounds), bounds));
+            valid = _mm_and_si128(valid, _mm_cmpeq_epi8(_mm_max_epu8(b, bounds), bounds));
+
+            // [Y Y Y Y M M D D] -> [YY YY MM DD] -> [YYYY MMDD] -> YYYYMMDD
+            __m128i digits = _mm_unpacklo_epi64(_mm_shuffle_epi8(a, digitsOnly), _mm_shuffle_epi8(b, digitsOnly));
+            __m128i pairs = _mm_maddubs_epi16(digits, tens);
+            __m128i parts = _mm_mullo_epi32(_mm_madd_epi16(pairs, hundreds), years);
+            __m128i dates = _mm_hadd_epi32(parts, parts);
+            out[i].value = _mm_cvtsi128_si32(dates);
+            out[i + 1].value = _mm_extract_epi32(dates, 1);
+        }
+
+        // Let the scalar path report the first invalid date
+        if (!lengths || _mm_movemask_epi8(valid) != 0xFFFF) {
+            i = 0;
+        }
+#endif
+        for (; i < n; i++) {
+            out[i] = parseDate(in[i]);
+        }
+    }
+};
+
+#endif //HDFS_BENCHMARK_DATE_H
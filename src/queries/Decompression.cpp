@@ -0,0 +1,195 @@
+#include "Decompression.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#include "Compression.h"
+#include "PageHeader.h"
+#include "Trace.h"
+
+namespace benchmark {
+    DecompressedPages::DecompressedPages(const uint8_t *begin, const uint8_t *end,
+                                         parquet::CompressionCodec::type codec, Arena &arena) : codec(codec) {
+        struct Header {
+            const uint8_t *page;
+            size_t compressedLength;
+            size_t length;
+        };
+        vector<Header> headers;
+
+        parquet::PageHeader header;
+        const uint8_t *position = begin;
+        while (position < end) {
+            uint32_t headerLength = parsePageHeader(position, end - position, &header);
+
+            const uint8_t *page = position + headerLength;
+            position = page + header.compressed_page_size;
+            if (position > end) {
+                throw runtime_error("Corrupt page: exceeds column chunk");
+            }
+            if (header.type == parquet::PageType::DATA_PAGE || header.type == parquet::PageType::DICTIONARY_PAGE) {
+                headers.push_back(Header{page, (size_t) header.compressed_page_size,
+                                         (size_t) header.uncompressed_page_size});
+            }
+        }
+
+        this->count = headers.size();
+        this->pages.reset(new Page[this->count]);
+        for (size_t i = 0; i < this->count; i++) {
+            Page &page = this->pages[i];
+            page.compressed = headers[i].page;
+            page.compressedLength = headers[i].compressedLength;
+            page.data = arena.allocate(headers[i].length);
+            page.length = headers[i].length;
+            page.state = QUEUED;
+        }
+    }
+
+    DecompressedPages::Page *DecompressedPages::find(const uint8_t *page) {
+        // Pages before `page` were skipped
+        while (this->cursor < this->count && this->pages[this->cursor].compressed < page) {
+            int queued = QUEUED;
+            if (this->pages[this->cursor].state.compare_exchange_strong(queued, CANCELLED)) {
+                decompression::cancelled();
+            }
+            this->cursor++;
+        }
+        if (this->cursor == this->count || this->pages[this->cursor].compressed != page) {
+            return 0;
+        }
+        return &this->pages[this->cursor];
+    }
+
+    const uint8_t *DecompressedPages::get(const uint8_t *page) {
+        Page *p = this->find(page);
+        if (p == 0) {
+            return 0;
+        }
+
+        int queued = QUEUED;
+        if (p->state.compare_exchange_strong(queued, RUNNING)) {
+            this->decompress(*p);
+        } else if (p->state != DONE) {
+            trace::Scoped traced("decompression_wait");
+            auto start = chrono::steady_clock::now();
+            unique_lock<mutex> lock(this->stateMutex);
+            this->stateChanged.wait(lock, [p]() { return p->state == DONE; });
+            decompression::waited(chrono::duration_cast<chrono::nanoseconds>(
+                    chrono::steady_clock::now() - start).count());
+        }
+
+        if (p->error) {
+            rethrow_exception(p->error);
+        }
+        return p->data;
+    }
+
+    void DecompressedPages::skip(const uint8_t *page) {
+        Page *p = this->find(page);
+        int queued = QUEUED;
+        if (p != 0 && p->state.compare_exchange_strong(queued, CANCELLED)) {
+            decompression::cancelled();
+        }
+    }
+
+    void DecompressedPages::cancel() {
+        for (size_t i = 0; i < this->count; i++) {
+            int queued = QUEUED;
+            this->pages[i].state.compare_exchange_strong(queued, CANCELLED);
+        }
+
+        unique_lock<mutex> lock(this->stateMutex);
+        for (size_t i = 0; i < this->count; i++) {
+            Page *p = &this->pages[i];
+            this->stateChanged.wait(lock, [p]() { return p->state != RUNNING; });
+        }
+    }
+
+    void DecompressedPages::run(size_t i) {
+        int queued = QUEUED;
+        if (this->pages[i].state.compare_exchange_strong(queued, RUNNING)) {
+            this->decompress(this->pages[i]);
+        }
+    }
+
+    void DecompressedPages::decompress(Page &page) {
+        try {
+            benchmark::decompress(this->codec, page.compressed, page.compressedLength, page.data, page.length);
+        } catch (...) {
+            page.error = current_exception();
+        }
+
+        {
+            lock_guard<mutex> lock(this->stateMutex);
+            page.state = DONE;
+        }
+        this->stateChanged.notify_all();
+    }
+
+    DecompressionPool::DecompressionPool(unsigned threadCount) {
+        for (unsigned i = 0; i < threadCount; i++) {
+            this->threads.push_back(thread(&DecompressionPool::work, this, i));
+        }
+    }
+
+    DecompressionPool::~DecompressionPool() {
+        {
+            lock_guard<mutex> lock(this->queueMutex);
+            this->stopping = true;
+        }
+        this->queued.notify_all();
+        for (auto &thread : this->threads) {
+            thread.join();
+        }
+    }
+
+    void DecompressionPool::submit(const vector<shared_ptr<DecompressedPages>> &chunks) {
+        {
+            lock_guard<mutex> lock(this->queueMutex);
+            for (size_t i = 0;; i++) {
+                bool added = false;
+                for (auto &chunk : chunks) {
+                    if (i < chunk->size()) {
+                        this->tasks.push_back(Task{chunk, i});
+                        added = true;
+                    }
+                }
+                if (!added) {
+                    break;
+                }
+            }
+        }
+        this->queued.notify_all();
+    }
+
+    void DecompressionPool::work(unsigned idx) {
+        trace::setThreadName("decompress " + to_string(idx));
+
+        while (true) {
+            Task task;
+            {
+                unique_lock<mutex> lock(this->queueMutex);
+                this->queued.wait(lock, [this]() { return this->stopping || !this->tasks.empty(); });
+                if (this->tasks.empty()) {
+                    break;
+                }
+                task = move(this->tasks.front());
+                this->tasks.pop_front();
+            }
+
+            trace::Scoped traced("decompress_page");
+            task.pages->run(task.index);
+        }
+    }
+
+    DecompressionPool *DecompressionPool::get() {
+        static unique_ptr<DecompressionPool> pool([]() {
+            const char *threads = getenv("DECOMPRESSION_THREADS");
+            int count = threads ? atoi(threads) : 0;
+            return count > 0 ? new DecompressionPool(count) : 0;
+        }());
+        return pool.get();
+    }
+}
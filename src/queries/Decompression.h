@@ -0,0 +1,139 @@
+#ifndef HDFS_BENCHMARK_DECOMPRESSION_H
+#define HDFS_BENCHMARK_DECOMPRESSION_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <parquet/parquet.h>
+
+#include <stdint.h>
+
+#include "Arena.h"
+#include "Compression.h"
+
+using namespace std;
+
+namespace benchmark {
+    /**
+     * The pages of a compressed column chunk, decompressed ahead of the
+     * reader by a `DecompressionPool` into an arena. `get()` returns a
+     * decompressed page; if no worker got to it yet, the caller
+     * decompresses it itself, if one is working on it, the caller waits.
+     *
+     * Pages the reader moves past without `get()`, e.g. pages pruned by
+     * their statistics, are not decompressed unless a worker already
+     * started them. The arena must not be reset before `cancel()`.
+     */
+    class DecompressedPages {
+    public:
+        /**
+         * Parses the page headers of the column chunk `[begin, end)` and
+         * allocates the decompressed dictionary and data pages in `arena`.
+         */
+        DecompressedPages(const uint8_t *begin, const uint8_t *end, parquet::CompressionCodec::type codec,
+                          Arena &arena);
+
+        DecompressedPages(const DecompressedPages &) = delete;
+
+        DecompressedPages &operator=(const DecompressedPages &) = delete;
+
+        size_t size() const {
+            return this->count;
+        }
+
+        /**
+         * The decompressed data of the page whose compressed data starts at
+         * `page`, or null if `page` is not a page of the chunk. Pages must
+         * be requested in order.
+         */
+        const uint8_t *get(const uint8_t *page);
+
+        /**
+         * Cancels the page at `page` unless it was started already.
+         */
+        void skip(const uint8_t *page);
+
+        /**
+         * Cancels the pages not started yet and waits for the running ones.
+         */
+        void cancel();
+
+        /**
+         * Decompresses page `i` unless it was started or cancelled already.
+         */
+        void run(size_t i);
+
+    private:
+        enum State {
+            QUEUED, RUNNING, DONE, CANCELLED
+        };
+
+        struct Page {
+            const uint8_t *compressed;
+            size_t compressedLength;
+            uint8_t *data;
+            size_t length;
+            atomic<int> state;
+            exception_ptr error;
+        };
+
+        Page *find(const uint8_t *page);
+
+        void decompress(Page &page);
+
+        parquet::CompressionCodec::type codec;
+        unique_ptr<Page[]> pages;
+        size_t count = 0;
+        size_t cursor = 0;
+
+        mutex stateMutex;
+        condition_variable stateChanged;
+    };
+
+    /**
+     * Threads that decompress the pages of the column chunks a scan reads
+     * ahead of it. Pages of the submitted chunks are queued interleaved, in
+     * the order a scan reading them batch by batch needs them.
+     */
+    class DecompressionPool {
+    public:
+        explicit DecompressionPool(unsigned threadCount);
+
+        ~DecompressionPool();
+
+        DecompressionPool(const DecompressionPool &) = delete;
+
+        DecompressionPool &operator=(const DecompressionPool &) = delete;
+
+        void submit(const vector<shared_ptr<DecompressedPages>> &chunks);
+
+        /**
+         * The pool with `DECOMPRESSION_THREADS` threads, null if the
+         * variable is not set or 0, then readers decompress pages
+         * themselves.
+         */
+        static DecompressionPool *get();
+
+    private:
+        struct Task {
+            shared_ptr<DecompressedPages> pages;
+            size_t index;
+        };
+
+        void work(unsigned idx);
+
+        vector<thread> threads;
+        mutex queueMutex;
+        condition_variable queued;
+        deque<Task> tasks;
+        bool stopping = false;
+    };
+};
+
+#endif //HDFS_BENCHMARK_DECOMPRESSION_H
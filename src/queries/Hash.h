@@ -0,0 +1,34 @@
+#ifndef HDFS_BENCHMARK_HASH_H
+#define HDFS_BENCHMARK_HASH_H
+
+#include <stdint.h>
+
+#ifdef __SSE4_2__
+#include <nmmintrin.h>
+#endif
+
+namespace benchmark {
+    /**
+     * Marks empty slots of hash tables.
+     */
+    const uint32_t NO_ENTRY = ~0u;
+
+    /**
+     * Hash of an integer key with all 64 bits usable, so that tables can
+     * take their slot from the low and their partition from the high bits.
+     */
+    inline uint64_t hashKey(uint64_t key) {
+#ifdef __SSE4_2__
+        return _mm_crc32_u64(0xab1353a8c4190def, key) * 0x9e3779b97f4a7c15ull;
+#else
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdull;
+        key ^= key >> 33;
+        key *= 0xc4ceb9fe1a85ec53ull;
+        key ^= key >> 33;
+        return key;
+#endif
+    }
+};
+
+#endif //HDFS_BENCHMARK_HASH_H
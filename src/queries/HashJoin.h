@@ -0,0 +1,489 @@
+#ifndef HDFS_BENCHMARK_HASHJOIN_H
+#define HDFS_BENCHMARK_HASHJOIN_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <stdint.h>
+
+#include "Hash.h"
+#include "InlineHashTable.h"
+#include "Morsel.h"
+
+using namespace std;
+
+namespace benchmark {
+    /**
+     * How the workers build a `JoinIndex` from the tuples they collected:
+     *
+     * - `SERIAL`: one thread inserts all tuples.
+     * - `MUTEX`: all workers insert their tuples, each insert under one lock.
+     * - `PARTITIONED`: the workers radix-partition their tuples by the high
+     *   bits of the hash, then build the partitions, which own disjoint
+     *   slots, independently and without synchronization.
+     * - `CAS`: all workers insert their tuples concurrently, claiming slots
+     *   with compare-and-swap and prepending to their chains with exchange.
+     */
+    enum class HashBuild {
+        SERIAL, MUTEX, PARTITIONED, CAS
+    };
+
+    inline const char *hashBuildName(HashBuild build) {
+        switch (build) {
+            case HashBuild::SERIAL:
+                return "serial";
+            case HashBuild::MUTEX:
+                return "mutex";
+            case HashBuild::PARTITIONED:
+                return "partitioned";
+            case HashBuild::CAS:
+                return "cas";
+        }
+        return "unknown";
+    }
+
+    inline HashBuild parseHashBuild(const string &name) {
+        for (HashBuild build : {HashBuild::SERIAL, HashBuild::MUTEX, HashBuild::PARTITIONED, HashBuild::CAS}) {
+            if (name == hashBuildName(build)) {
+                return build;
+            }
+        }
+        throw runtime_error("Unknown hash build " + name + ", expected serial, mutex, partitioned or cas");
+    }
+
+    /**
+     * The build strategy set with `HASH_BUILD`, `PARTITIONED` by default.
+     */
+    inline HashBuild hashBuildFromEnvironment() {
+        const char *build = getenv("HASH_BUILD");
+        return build ? parseHashBuild(build) : HashBuild::PARTITIONED;
+    }
+
+    /**
+     * Multimap from integer keys to values of type `V` on the build side of
+     * a hash join. Keys are in a linear probing table whose slots point to
+     * chains of the tuples with that key, the number of tuples is fixed
+     * when the index is created. The table is split into `2^partitionBits`
+     * partitions by the high bits of the hash; probing wraps around within
+     * a partition, so partitions can be built independently.
+     *
+     *     for (uint32_t t = index.find(key); t != NO_ENTRY; t = index.next(t)) {
+     *         use(index.value(t));
+     *     }
+     */
+    template<typename V>
+    class JoinIndex {
+    public:
+        JoinIndex(size_t tupleCount, unsigned partitionBits = 0) :
+                partitionBits(partitionBits), values(new V[tupleCount]), chain(new uint32_t[tupleCount]) {
+            if (tupleCount >= NO_ENTRY) {
+                throw runtime_error("Too many tuples for a join index: " + to_string(tupleCount));
+            }
+            // Partitions get at least 64 slots, so that the few keys of
+            // small ones do not overflow them
+            size_t slotCount = size_t(64) << partitionBits;
+            while (slotCount < 2 * tupleCount) {
+                slotCount *= 2;
+            }
+            this->slotCount = slotCount;
+            this->partitionMask = (this->slotCount >> partitionBits) - 1;
+            // Not initialized, see `clear()`
+            this->slots.reset(new Slot[this->slotCount]);
+        }
+
+        JoinIndex(const JoinIndex &) = delete;
+
+        JoinIndex &operator=(const JoinIndex &) = delete;
+
+        size_t getSlotCount() const {
+            return this->slotCount;
+        }
+
+        /**
+         * Empties the slots in [begin, end), has to be done for all slots
+         * before the first insert.
+         */
+        void clear(size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                this->slots[i].key.store(EMPTY, memory_order_relaxed);
+                this->slots[i].head.store(NO_ENTRY, memory_order_relaxed);
+            }
+        }
+
+        unsigned getPartition(uint64_t hash) const {
+            return this->partitionBits == 0 ? 0 : hash >> (64 - this->partitionBits);
+        }
+
+        /**
+         * Sets the value of tuple `tuple`.
+         */
+        void setValue(uint32_t tuple, const V &value) {
+            this->values[tuple] = value;
+        }
+
+        /**
+         * Adds tuple `tuple` with key `key` and hash `hashKey(key)`. With
+         * `Concurrent` inserts may run on several threads at a time,
+         * otherwise only one thread may insert into a partition at a time.
+         */
+        template<bool Concurrent>
+        void insert(uint64_t key, uint64_t hash, uint32_t tuple) {
+            Slot &slot = this->claim<Concurrent>(key + 1, hash);
+            if (Concurrent) {
+                this->chain[tuple] = slot.head.exchange(tuple, memory_order_relaxed);
+            } else {
+                this->chain[tuple] = slot.head.load(memory_order_relaxed);
+                slot.head.store(tuple, memory_order_relaxed);
+            }
+        }
+
+        /**
+         * The first tuple with key `key`, `NO_ENTRY` if there is none.
+         */
+        uint32_t find(uint64_t key) const {
+            uint64_t stored = key + 1;
+            uint64_t hash = hashKey(key);
+            size_t base = this->getPartition(hash) * (this->partitionMask + 1);
+            size_t pos = hash & this->partitionMask;
+            for (size_t probes = 0; probes <= this->partitionMask; probes++, pos = (pos + 1) & this->partitionMask) {
+                const Slot &slot = this->slots[base + pos];
+                uint64_t k = slot.key.load(memory_order_relaxed);
+                if (k == stored) {
+                    return slot.head.load(memory_order_relaxed);
+                }
+                if (k == EMPTY) {
+                    return NO_ENTRY;
+                }
+            }
+            return NO_ENTRY;
+        }
+
+        uint32_t next(uint32_t tuple) const {
+            return this->chain[tuple];
+        }
+
+        const V &value(uint32_t tuple) const {
+            return this->values[tuple];
+        }
+
+    private:
+        // Keys are stored incremented by one, so that 0 marks empty slots,
+        // the key 2^64 - 1 is not supported
+        static const uint64_t EMPTY = 0;
+
+        struct Slot {
+            atomic<uint64_t> key;
+            atomic<uint32_t> head;
+        };
+
+        template<bool Concurrent>
+        Slot &claim(uint64_t stored, uint64_t hash) {
+            size_t base = this->getPartition(hash) * (this->partitionMask + 1);
+            size_t pos = hash & this->partitionMask;
+            for (size_t probes = 0; probes <= this->partitionMask; probes++, pos = (pos + 1) & this->partitionMask) {
+                Slot &slot = this->slots[base + pos];
+                uint64_t k = slot.key.load(memory_order_relaxed);
+                if (k == stored) {
+                    return slot;
+                }
+                if (k != EMPTY) {
+                    continue;
+                }
+                if (!Concurrent) {
+                    slot.key.store(stored, memory_order_relaxed);
+                    return slot;
+                }
+                // Another thread may claim the slot first, for this or
+                // another key
+                if (slot.key.compare_exchange_strong(k, stored, memory_order_relaxed) || k == stored) {
+                    return slot;
+                }
+            }
+            throw runtime_error("Join index partition " + to_string(this->getPartition(hash)) + " is full");
+        }
+
+        unsigned partitionBits;
+        size_t slotCount;
+        size_t partitionMask;
+        unique_ptr<Slot[]> slots;
+        unique_ptr<V[]> values;
+        unique_ptr<uint32_t[]> chain;
+    };
+
+    /**
+     * Builds a `JoinIndex` of the `(key, value)` pairs collected by the
+     * workers of `pool` with strategy `build`, running the build on the
+     * workers. The tuples of worker `w` get the ids following those of
+     * worker `w - 1`.
+     */
+    template<typename K, typename V>
+    unique_ptr<JoinIndex<V>> buildJoinIndex(MorselPool &pool, PerWorker<vector<pair<K, V>>> &tuples,
+                                            HashBuild build) {
+        unsigned workers = tuples.size();
+        vector<uint32_t> offsets(workers + 1, 0);
+        for (unsigned w = 0; w < workers; w++) {
+            offsets[w + 1] = offsets[w] + tuples[w].size();
+        }
+
+        // A few partitions per worker, so that the partition builds balance
+        unsigned partitionBits = 0;
+        if (build == HashBuild::PARTITIONED) {
+            while ((1u << partitionBits) < 4 * workers) {
+                partitionBits++;
+            }
+        }
+        unique_ptr<JoinIndex<V>> index(new JoinIndex<V>(offsets[workers], partitionBits));
+        JoinIndex<V> &idx = *index;
+
+        if (build == HashBuild::SERIAL) {
+            idx.clear(0, idx.getSlotCount());
+            for (unsigned w = 0; w < workers; w++) {
+                uint32_t tuple = offsets[w];
+                for (auto &t : tuples[w]) {
+                    idx.setValue(tuple, t.second);
+                    idx.template insert<false>(t.first, hashKey(t.first), tuple);
+                    tuple++;
+                }
+            }
+            return index;
+        }
+
+        // Clear the slots in parallel, they are written by all workers
+        size_t slotCount = idx.getSlotCount();
+        for (unsigned w = 0; w < workers; w++) {
+            pool.push([&idx, w, workers, slotCount](unsigned worker) {
+                idx.clear(slotCount * w / workers, slotCount * (w + 1) / workers);
+            });
+        }
+        pool.wait();
+
+        if (build == HashBuild::MUTEX || build == HashBuild::CAS) {
+            mutex indexMutex;
+            for (unsigned w = 0; w < workers; w++) {
+                pool.push([&, w](unsigned worker) {
+                    uint32_t tuple = offsets[w];
+                    for (auto &t : tuples[w]) {
+                        idx.setValue(tuple, t.second);
+                        uint64_t hash = hashKey(t.first);
+                        if (build == HashBuild::CAS) {
+                            idx.template insert<true>(t.first, hash, tuple);
+                        } else {
+                            lock_guard<mutex> lock(indexMutex);
+                            idx.template insert<false>(t.first, hash, tuple);
+                        }
+                        tuple++;
+                    }
+                });
+            }
+            pool.wait();
+            return index;
+        }
+
+        // Partition the tuples of each worker by the partition of their
+        // slot, keeping the hash so that it is computed only once
+        struct Partitioned {
+            uint64_t key;
+            uint64_t hash;
+            uint32_t tuple;
+        };
+        unsigned partitions = 1u << partitionBits;
+        vector<vector<Partitioned>> partitioned(workers);
+        vector<vector<uint32_t>> bounds(workers, vector<uint32_t>(partitions + 1, 0));
+        for (unsigned w = 0; w < workers; w++) {
+            pool.push([&, w](unsigned worker) {
+                vector<uint32_t> &bound = bounds[w];
+                for (auto &t : tuples[w]) {
+                    bound[idx.getPartition(hashKey(t.first)) + 1]++;
+                }
+                for (unsigned p = 0; p < partitions; p++) {
+                    bound[p + 1] += bound[p];
+                }
+
+                vector<uint32_t> position(bound.begin(), bound.end() - 1);
+                partitioned[w].resize(tuples[w].size());
+                uint32_t tuple = offsets[w];
+                for (auto &t : tuples[w]) {
+                    idx.setValue(tuple, t.second);
+                    uint64_t hash = hashKey(t.first);
+                    partitioned[w][position[idx.getPartition(hash)]++] = Partitioned{(uint64_t) t.first, hash, tuple};
+                    tuple++;
+                }
+            });
+        }
+        pool.wait();
+
+        // Partitions own disjoint slots, one worker builds each
+        for (unsigned p = 0; p < partitions; p++) {
+            pool.push([&, p](unsigned worker) {
+                for (unsigned w = 0; w < workers; w++) {
+                    for (uint32_t i = bounds[w][p]; i < bounds[w][p + 1]; i++) {
+                        const Partitioned &t = partitioned[w][i];
+                        idx.template insert<false>(t.key, t.hash, t.tuple);
+                    }
+                }
+            });
+        }
+        pool.wait();
+        return index;
+    }
+
+    /**
+     * Index of the build side of a hash join in compressed sparse row
+     * layout: the values of all tuples are in one array, ordered by key,
+     * and an `InlineHashTable` maps each key to the range of its values.
+     * A probe reads one contiguous slice per matching key instead of
+     * following a chain of tuples. Built by `buildCsrIndex()`.
+     */
+    template<typename V>
+    class CsrIndex {
+    public:
+        struct Range {
+            uint32_t begin;
+            uint32_t end;
+        };
+
+        CsrIndex(size_t keyCount, size_t tupleCount, unsigned partitionBits) :
+                ranges(keyCount, partitionBits), values(new V[tupleCount]) {
+
+        }
+
+        /**
+         * Calls `f(begin, end)` with the values [begin, end) of `key` if it
+         * is in the index.
+         */
+        template<typename F>
+        void find(uint32_t key, F f) const {
+            const Range *range = this->ranges.find(key);
+            if (range != 0) {
+                f(this->values.get() + range->begin, this->values.get() + range->end);
+            }
+        }
+
+        /**
+         * Calls `f(i, begin, end)` with the values [begin, end) of key
+         * `keys[i]` for every `i` in `selection[0, count)` whose key is in
+         * the index, see `InlineHashTable::findBatch()`.
+         */
+        template<typename K, typename F>
+        void findBatch(const K *keys, const uint32_t *selection, size_t count, F f) const {
+            const V *values = this->values.get();
+            this->ranges.findBatch(keys, selection, count, [&](uint32_t i, const Range &range) {
+                f(i, values + range.begin, values + range.end);
+            });
+        }
+
+        InlineHashTable<Range> ranges;
+        unique_ptr<V[]> values;
+    };
+
+    /**
+     * Builds a `CsrIndex` of the `(key, value)` pairs collected by the
+     * workers of `pool` in two passes, on the workers: the workers
+     * radix-partition their tuples like the `PARTITIONED` build of
+     * `buildJoinIndex()`, then each partition counts the tuples per key,
+     * turns the counts into ranges by a prefix sum, and scatters its
+     * values into their ranges. Partitions own disjoint groups of the
+     * table and a range of the values, so they need no synchronization.
+     */
+    template<typename K, typename V>
+    unique_ptr<CsrIndex<V>> buildCsrIndex(MorselPool &pool, PerWorker<vector<pair<K, V>>> &tuples) {
+        typedef typename CsrIndex<V>::Range Range;
+        unsigned workers = tuples.size();
+        size_t tupleCount = 0;
+        for (unsigned w = 0; w < workers; w++) {
+            tupleCount += tuples[w].size();
+        }
+        if (tupleCount >= NO_ENTRY) {
+            throw runtime_error("Too many tuples for a join index: " + to_string(tupleCount));
+        }
+
+        unsigned partitionBits = 0;
+        while ((1u << partitionBits) < 4 * workers) {
+            partitionBits++;
+        }
+        unsigned partitions = 1u << partitionBits;
+        // The number of keys is not known yet, there are at most as many
+        // as tuples
+        unique_ptr<CsrIndex<V>> index(new CsrIndex<V>(tupleCount, tupleCount, partitionBits));
+        InlineHashTable<Range> &ranges = index->ranges;
+        V *values = index->values.get();
+
+        struct Partitioned {
+            uint32_t key;
+            uint64_t hash;
+            V value;
+        };
+        vector<vector<Partitioned>> partitioned(workers);
+        vector<vector<uint32_t>> bounds(workers, vector<uint32_t>(partitions + 1, 0));
+        for (unsigned w = 0; w < workers; w++) {
+            pool.push([&, w](unsigned worker) {
+                vector<uint32_t> &bound = bounds[w];
+                for (auto &t : tuples[w]) {
+                    bound[ranges.getPartition(hashKey((uint32_t) t.first)) + 1]++;
+                }
+                for (unsigned p = 0; p < partitions; p++) {
+                    bound[p + 1] += bound[p];
+                }
+
+                vector<uint32_t> position(bound.begin(), bound.end() - 1);
+                partitioned[w].resize(tuples[w].size());
+                for (auto &t : tuples[w]) {
+                    uint64_t hash = hashKey((uint32_t) t.first);
+                    partitioned[w][position[ranges.getPartition(hash)]++] = Partitioned{(uint32_t) t.first, hash,
+                                                                                        t.second};
+                }
+            });
+        }
+        pool.wait();
+
+        // The values of partition p start after those of partitions < p
+        vector<uint32_t> partitionBegin(partitions + 1, 0);
+        for (unsigned p = 0; p < partitions; p++) {
+            partitionBegin[p + 1] = partitionBegin[p];
+            for (unsigned w = 0; w < workers; w++) {
+                partitionBegin[p + 1] += bounds[w][p + 1] - bounds[w][p];
+            }
+        }
+
+        for (unsigned p = 0; p < partitions; p++) {
+            pool.push([&, p](unsigned worker) {
+                ranges.clear(ranges.getPartitionBegin(p), ranges.getPartitionEnd(p));
+
+                // Count the tuples per key in `end`
+                for (unsigned w = 0; w < workers; w++) {
+                    for (uint32_t i = bounds[w][p]; i < bounds[w][p + 1]; i++) {
+                        ranges.insert(partitioned[w][i].key, partitioned[w][i].hash).end++;
+                    }
+                }
+
+                // Prefix sum of the counts, `end` is the scatter position
+                uint32_t position = partitionBegin[p];
+                ranges.forEach(ranges.getPartitionBegin(p), ranges.getPartitionEnd(p),
+                               [&](uint32_t key, Range &range) {
+                                   range.begin = position;
+                                   position += range.end;
+                                   range.end = range.begin;
+                               });
+
+                for (unsigned w = 0; w < workers; w++) {
+                    for (uint32_t i = bounds[w][p]; i < bounds[w][p + 1]; i++) {
+                        const Partitioned &t = partitioned[w][i];
+                        values[ranges.insert(t.key, t.hash).end++] = t.value;
+                    }
+                }
+            });
+        }
+        pool.wait();
+        return index;
+    }
+};
+
+#endif //HDFS_BENCHMARK_HASHJOIN_H
@@ -14,7 +14,6 @@
 #include <iostream>
 #include <unordered_map>
 
-#include <boost/log/trivial.hpp>
 #include <boost/thread.hpp>
 #include <boost/atomic/atomic.hpp>
 
@@ -25,6 +24,10 @@
 #include "Block.h"
 #include "PriorityQueue.h"
 #include "expect.h"
+#include "Latency.h"
+#include "PerfCounters.h"
+#include "Trace.h"
+#include "BinaryLog.h"
 
 using namespace std;
 
@@ -143,6 +146,7 @@ public:
         boost::thread_group consumers;
         for(unsigned int i=0; i<consumerCount; i++) {
             consumers.create_thread([i, &blockCount, &consumedBlocks, this, &func]() {
+                trace::setThreadName("consumer " + to_string(i));
                 //uint32_t lastBlock = -1;
 
                 while (true) {
@@ -174,9 +178,11 @@ public:
                     {
                         unique_lock<mutex> lock(blocksMutex);
                         if (loadedBlocks.size() == 0) {
-                            BOOST_LOG_TRIVIAL(debug) << "Thread-" << i << " sleeping";
+                            BLOG_DEBUG("Thread-%u sleeping", i);
+                            trace::begin("sleep");
                             cv.wait(lock);
-                            BOOST_LOG_TRIVIAL(debug) << "Thread-" << i << " woken up";
+                            trace::end("sleep");
+                            BLOG_DEBUG("Thread-%u woken up", i);
                         }
 
                         if (blockCount == consumedBlocks) {
@@ -184,20 +190,27 @@ public:
                         } else if(loadedBlocks.size() > 0) {
                             block = new Block(loadedBlocks.pop());
                             consumedBlocks++;
+                            trace::instant("queue_pop");
+                            latency::record(latency::QueueWait, latency::now() - block->loadedAt);
                         }
                     }
 
                     if (func && block != 0) {
-                        func(*block);
-                        BOOST_LOG_TRIVIAL(debug) << "Thread-" << i << " finished work";
+                        {
+                            latency::Scoped processing(latency::BlockProcessing);
+                            perf::Phase phase("consume", block->fileInfo.mSize);
+                            trace::Scoped traced("consume");
+                            func(*block);
+                        }
+                        BLOG_DEBUG("Thread-%u finished work", i);
                     } else if(block == 0) {
-                        BOOST_LOG_TRIVIAL(debug) << "Thread-" << i << " found block == 0";
+                        BLOG_DEBUG("Thread-%u found block == 0", i);
                     }
 
 
                     delete block;
                 }
-                BOOST_LOG_TRIVIAL(debug) << "Thread-" << i << " finishing";
+                BLOG_DEBUG("Thread-%u finishing", i);
             });
         }
 
@@ -267,7 +280,8 @@ private:
     }
 
     void reader(string host) {
-        BOOST_LOG_TRIVIAL(debug) << "Thread-" << host << " starting";
+        BLOG_DEBUG("Thread-%s starting", host);
+        trace::setThreadName("reader " + host);
 
         struct hdfsBuilder *hdfsBuilder = hdfsNewBuilder();
         hdfsFS fs = connect(hdfsBuilder);
@@ -300,16 +314,17 @@ private:
                 }
 
                 if (downloadBlock == NULL) {
-                    BOOST_LOG_TRIVIAL(debug) << "Thread-" << host << " did not find job (" << pendingBlocks.size() << " pending)";
+                    BLOG_DEBUG("Thread-%s did not find job (%lu pending)", host, pendingBlocks.size());
                     break;
                 }
 
             }
 
             // Download the block `downloadBlockIdx`
-            BOOST_LOG_TRIVIAL(debug) << "Thread-" << host << " downloading " << downloadBlock->fileInfo.mName;
+            BLOG_DEBUG("Thread-%s downloading %s", host, downloadBlock->fileInfo.mName);
 
             auto start = chrono::high_resolution_clock::now();
+            uint64_t downloadStart = latency::now();
 
             hdfsFile file = hdfsOpenFile2(fs, host.c_str(), downloadBlock->fileInfo.mName, O_RDONLY, this->bufferSize,
                                           0, 0);
@@ -323,32 +338,38 @@ private:
             //EXPECT_NONNEGATIVE(r, "hdfsSeek")
 
             tSize read = 0, totalRead = 0;
-            do {
-                read = hdfsRead(fs, file, static_cast<char *>(downloadBlock->data.get()) + totalRead,
-                                downloadBlock->fileInfo.mSize);
-                EXPECT_NONNEGATIVE(read, "hdfsRead")
-
-                totalRead += read;
-            } while (read > 0 && totalRead < downloadBlock->fileInfo.mSize);
+            {
+                perf::Phase phase("download", downloadBlock->fileInfo.mSize);
+                trace::Scoped traced("download");
+                do {
+                    read = hdfsRead(fs, file, static_cast<char *>(downloadBlock->data.get()) + totalRead,
+                                    downloadBlock->fileInfo.mSize);
+                    EXPECT_NONNEGATIVE(read, "hdfsRead")
+
+                    totalRead += read;
+                } while (read > 0 && totalRead < downloadBlock->fileInfo.mSize);
+            }
 
             assert(totalRead == downloadBlock->fileInfo.mSize);
+            latency::record(latency::BlockDownload, latency::now() - downloadStart);
 
             auto seconds = ((double) (chrono::duration_cast<chrono::milliseconds>(
                     chrono::high_resolution_clock::now() - start)).count()) / 1000.0;
-            BOOST_LOG_TRIVIAL(debug) << "Thread-" << host << " downloaded " << downloadBlock->fileInfo.mName << " (" <<
-                                     totalRead / (1024.0 * 1024.0) << " MB with " <<
-                                     ((double) totalRead / (1024.0 * 1024.0)) / seconds << " MB/s)";
+            BLOG_DEBUG("Thread-%s downloaded %s (%f MB with %f MB/s)", host, downloadBlock->fileInfo.mName,
+                       totalRead / (1024.0 * 1024.0), ((double) totalRead / (1024.0 * 1024.0)) / seconds);
             // TODO Waiting for this takes ages ... measure
             {
                 unique_lock<mutex> lock(blocksMutex);
+                downloadBlock->loadedAt = latency::now();
                 loadedBlocks.push(Block(*downloadBlock.get()));
+                trace::instant("queue_push");
                 cv.notify_one();
             }
 
             hdfsCloseFile(fs, file);
         }
 
-        BOOST_LOG_TRIVIAL(debug) << "Thread-" << host << " finished";
+        BLOG_DEBUG("Thread-%s finished", host);
     }
 
 private:
@@ -0,0 +1,122 @@
+#ifndef HDFS_BENCHMARK_HISTOGRAM_H
+#define HDFS_BENCHMARK_HISTOGRAM_H
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+
+/**
+ * A latency histogram with logarithmic buckets, each split into 16 linear
+ * sub-buckets, so that every recorded value is kept with a relative error
+ * below 1/16. Values are nanoseconds.
+ */
+class LatencyHistogram {
+public:
+    static const unsigned SUB_BUCKET_BITS = 4;
+    static const unsigned SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const unsigned BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    LatencyHistogram() : counts(BUCKETS, 0) {
+
+    }
+
+    void record(uint64_t value) {
+        counts[index(value)]++;
+        count++;
+        sum += value;
+        min = std::min(min, value);
+        max = std::max(max, value);
+    }
+
+    void merge(const LatencyHistogram &other) {
+        for (unsigned i = 0; i < BUCKETS; i++) {
+            counts[i] += other.counts[i];
+        }
+        count += other.count;
+        sum += other.sum;
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+    }
+
+    /**
+     * Returns the value at quantile `q` (0..1), i.e. the upper bound of the
+     * bucket containing it.
+     */
+    uint64_t percentile(double q) const {
+        if (count == 0) {
+            return 0;
+        }
+        uint64_t rank = (uint64_t) (q * count);
+        if (rank >= count) {
+            rank = count - 1;
+        }
+        uint64_t seen = 0;
+        for (unsigned i = 0; i < BUCKETS; i++) {
+            seen += counts[i];
+            if (seen > rank) {
+                return std::min(std::max(upperBound(i), min), max);
+            }
+        }
+        return max;
+    }
+
+    double mean() const {
+        return count ? ((double) sum) / count : 0;
+    }
+
+    uint64_t getCount() const {
+        return count;
+    }
+
+    uint64_t getSum() const {
+        return sum;
+    }
+
+    uint64_t getMin() const {
+        return count ? min : 0;
+    }
+
+    uint64_t getMax() const {
+        return max;
+    }
+
+    /**
+     * Prints all non-empty buckets as `upper bound (us)  count`.
+     */
+    void print(FILE *out) const {
+        for (unsigned i = 0; i < BUCKETS; i++) {
+            if (counts[i] > 0) {
+                fprintf(out, "  <= %12.1f us  %lu\n", upperBound(i) / 1000.0, (unsigned long) counts[i]);
+            }
+        }
+    }
+
+private:
+    static unsigned index(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return (unsigned) value;
+        }
+        unsigned msb = 63 - __builtin_clzll(value);
+        unsigned sub = (unsigned) (value >> (msb - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+        return (msb - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub;
+    }
+
+    static uint64_t upperBound(unsigned idx) {
+        if (idx < SUB_BUCKETS) {
+            return idx;
+        }
+        unsigned msb = idx / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+        uint64_t sub = idx % SUB_BUCKETS;
+        uint64_t base = (SUB_BUCKETS + sub) << (msb - SUB_BUCKET_BITS);
+        return base + (1ull << (msb - SUB_BUCKET_BITS)) - 1;
+    }
+
+    std::vector<uint64_t> counts;
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t min = UINT64_MAX;
+    uint64_t max = 0;
+};
+
+#endif //HDFS_BENCHMARK_HISTOGRAM_H
@@ -0,0 +1,262 @@
+#ifndef HDFS_BENCHMARK_INLINEHASHTABLE_H
+#define HDFS_BENCHMARK_INLINEHASHTABLE_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#include <stdint.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "Hash.h"
+
+using namespace std;
+
+namespace benchmark {
+    /**
+     * Hash table from 32 bit keys to values of type `V` that keeps keys
+     * and values inline in groups of 8 slots. With 4 byte values a group is
+     * one cache line, so a lookup usually costs a single cache miss. Groups
+     * are probed linearly; a lookup compares the key with all keys of a
+     * group at once with SIMD and stops at the first group with an empty
+     * slot, since there are no deletes.
+     *
+     * Like `JoinIndex`, the table can be split into `2^partitionBits`
+     * partitions by the high bits of the hash, which own disjoint groups so
+     * that they can be filled by different threads. Otherwise inserts are
+     * not thread safe. The key `2^32 - 1` marks empty slots and can not be
+     * inserted.
+     *
+     * `findBatch()` hashes a batch of keys and prefetches their groups
+     * before it compares any of them, so that the cache misses of a batch
+     * overlap instead of being paid one after the other:
+     *
+     *     table.findBatch(partkey, selection, count, [&](uint32_t i, const uint32_t &value) {
+     *         ...
+     *     });
+     */
+    template<typename V>
+    class InlineHashTable {
+    public:
+        static const unsigned GROUP_SIZE = 8;
+
+        explicit InlineHashTable(size_t capacity, unsigned partitionBits = 0) : partitionBits(partitionBits) {
+            // At most half of the slots are used, partitions get at least 8
+            // groups
+            size_t groupCount = size_t(8) << partitionBits;
+            while (groupCount * GROUP_SIZE < 2 * capacity) {
+                groupCount *= 2;
+            }
+            this->groupCount = groupCount;
+            this->partitionMask = (groupCount >> partitionBits) - 1;
+
+            void *groups = 0;
+            if (posix_memalign(&groups, 64, groupCount * sizeof(Group)) != 0) {
+                throw bad_alloc();
+            }
+            this->groups.reset(static_cast<Group *>(groups));
+        }
+
+        InlineHashTable(const InlineHashTable &) = delete;
+
+        InlineHashTable &operator=(const InlineHashTable &) = delete;
+
+        size_t getGroupCount() const {
+            return this->groupCount;
+        }
+
+        /**
+         * Empties the groups in [begin, end), has to be done for all groups
+         * before the first insert.
+         */
+        void clear(size_t begin, size_t end) {
+            memset(static_cast<void *>(&this->groups[begin]), 0xff, (end - begin) * sizeof(Group));
+        }
+
+        void clear() {
+            this->clear(0, this->groupCount);
+        }
+
+        unsigned getPartition(uint64_t hash) const {
+            return this->partitionBits == 0 ? 0 : hash >> (64 - this->partitionBits);
+        }
+
+        /**
+         * The first group of `partition`, a partition has
+         * `getGroupCount() >> partitionBits` groups.
+         */
+        size_t getPartitionBegin(unsigned partition) const {
+            return partition * (this->partitionMask + 1);
+        }
+
+        size_t getPartitionEnd(unsigned partition) const {
+            return (partition + 1) * (this->partitionMask + 1);
+        }
+
+        /**
+         * Calls `f(key, value)` for the keys in the groups [begin, end), in
+         * the order of their slots.
+         */
+        template<typename F>
+        void forEach(size_t begin, size_t end, F f) {
+            for (size_t group = begin; group < end; group++) {
+                Group &g = this->groups[group];
+                for (unsigned slot = 0; slot < GROUP_SIZE; slot++) {
+                    if (g.keys[slot] != EMPTY) {
+                        f(g.keys[slot], g.values[slot]);
+                    }
+                }
+            }
+        }
+
+        /**
+         * The value of `key`, a new value-initialized one if the key was
+         * not in the table yet.
+         */
+        V &insert(uint32_t key) {
+            return this->insert(key, hashKey(key));
+        }
+
+        /**
+         * `insert(key)` with the key's `hashKey()`.
+         */
+        V &insert(uint32_t key, uint64_t hash) {
+            if (key == EMPTY) {
+                throw runtime_error("Key " + to_string(key) + " marks empty slots");
+            }
+            size_t base = this->getPartition(hash) * (this->partitionMask + 1);
+            size_t group = hash & this->partitionMask;
+            for (size_t probes = 0; probes <= this->partitionMask; probes++) {
+                Group &g = this->groups[base + group];
+                unsigned match = matches(g, key);
+                if (match != 0) {
+                    return g.values[__builtin_ctz(match)];
+                }
+                unsigned empty = matches(g, EMPTY);
+                if (empty != 0) {
+                    unsigned slot = __builtin_ctz(empty);
+                    g.keys[slot] = key;
+                    g.values[slot] = V();
+                    return g.values[slot];
+                }
+                group = (group + 1) & this->partitionMask;
+            }
+            throw runtime_error("Hash table partition " + to_string(this->getPartition(hash)) + " is full");
+        }
+
+        /**
+         * The value of `key`, 0 if it is not in the table.
+         */
+        const V *find(uint32_t key) const {
+            return this->find(key, hashKey(key));
+        }
+
+        /**
+         * Calls `f(i, value)` for every `i` in `selection[0, count)` whose
+         * key `keys[i]` is in the table.
+         */
+        template<typename K, typename F>
+        void findBatch(const K *keys, const uint32_t *selection, size_t count, F f) const {
+            uint64_t hashes[PREFETCH_BATCH];
+            for (size_t begin = 0; begin < count; begin += PREFETCH_BATCH) {
+                size_t n = min(size_t(PREFETCH_BATCH), count - begin);
+                for (size_t k = 0; k < n; k++) {
+                    uint64_t hash = hashKey((uint32_t) keys[selection[begin + k]]);
+                    hashes[k] = hash;
+                    const Group *group = &this->groups[this->getGroup(hash)];
+                    __builtin_prefetch(group);
+                    // Groups of larger values span two cache lines
+                    if (sizeof(Group) > 64) {
+                        __builtin_prefetch(reinterpret_cast<const char *>(group + 1) - 1);
+                    }
+                }
+                for (size_t k = 0; k < n; k++) {
+                    uint32_t i = selection[begin + k];
+                    const V *value = this->find((uint32_t) keys[i], hashes[k]);
+                    if (value != 0) {
+                        f(i, *value);
+                    }
+                }
+            }
+        }
+
+    private:
+        static const uint32_t EMPTY = ~0u;
+
+        // Keys hashed and prefetched ahead of the comparisons, enough to
+        // keep the line fill buffers of a core busy
+        static const size_t PREFETCH_BATCH = 32;
+
+        struct Group {
+            uint32_t keys[GROUP_SIZE];
+            V values[GROUP_SIZE];
+        };
+
+        struct Free {
+            void operator()(Group *groups) const {
+                free(groups);
+            }
+        };
+
+        /**
+         * Bit `i` is set if slot `i` of `group` holds `key`.
+         */
+        static unsigned matches(const Group &group, uint32_t key) {
+#if defined(__AVX2__)
+            __m256i keys = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(group.keys));
+            __m256i equal = _mm256_cmpeq_epi32(keys, _mm256_set1_epi32(key));
+            return _mm256_movemask_ps(_mm256_castsi256_ps(equal));
+#elif defined(__SSE2__)
+            __m128i needle = _mm_set1_epi32(key);
+            __m128i low = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(group.keys)), needle);
+            __m128i high = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(group.keys + 4)), needle);
+            return _mm_movemask_ps(_mm_castsi128_ps(low)) | (_mm_movemask_ps(_mm_castsi128_ps(high)) << 4);
+#else
+            unsigned mask = 0;
+            for (unsigned i = 0; i < GROUP_SIZE; i++) {
+                mask |= unsigned(group.keys[i] == key) << i;
+            }
+            return mask;
+#endif
+        }
+
+        size_t getGroup(uint64_t hash) const {
+            return this->getPartition(hash) * (this->partitionMask + 1) + (hash & this->partitionMask);
+        }
+
+        const V *find(uint32_t key, uint64_t hash) const {
+            // Would match empty slots, and can not have been inserted
+            if (key == EMPTY) {
+                return 0;
+            }
+            size_t base = this->getPartition(hash) * (this->partitionMask + 1);
+            size_t group = hash & this->partitionMask;
+            for (size_t probes = 0; probes <= this->partitionMask; probes++) {
+                const Group &g = this->groups[base + group];
+                unsigned match = matches(g, key);
+                if (match != 0) {
+                    return &g.values[__builtin_ctz(match)];
+                }
+                if (matches(g, EMPTY) != 0) {
+                    return 0;
+                }
+                group = (group + 1) & this->partitionMask;
+            }
+            return 0;
+        }
+
+        unsigned partitionBits;
+        size_t groupCount;
+        size_t partitionMask;
+        unique_ptr<Group[], Free> groups;
+    };
+};
+
+#endif //HDFS_BENCHMARK_INLINEHASHTABLE_H
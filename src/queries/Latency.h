@@ -0,0 +1,129 @@
+#ifndef HDFS_BENCHMARK_LATENCY_H
+#define HDFS_BENCHMARK_LATENCY_H
+
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <set>
+
+#include "Histogram.h"
+
+/**
+ * Thread-local latency histograms for the phases of reading and
+ * processing blocks. Recording touches only the calling thread's
+ * histograms; they are merged into the totals when the thread exits or
+ * when `print` is called.
+ */
+namespace latency {
+    enum Metric {
+        BlockDownload = 0, QueueWait, BlockProcessing, RowGroupDecode, MetricCount
+    };
+
+    static const char *metricNames[] = {
+            "block_download", "queue_wait", "block_processing", "rowgroup_decode"
+    };
+
+    inline uint64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    class Registry {
+    public:
+        struct Local {
+            Local() {
+                Registry::get().attach(this);
+            }
+
+            ~Local() {
+                Registry::get().detach(this);
+            }
+
+            LatencyHistogram histograms[MetricCount];
+        };
+
+        static Registry &get() {
+            static Registry registry;
+            return registry;
+        }
+
+        /**
+         * Prints percentiles of all metrics recorded by any thread so far.
+         */
+        void print(FILE *out) {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            LatencyHistogram merged[MetricCount];
+            for (unsigned m = 0; m < MetricCount; m++) {
+                merged[m].merge(totals[m]);
+                for (auto local : locals) {
+                    merged[m].merge(local->histograms[m]);
+                }
+            }
+
+            fprintf(out, "%-18s %10s %10s %10s %10s %10s %10s %10s (us)\n", "latency", "count", "mean", "p50", "p90",
+                    "p99", "p99.9", "max");
+            for (unsigned m = 0; m < MetricCount; m++) {
+                LatencyHistogram &h = merged[m];
+                if (h.getCount() == 0) {
+                    continue;
+                }
+                fprintf(out, "%-18s %10lu %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", metricNames[m],
+                        (unsigned long) h.getCount(), h.mean() / 1000.0, h.percentile(0.5) / 1000.0,
+                        h.percentile(0.9) / 1000.0, h.percentile(0.99) / 1000.0, h.percentile(0.999) / 1000.0,
+                        h.getMax() / 1000.0);
+            }
+        }
+
+    private:
+        void attach(Local *local) {
+            std::lock_guard<std::mutex> lock(mutex);
+            locals.insert(local);
+        }
+
+        void detach(Local *local) {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (unsigned m = 0; m < MetricCount; m++) {
+                totals[m].merge(local->histograms[m]);
+            }
+            locals.erase(local);
+        }
+
+        std::mutex mutex;
+        std::set<Local *> locals;
+        LatencyHistogram totals[MetricCount];
+    };
+
+    inline Registry::Local &local() {
+        static thread_local Registry::Local local;
+        return local;
+    }
+
+    inline void record(Metric metric, uint64_t ns) {
+        local().histograms[metric].record(ns);
+    }
+
+    inline void print(FILE *out = stderr) {
+        Registry::get().print(out);
+    }
+
+    /**
+     * Records the time from construction to destruction as `metric`.
+     */
+    class Scoped {
+    public:
+        Scoped(Metric metric) : metric(metric), start(now()) {
+
+        }
+
+        ~Scoped() {
+            record(metric, now() - start);
+        }
+
+    private:
+        Metric metric;
+        uint64_t start;
+    };
+}
+
+#endif //HDFS_BENCHMARK_LATENCY_H
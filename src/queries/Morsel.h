@@ -0,0 +1,244 @@
+#ifndef HDFS_BENCHMARK_MORSEL_H
+#define HDFS_BENCHMARK_MORSEL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Block.h"
+#include "ParquetFile.h"
+#include "Trace.h"
+
+using namespace std;
+
+namespace benchmark {
+    /**
+     * Parses the Parquet file of a downloaded block. The block's data is
+     * kept alive as long as the returned file.
+     */
+    inline shared_ptr<ParquetFile> openFile(Block &block) {
+        shared_ptr<void> data = block.data;
+        ParquetFile *file = new ParquetFile(static_cast<const uint8_t *>(data.get()), block.fileInfo.mSize);
+        return shared_ptr<ParquetFile>(file, [data](ParquetFile *file) {
+            delete file;
+        });
+    }
+
+    /**
+     * A pool of workers that run morsels, i.e. small units of work such as
+     * one row group of a file. Each worker has its own queue and steals
+     * from the other queues when its own is empty, so that the end of a
+     * scan does not wait for the one thread that got the largest file.
+     *
+     * The `HdfsReader` consumers, one per worker, only open the files and
+     * queue their row groups with `scan()`; per-worker state (see `PerWorker`) is merged
+     * after `wait()`.
+     */
+    class MorselPool {
+    public:
+        typedef function<void(unsigned worker)> Morsel;
+
+        explicit MorselPool(unsigned workerCount, size_t maxPending = 0) :
+                maxPending(maxPending ? maxPending : 8 * workerCount) {
+            if (workerCount == 0) {
+                throw runtime_error("A morsel pool needs at least one worker");
+            }
+            for (unsigned i = 0; i < workerCount; i++) {
+                this->queues.push_back(unique_ptr<Queue>(new Queue()));
+            }
+            for (unsigned i = 0; i < workerCount; i++) {
+                this->workers.push_back(thread(&MorselPool::work, this, i));
+            }
+        }
+
+        MorselPool(const MorselPool &) = delete;
+
+        MorselPool &operator=(const MorselPool &) = delete;
+
+        ~MorselPool() {
+            {
+                lock_guard<mutex> lock(this->poolMutex);
+                this->stopping = true;
+            }
+            this->workAvailable.notify_all();
+            for (auto &worker : this->workers) {
+                worker.join();
+            }
+        }
+
+        unsigned getWorkerCount() const {
+            return this->queues.size();
+        }
+
+        /**
+         * Queues `morsel`. Blocks while `maxPending` morsels are queued or
+         * running, which bounds the number of downloaded files in memory.
+         */
+        void push(Morsel morsel) {
+            {
+                unique_lock<mutex> lock(this->poolMutex);
+                this->space.wait(lock, [this]() { return this->pending < this->maxPending; });
+                this->pending++;
+            }
+
+            Queue &queue = *this->queues[this->nextQueue++ % this->queues.size()];
+            {
+                lock_guard<mutex> lock(queue.queueMutex);
+                queue.morsels.push_back(move(morsel));
+            }
+
+            {
+                lock_guard<mutex> lock(this->poolMutex);
+                this->queued++;
+            }
+            this->workAvailable.notify_one();
+        }
+
+        /**
+         * Queues one morsel per row group of `file`, calling
+         * `f(worker, rowGroup, firstRow)` where `firstRow` is the index of
+         * the row group's first row in the file.
+         */
+        template<typename F>
+        void scan(shared_ptr<ParquetFile> file, F f) {
+            uint64_t firstRow = 0;
+            auto &rowGroups = file->getRowGroups();
+            for (size_t i = 0; i < rowGroups.size(); i++) {
+                this->push([file, i, firstRow, f](unsigned worker) {
+                    f(worker, file->getRowGroups()[i], firstRow);
+                });
+                firstRow += rowGroups[i].getNumRows();
+            }
+        }
+
+        /**
+         * Waits until all queued morsels ran. Rethrows the first exception
+         * thrown by a morsel.
+         */
+        void wait() {
+            unique_lock<mutex> lock(this->poolMutex);
+            this->idle.wait(lock, [this]() { return this->pending == 0; });
+            if (this->error) {
+                exception_ptr error = this->error;
+                this->error = nullptr;
+                rethrow_exception(error);
+            }
+        }
+
+    private:
+        struct Queue {
+            mutex queueMutex;
+            deque<Morsel> morsels;
+        };
+
+        bool take(unsigned worker, Morsel &morsel) {
+            size_t count = this->queues.size();
+            for (size_t i = 0; i < count; i++) {
+                Queue &queue = *this->queues[(worker + i) % count];
+                lock_guard<mutex> lock(queue.queueMutex);
+                if (queue.morsels.empty()) {
+                    continue;
+                }
+                // Own queue from the front, steal from the back
+                if (i == 0) {
+                    morsel = move(queue.morsels.front());
+                    queue.morsels.pop_front();
+                } else {
+                    morsel = move(queue.morsels.back());
+                    queue.morsels.pop_back();
+                }
+                return true;
+            }
+            return false;
+        }
+
+        void work(unsigned worker) {
+            trace::setThreadName("worker " + to_string(worker));
+
+            while (true) {
+                {
+                    unique_lock<mutex> lock(this->poolMutex);
+                    this->workAvailable.wait(lock, [this]() { return this->stopping || this->queued > 0; });
+                    if (this->queued == 0) {
+                        break;
+                    }
+                    this->queued--;
+                }
+
+                // A morsel is queued for this worker, but may still be
+                // taken by another one first
+                Morsel morsel;
+                while (!this->take(worker, morsel)) {
+                    this_thread::yield();
+                }
+
+                try {
+                    trace::Scoped traced("morsel");
+                    morsel(worker);
+                } catch (...) {
+                    lock_guard<mutex> lock(this->poolMutex);
+                    if (!this->error) {
+                        this->error = current_exception();
+                    }
+                }
+
+                {
+                    lock_guard<mutex> lock(this->poolMutex);
+                    this->pending--;
+                }
+                this->space.notify_one();
+                this->idle.notify_all();
+            }
+        }
+
+        size_t maxPending;
+        vector<unique_ptr<Queue>> queues;
+        vector<thread> workers;
+        atomic<unsigned> nextQueue{0};
+
+        mutex poolMutex;
+        condition_variable workAvailable, space, idle;
+        // Morsels in queues, and queued or running
+        size_t queued = 0;
+        size_t pending = 0;
+        bool stopping = false;
+        exception_ptr error;
+    };
+
+    /**
+     * One instance of `T` per worker, padded against false sharing.
+     */
+    template<typename T>
+    class PerWorker {
+    public:
+        explicit PerWorker(const MorselPool &pool) : slots(pool.getWorkerCount()) {
+
+        }
+
+        T &operator[](unsigned worker) {
+            return this->slots[worker].value;
+        }
+
+        size_t size() const {
+            return this->slots.size();
+        }
+
+    private:
+        struct Slot {
+            T value;
+            char padding[64];
+        };
+
+        vector<Slot> slots;
+    };
+};
+
+#endif //HDFS_BENCHMARK_MORSEL_H
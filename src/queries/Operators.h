@@ -0,0 +1,719 @@
+#ifndef HDFS_BENCHMARK_OPERATORS_H
+#define HDFS_BENCHMARK_OPERATORS_H
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include "Hash.h"
+#include "HashJoin.h"
+#include "HdfsReader.h"
+#include "Latency.h"
+#include "Morsel.h"
+#include "PerfCounters.h"
+#include "RadixSort.h"
+#include "Scan.h"
+#include "Trace.h"
+
+using namespace std;
+
+namespace benchmark {
+    /**
+     * Maximum number of columns of a batch.
+     */
+    const unsigned MAX_COLUMNS = 16;
+
+    /**
+     * Columns of up to `size` rows that operators push to each other. Only
+     * the rows at the `count` positions in `selection` are part of the
+     * batch, values at other positions are undefined. Batches are only
+     * valid during `Operator::consume()`.
+     */
+    struct Batch {
+        unsigned worker = 0;
+        size_t size = 0;
+        const uint32_t *selection = 0;
+        size_t count = 0;
+        unsigned columnCount = 0;
+        const void *columns[MAX_COLUMNS];
+
+        template<typename T>
+        const T *column(unsigned slot) const {
+            return static_cast<const T *>(this->columns[slot]);
+        }
+
+        unsigned addColumn(const void *values) {
+            if (this->columnCount == MAX_COLUMNS) {
+                throw runtime_error("More than " + to_string(MAX_COLUMNS) + " columns in a batch");
+            }
+            this->columns[this->columnCount] = values;
+            return this->columnCount++;
+        }
+    };
+
+    /**
+     * An operator of a push pipeline. The workers of a `MorselPool` call
+     * `consume()` concurrently, each with its own `batch.worker`, so
+     * operators keep their state per worker. `finish()` is called once,
+     * after all batches were consumed.
+     */
+    class Operator {
+    public:
+        virtual ~Operator() {
+
+        }
+
+        virtual void consume(const Batch &batch) = 0;
+
+        virtual void finish() {
+
+        }
+    };
+
+    /**
+     * Set of non-negative integer keys, one bit per key up to the largest,
+     * the build side of a semi join on dense keys such as TPC-H's.
+     */
+    class KeyBitmap {
+    public:
+        explicit KeyBitmap(size_t keyCount = 0) : words((keyCount + 63) / 64, 0) {
+
+        }
+
+        void set(uint32_t key) {
+            this->words[key / 64] |= uint64_t(1) << (key % 64);
+        }
+
+        bool contains(uint32_t key) const {
+            return key / 64 < this->words.size() && ((this->words[key / 64] >> (key % 64)) & 1) != 0;
+        }
+
+    private:
+        vector<uint64_t> words;
+    };
+
+    /**
+     * Scans the Parquet files at `path`, one morsel per row group, and
+     * pushes the projected columns of the qualifying rows in batches.
+     * Predicates added with `between()` and `where()` are evaluated by the
+     * `Scan` of each row group, see there.
+     *
+     *     ParquetScan scan(hdfsReader, pool, lineitemPath, "q1_lineitem_scan");
+     *     scan.between(10, minDate, maxDate);
+     *     unsigned quantity = scan.column<double>(4);
+     *     scan.run(aggregate);
+     */
+    class ParquetScan {
+    public:
+        ParquetScan(HdfsReader &hdfsReader, MorselPool &pool, const string &path, const char *phase) :
+                hdfsReader(hdfsReader), pool(pool), path(path), phase(phase) {
+
+        }
+
+        /**
+         * Projects column `col`, returns its slot in the pushed batches.
+         */
+        template<typename T>
+        unsigned column(unsigned col) {
+            this->projections.push_back([col](Scan &scan) -> const void * {
+                return scan.column<T>(col);
+            });
+            return this->projections.size() - 1;
+        }
+
+        template<typename T>
+        ParquetScan &between(unsigned col, const T &lower, const T &upper) {
+            this->predicates.push_back([col, lower, upper](Scan &scan) {
+                scan.between(col, lower, upper);
+            });
+            return *this;
+        }
+
+        template<typename T, typename P>
+        ParquetScan &where(unsigned col, P predicate) {
+            this->predicates.push_back([col, predicate](Scan &scan) {
+                scan.where<T>(col, predicate);
+            });
+            return *this;
+        }
+
+        /**
+         * Selects rows whose key of type `T` in column `col` is in `bitmap`,
+         * the probe side of a semi join with a `BitmapBuild`.
+         */
+        template<typename T>
+        ParquetScan &semiJoin(unsigned col, const KeyBitmap &bitmap) {
+            const KeyBitmap *keys = &bitmap;
+            return this->where<T>(col, [keys](T key) {
+                return keys->contains(key);
+            });
+        }
+
+        /**
+         * Scans all files, then calls `next.finish()`.
+         */
+        void run(Operator &next) {
+            this->hdfsReader.read(this->path, [](vector<string> &paths) {
+            }, [&](Block block) {
+                this->pool.scan(openFile(block), [&](unsigned worker, RowGroup &rowGroup, uint64_t firstRow) {
+                    this->scanRowGroup(worker, rowGroup, next);
+                });
+            }, this->pool.getWorkerCount());
+            this->pool.wait();
+            next.finish();
+        }
+
+    private:
+        void scanRowGroup(unsigned worker, RowGroup &rowGroup, Operator &next) {
+            perf::Phase phase(this->phase, rowGroup.getCompressedSize());
+            latency::Scoped decode(latency::RowGroupDecode);
+            trace::Scoped traced("rowgroup_decode");
+
+            Scan scan(rowGroup);
+            for (auto &predicate : this->predicates) {
+                predicate(scan);
+            }
+            Batch batch;
+            batch.worker = worker;
+            for (auto &projection : this->projections) {
+                batch.addColumn(projection(scan));
+            }
+            scan.run([&](const uint32_t *selection, size_t count) {
+                batch.size = selection[count - 1] + 1;
+                batch.selection = selection;
+                batch.count = count;
+                next.consume(batch);
+            });
+        }
+
+        HdfsReader &hdfsReader;
+        MorselPool &pool;
+        string path;
+        const char *phase;
+        vector<function<void(Scan &)>> predicates;
+        vector<function<const void *(Scan &)>> projections;
+    };
+
+    /**
+     * Keeps the rows for which `predicate(batch, i)` is true.
+     */
+    template<typename P>
+    class Filter : public Operator {
+    public:
+        Filter(MorselPool &pool, P predicate, Operator &next) :
+                predicate(predicate), next(next), selections(pool) {
+
+        }
+
+        void consume(const Batch &batch) override {
+            vector<uint32_t> &selection = this->selections[batch.worker];
+            selection.resize(batch.count);
+            size_t selected = 0;
+            for (size_t k = 0; k < batch.count; k++) {
+                uint32_t i = batch.selection[k];
+                selection[selected] = i;
+                selected += this->predicate(batch, i) ? 1 : 0;
+            }
+            if (selected == 0) {
+                return;
+            }
+
+            Batch filtered = batch;
+            filtered.selection = selection.data();
+            filtered.count = selected;
+            this->next.consume(filtered);
+        }
+
+        void finish() override {
+            this->next.finish();
+        }
+
+    private:
+        P predicate;
+        Operator &next;
+        PerWorker<vector<uint32_t>> selections;
+    };
+
+    template<typename P>
+    Filter<P> filter(MorselPool &pool, P predicate, Operator &next) {
+        return Filter<P>(pool, predicate, next);
+    }
+
+    /**
+     * Appends computed columns to the batches, evaluated at the selected
+     * positions only.
+     *
+     *     Project project(pool, 2, aggregate);
+     *     unsigned revenue = project.add<double>([=](const Batch &b, uint32_t i) {
+     *         return b.column<double>(price)[i] * (1 - b.column<double>(discount)[i]);
+     *     });
+     */
+    class Project : public Operator {
+    public:
+        /**
+         * `inputColumns` is the number of columns of the consumed batches.
+         */
+        Project(MorselPool &pool, unsigned inputColumns, Operator &next) :
+                inputColumns(inputColumns), next(next), buffers(pool) {
+
+        }
+
+        /**
+         * Adds the column `f(batch, i)` to the batches, returns its slot.
+         */
+        template<typename T, typename F>
+        unsigned add(F f) {
+            this->expressions.push_back(Expression{sizeof(T), [f](const Batch &batch, void *out) {
+                T *values = static_cast<T *>(out);
+                for (size_t k = 0; k < batch.count; k++) {
+                    uint32_t i = batch.selection[k];
+                    values[i] = f(batch, i);
+                }
+            }});
+            return this->inputColumns + this->expressions.size() - 1;
+        }
+
+        void consume(const Batch &batch) override {
+            vector<vector<uint8_t>> &buffers = this->buffers[batch.worker];
+            buffers.resize(this->expressions.size());
+
+            Batch projected = batch;
+            for (size_t e = 0; e < this->expressions.size(); e++) {
+                Expression &expression = this->expressions[e];
+                if (buffers[e].size() < batch.size * expression.width) {
+                    buffers[e].resize(batch.size * expression.width);
+                }
+                // Expressions can use the columns added before them
+                expression.evaluate(projected, buffers[e].data());
+                projected.addColumn(buffers[e].data());
+            }
+            this->next.consume(projected);
+        }
+
+        void finish() override {
+            this->next.finish();
+        }
+
+    private:
+        struct Expression {
+            size_t width;
+            function<void(const Batch &, void *)> evaluate;
+        };
+
+        unsigned inputColumns;
+        Operator &next;
+        vector<Expression> expressions;
+        PerWorker<vector<vector<uint8_t>>> buffers;
+    };
+
+    /**
+     * Linear probing table of the groups of one worker, remembers the last
+     * group since rows of a group often follow each other.
+     */
+    template<typename K, typename A>
+    class GroupTable {
+    public:
+        A &get(const K &key) {
+            if (this->last != NO_ENTRY && this->groups[this->last].first == key) {
+                return this->groups[this->last].second;
+            }
+            if ((this->groups.size() + 1) * 2 > this->slots.size()) {
+                this->grow();
+            }
+            uint64_t mask = this->slots.size() - 1;
+            for (uint64_t pos = hashKey(key) & mask;; pos = (pos + 1) & mask) {
+                uint32_t group = this->slots[pos];
+                if (group == NO_ENTRY) {
+                    this->slots[pos] = this->last = this->groups.size();
+                    this->groups.push_back(make_pair(key, A()));
+                    return this->groups.back().second;
+                }
+                if (this->groups[group].first == key) {
+                    this->last = group;
+                    return this->groups[group].second;
+                }
+            }
+        }
+
+        vector<pair<K, A>> &getGroups() {
+            return this->groups;
+        }
+
+    private:
+        void grow() {
+            size_t size = max<size_t>(16, this->slots.size() * 2);
+            this->slots.assign(size, NO_ENTRY);
+            for (uint32_t group = 0; group < this->groups.size(); group++) {
+                for (uint64_t pos = hashKey(this->groups[group].first) & (size - 1);; pos = (pos + 1) & (size - 1)) {
+                    if (this->slots[pos] == NO_ENTRY) {
+                        this->slots[pos] = group;
+                        break;
+                    }
+                }
+            }
+        }
+
+        vector<uint32_t> slots;
+        vector<pair<K, A>> groups;
+        uint32_t last = NO_ENTRY;
+    };
+
+    /**
+     * Groups rows by `key(batch, i)` and folds them into an `A` per group
+     * with `update(a, batch, i)`. The groups of the workers are combined
+     * with `merge(a, other)`, `getResult()` returns them ordered by key.
+     */
+    template<typename K, typename A, typename KeyF, typename UpdateF, typename MergeF>
+    class HashAggregate : public Operator {
+    public:
+        HashAggregate(MorselPool &pool, KeyF key, UpdateF update, MergeF merge) :
+                key(key), update(update), merge(merge), tables(pool) {
+
+        }
+
+        void consume(const Batch &batch) override {
+            GroupTable<K, A> &table = this->tables[batch.worker];
+            for (size_t k = 0; k < batch.count; k++) {
+                uint32_t i = batch.selection[k];
+                this->update(table.get(this->key(batch, i)), batch, i);
+            }
+        }
+
+        void finish() override {
+            for (unsigned worker = 0; worker < this->tables.size(); worker++) {
+                for (auto &group : this->tables[worker].getGroups()) {
+                    auto it = this->result.find(group.first);
+                    if (it == this->result.end()) {
+                        this->result.insert(group);
+                    } else {
+                        this->merge(it->second, group.second);
+                    }
+                }
+            }
+        }
+
+        const map<K, A> &getResult() const {
+            return this->result;
+        }
+
+    private:
+        KeyF key;
+        UpdateF update;
+        MergeF merge;
+        PerWorker<GroupTable<K, A>> tables;
+        map<K, A> result;
+    };
+
+    template<typename K, typename A, typename KeyF, typename UpdateF, typename MergeF>
+    HashAggregate<K, A, KeyF, UpdateF, MergeF> hashAggregate(MorselPool &pool, KeyF key, UpdateF update,
+                                                             MergeF merge) {
+        return HashAggregate<K, A, KeyF, UpdateF, MergeF>(pool, key, update, merge);
+    }
+
+    /**
+     * Folds all rows into one `A` with `update(a, batch, i)`. The `A`s of
+     * the workers are combined with `merge(a, other)`.
+     */
+    template<typename A, typename UpdateF, typename MergeF>
+    class Reduce : public Operator {
+    public:
+        Reduce(MorselPool &pool, UpdateF update, MergeF merge) : update(update), merge(merge), partial(pool) {
+
+        }
+
+        void consume(const Batch &batch) override {
+            A &a = this->partial[batch.worker];
+            for (size_t k = 0; k < batch.count; k++) {
+                this->update(a, batch, batch.selection[k]);
+            }
+        }
+
+        void finish() override {
+            for (unsigned worker = 0; worker < this->partial.size(); worker++) {
+                this->merge(this->result, this->partial[worker]);
+            }
+        }
+
+        const A &getResult() const {
+            return this->result;
+        }
+
+    private:
+        UpdateF update;
+        MergeF merge;
+        PerWorker<A> partial;
+        A result = A();
+    };
+
+    template<typename A, typename UpdateF, typename MergeF>
+    Reduce<A, UpdateF, MergeF> reduce(MorselPool &pool, UpdateF update, MergeF merge) {
+        return Reduce<A, UpdateF, MergeF>(pool, update, merge);
+    }
+
+    /**
+     * Collects `(key(batch, i), value(batch, i))` of every row and builds
+     * a `CsrIndex` of them with `buildCsrIndex()` in `finish()`.
+     */
+    template<typename K, typename V, typename KeyF, typename ValueF>
+    class HashJoinBuild : public Operator {
+    public:
+        HashJoinBuild(MorselPool &pool, KeyF key, ValueF value, const char *phase = "hash_build") :
+                pool(pool), key(key), value(value), phase(phase), entries(pool) {
+
+        }
+
+        void consume(const Batch &batch) override {
+            vector<pair<K, V>> &entries = this->entries[batch.worker];
+            for (size_t k = 0; k < batch.count; k++) {
+                uint32_t i = batch.selection[k];
+                entries.push_back(make_pair(this->key(batch, i), this->value(batch, i)));
+            }
+        }
+
+        void finish() override {
+            perf::Phase phase(this->phase);
+            this->index = buildCsrIndex(this->pool, this->entries);
+            for (unsigned worker = 0; worker < this->entries.size(); worker++) {
+                vector<pair<K, V>>().swap(this->entries[worker]);
+            }
+        }
+
+        const CsrIndex<V> &getIndex() const {
+            return *this->index;
+        }
+
+    private:
+        MorselPool &pool;
+        KeyF key;
+        ValueF value;
+        const char *phase;
+        PerWorker<vector<pair<K, V>>> entries;
+        unique_ptr<CsrIndex<V>> index;
+    };
+
+    template<typename K, typename V, typename KeyF, typename ValueF>
+    HashJoinBuild<K, V, KeyF, ValueF> hashJoinBuild(MorselPool &pool, KeyF key, ValueF value,
+                                                    const char *phase = "hash_build") {
+        return HashJoinBuild<K, V, KeyF, ValueF>(pool, key, value, phase);
+    }
+
+    /**
+     * Probes the index of a `HashJoinBuild` with the keys of type `K` in
+     * column `key`, see `CsrIndex::findBatch()`, and pushes one row per
+     * match: the columns passed on with `carry()`, followed by the value
+     * of the matching build tuple.
+     */
+    template<typename K, typename V>
+    class HashJoinProbe : public Operator {
+    public:
+        HashJoinProbe(MorselPool &pool, const CsrIndex<V> &index, unsigned key, Operator &next) :
+                index(index), key(key), next(next), outputs(pool) {
+
+        }
+
+        /**
+         * Passes column `slot` of the probe side on, returns its slot in the
+         * pushed batches.
+         */
+        template<typename T>
+        unsigned carry(unsigned slot) {
+            this->carried.push_back(Carried{sizeof(T), [slot](const Batch &batch, const uint32_t *rows, size_t n,
+                                                              void *out) {
+                const T *in = batch.column<T>(slot);
+                T *values = static_cast<T *>(out);
+                for (size_t k = 0; k < n; k++) {
+                    values[k] = in[rows[k]];
+                }
+            }});
+            return this->carried.size() - 1;
+        }
+
+        /**
+         * The slot of the build side's value in the pushed batches.
+         */
+        unsigned valueSlot() const {
+            return this->carried.size();
+        }
+
+        void consume(const Batch &batch) override {
+            Output &output = this->outputs[batch.worker];
+            output.rows.clear();
+            output.values.clear();
+            this->index.findBatch(batch.column<K>(this->key), batch.selection, batch.count,
+                                  [&](uint32_t i, const V *begin, const V *end) {
+                                      for (const V *value = begin; value != end; value++) {
+                                          output.rows.push_back(i);
+                                          output.values.push_back(*value);
+                                      }
+                                      if (output.rows.size() >= BATCH_SIZE) {
+                                          this->flush(batch, output);
+                                      }
+                                  });
+            this->flush(batch, output);
+        }
+
+        void finish() override {
+            this->next.finish();
+        }
+
+    private:
+        struct Carried {
+            size_t width;
+            function<void(const Batch &, const uint32_t *rows, size_t n, void *out)> gather;
+        };
+
+        struct Output {
+            vector<uint32_t> rows;
+            vector<V> values;
+            vector<uint32_t> selection;
+            vector<vector<uint8_t>> columns;
+        };
+
+        void flush(const Batch &batch, Output &output) {
+            size_t n = output.rows.size();
+            if (n == 0) {
+                return;
+            }
+
+            Batch joined;
+            joined.worker = batch.worker;
+            joined.size = n;
+            joined.count = n;
+            if (output.selection.size() < n) {
+                output.selection.resize(n);
+                for (size_t i = 0; i < n; i++) {
+                    output.selection[i] = i;
+                }
+            }
+            joined.selection = output.selection.data();
+
+            output.columns.resize(this->carried.size());
+            for (size_t c = 0; c < this->carried.size(); c++) {
+                if (output.columns[c].size() < n * this->carried[c].width) {
+                    output.columns[c].resize(n * this->carried[c].width);
+                }
+                this->carried[c].gather(batch, output.rows.data(), n, output.columns[c].data());
+                joined.addColumn(output.columns[c].data());
+            }
+            joined.addColumn(output.values.data());
+
+            this->next.consume(joined);
+            output.rows.clear();
+            output.values.clear();
+        }
+
+        const CsrIndex<V> &index;
+        unsigned key;
+        Operator &next;
+        vector<Carried> carried;
+        PerWorker<Output> outputs;
+    };
+
+    template<typename K, typename V>
+    HashJoinProbe<K, V> hashJoinProbe(MorselPool &pool, const CsrIndex<V> &index, unsigned key, Operator &next) {
+        return HashJoinProbe<K, V>(pool, index, key, next);
+    }
+
+    /**
+     * Collects `key(batch, i)` of every row and sets them in a `KeyBitmap`
+     * in `finish()`. The bitmap filters the probe side in its scan, see
+     * `ParquetScan::semiJoin()`.
+     */
+    template<typename KeyF>
+    class BitmapBuild : public Operator {
+    public:
+        BitmapBuild(MorselPool &pool, KeyF key, const char *phase = "bitmap_build") :
+                key(key), phase(phase), keys(pool) {
+
+        }
+
+        void consume(const Batch &batch) override {
+            vector<uint32_t> &keys = this->keys[batch.worker];
+            for (size_t k = 0; k < batch.count; k++) {
+                keys.push_back(this->key(batch, batch.selection[k]));
+            }
+        }
+
+        void finish() override {
+            perf::Phase phase(this->phase);
+            size_t keyCount = 0;
+            for (unsigned worker = 0; worker < this->keys.size(); worker++) {
+                for (uint32_t key : this->keys[worker]) {
+                    keyCount = max(keyCount, size_t(key) + 1);
+                }
+            }
+            this->bitmap = KeyBitmap(keyCount);
+            for (unsigned worker = 0; worker < this->keys.size(); worker++) {
+                for (uint32_t key : this->keys[worker]) {
+                    this->bitmap.set(key);
+                }
+                vector<uint32_t>().swap(this->keys[worker]);
+            }
+        }
+
+        const KeyBitmap &getBitmap() const {
+            return this->bitmap;
+        }
+
+    private:
+        KeyF key;
+        const char *phase;
+        PerWorker<vector<uint32_t>> keys;
+        KeyBitmap bitmap;
+    };
+
+    template<typename KeyF>
+    BitmapBuild<KeyF> bitmapBuild(MorselPool &pool, KeyF key, const char *phase = "bitmap_build") {
+        return BitmapBuild<KeyF>(pool, key, phase);
+    }
+
+    /**
+     * Materializes `row(batch, i)` of every row and sorts all rows by the
+     * 32 bit key `key(row)` with `radixSort()` in `finish()`.
+     */
+    template<typename R, typename RowF, typename KeyF>
+    class Sort : public Operator {
+    public:
+        Sort(MorselPool &pool, RowF row, KeyF key, const char *phase = "sort") :
+                pool(pool), row(row), key(key), phase(phase), rows(pool) {
+
+        }
+
+        void consume(const Batch &batch) override {
+            vector<R> &rows = this->rows[batch.worker];
+            for (size_t k = 0; k < batch.count; k++) {
+                rows.push_back(this->row(batch, batch.selection[k]));
+            }
+        }
+
+        void finish() override {
+            perf::Phase phase(this->phase);
+            this->sorted = radixSort(this->pool, this->rows, this->key);
+        }
+
+        const vector<R> &getResult() const {
+            return this->sorted;
+        }
+
+    private:
+        MorselPool &pool;
+        RowF row;
+        KeyF key;
+        const char *phase;
+        PerWorker<vector<R>> rows;
+        vector<R> sorted;
+    };
+
+    template<typename R, typename RowF, typename KeyF>
+    Sort<R, RowF, KeyF> sortBy(MorselPool &pool, RowF row, KeyF key, const char *phase = "sort") {
+        return Sort<R, RowF, KeyF>(pool, row, key, phase);
+    }
+};
+
+#endif //HDFS_BENCHMARK_OPERATORS_H
@@ -0,0 +1,263 @@
+#include "PageHeader.h"
+
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace benchmark {
+    // Field types of the Thrift compact protocol
+    enum CompactType {
+        STOP = 0, BOOLEAN_TRUE = 1, BOOLEAN_FALSE = 2, BYTE = 3, I16 = 4, I32 = 5, I64 = 6, DOUBLE = 7,
+        BINARY = 8, LIST = 9, SET = 10, MAP = 11, STRUCT = 12
+    };
+
+    class CompactReader {
+    public:
+        CompactReader(const uint8_t *data, size_t length) : begin(data), position(data), end(data + length) {
+
+        }
+
+        uint64_t varint() {
+            uint64_t value = 0;
+            for (unsigned shift = 0; shift < 64; shift += 7) {
+                uint8_t byte = this->byte();
+                value |= uint64_t(byte & 0x7f) << shift;
+                if ((byte & 0x80) == 0) {
+                    return value;
+                }
+            }
+            throw runtime_error("Corrupt page header: varint too long");
+        }
+
+        int32_t i32() {
+            uint32_t value = this->varint();
+            return (value >> 1) ^ -(value & 1);
+        }
+
+        int64_t i64() {
+            uint64_t value = this->varint();
+            return (value >> 1) ^ -(value & 1);
+        }
+
+        void binary(string &out) {
+            uint64_t length = this->varint();
+            if (length > (uint64_t) (this->end - this->position)) {
+                throw runtime_error("Corrupt page header: binary exceeds header");
+            }
+            out.assign(reinterpret_cast<const char *>(this->position), length);
+            this->position += length;
+        }
+
+        /**
+         * Calls `f(id, type)` for every field of a struct, which has to
+         * read or `skip()` the field's value.
+         */
+        template<typename F>
+        void fields(F f) {
+            int16_t id = 0;
+            while (true) {
+                uint8_t header = this->byte();
+                int type = header & 0x0f;
+                if (type == STOP) {
+                    return;
+                }
+                int delta = header >> 4;
+                id = delta != 0 ? id + delta : (int16_t) this->i32();
+                f(id, type);
+            }
+        }
+
+        void skip(int type) {
+            switch (type) {
+                case BOOLEAN_TRUE:
+                case BOOLEAN_FALSE:
+                    // Struct fields keep booleans in their type
+                    break;
+                case BYTE:
+                    this->byte();
+                    break;
+                case I16:
+                case I32:
+                case I64:
+                    this->varint();
+                    break;
+                case DOUBLE:
+                    this->advance(8);
+                    break;
+                case BINARY:
+                    this->advance(this->varint());
+                    break;
+                case LIST:
+                case SET: {
+                    uint8_t header = this->byte();
+                    uint64_t size = header >> 4;
+                    if (size == 15) {
+                        size = this->varint();
+                    }
+                    int elementType = header & 0x0f;
+                    for (uint64_t i = 0; i < size; i++) {
+                        this->skipElement(elementType);
+                    }
+                    break;
+                }
+                case MAP: {
+                    uint64_t size = this->varint();
+                    if (size > 0) {
+                        uint8_t types = this->byte();
+                        for (uint64_t i = 0; i < size; i++) {
+                            this->skipElement(types >> 4);
+                            this->skipElement(types & 0x0f);
+                        }
+                    }
+                    break;
+                }
+                case STRUCT:
+                    this->fields([this](int16_t, int fieldType) {
+                        this->skip(fieldType);
+                    });
+                    break;
+                default:
+                    throw runtime_error("Corrupt page header: unknown type " + to_string(type));
+            }
+        }
+
+        size_t length() const {
+            return this->position - this->begin;
+        }
+
+    private:
+        uint8_t byte() {
+            if (this->position >= this->end) {
+                throw runtime_error("Corrupt page header: exceeds column chunk");
+            }
+            return *this->position++;
+        }
+
+        void advance(uint64_t n) {
+            if (n > (uint64_t) (this->end - this->position)) {
+                throw runtime_error("Corrupt page header: exceeds column chunk");
+            }
+            this->position += n;
+        }
+
+        void skipElement(int type) {
+            // Booleans in containers take a byte
+            if (type == BOOLEAN_TRUE || type == BOOLEAN_FALSE) {
+                this->byte();
+            } else {
+                this->skip(type);
+            }
+        }
+
+        const uint8_t *begin;
+        const uint8_t *position;
+        const uint8_t *end;
+    };
+
+    static void parseStatistics(CompactReader &in, parquet::Statistics &statistics) {
+        statistics.__isset = decltype(statistics.__isset)();
+        in.fields([&](int16_t id, int type) {
+            if (id == 1 && type == BINARY) {
+                in.binary(statistics.max);
+                statistics.__isset.max = true;
+            } else if (id == 2 && type == BINARY) {
+                in.binary(statistics.min);
+                statistics.__isset.min = true;
+            } else if (id == 3 && type == I64) {
+                statistics.null_count = in.i64();
+                statistics.__isset.null_count = true;
+            } else if (id == 4 && type == I64) {
+                statistics.distinct_count = in.i64();
+                statistics.__isset.distinct_count = true;
+            } else {
+                in.skip(type);
+            }
+        });
+    }
+
+    static void parseDataPageHeader(CompactReader &in, parquet::DataPageHeader &header) {
+        header.__isset = decltype(header.__isset)();
+        unsigned required = 0;
+        in.fields([&](int16_t id, int type) {
+            if (id == 1 && type == I32) {
+                header.num_values = in.i32();
+                required |= 1;
+            } else if (id == 2 && type == I32) {
+                header.encoding = (parquet::Encoding::type) in.i32();
+                required |= 2;
+            } else if (id == 3 && type == I32) {
+                header.definition_level_encoding = (parquet::Encoding::type) in.i32();
+                required |= 4;
+            } else if (id == 4 && type == I32) {
+                header.repetition_level_encoding = (parquet::Encoding::type) in.i32();
+                required |= 8;
+            } else if (id == 5 && type == STRUCT) {
+                parseStatistics(in, header.statistics);
+                header.__isset.statistics = true;
+            } else {
+                in.skip(type);
+            }
+        });
+        if (required != 15) {
+            throw runtime_error("Corrupt page header: incomplete data page header");
+        }
+    }
+
+    static void parseDictionaryPageHeader(CompactReader &in, parquet::DictionaryPageHeader &header) {
+        unsigned required = 0;
+        header.is_sorted = false;
+        in.fields([&](int16_t id, int type) {
+            if (id == 1 && type == I32) {
+                header.num_values = in.i32();
+                required |= 1;
+            } else if (id == 2 && type == I32) {
+                header.encoding = (parquet::Encoding::type) in.i32();
+                required |= 2;
+            } else if (id == 3 && (type == BOOLEAN_TRUE || type == BOOLEAN_FALSE)) {
+                header.is_sorted = type == BOOLEAN_TRUE;
+            } else {
+                in.skip(type);
+            }
+        });
+        if (required != 3) {
+            throw runtime_error("Corrupt page header: incomplete dictionary page header");
+        }
+    }
+
+    uint32_t parsePageHeader(const uint8_t *data, size_t length, parquet::PageHeader *header) {
+        CompactReader in(data, length);
+        header->__isset = decltype(header->__isset)();
+        unsigned required = 0;
+        in.fields([&](int16_t id, int type) {
+            if (id == 1 && type == I32) {
+                header->type = (parquet::PageType::type) in.i32();
+                required |= 1;
+            } else if (id == 2 && type == I32) {
+                header->uncompressed_page_size = in.i32();
+                required |= 2;
+            } else if (id == 3 && type == I32) {
+                header->compressed_page_size = in.i32();
+                required |= 4;
+            } else if (id == 4 && type == I32) {
+                header->crc = in.i32();
+                header->__isset.crc = true;
+            } else if (id == 5 && type == STRUCT) {
+                parseDataPageHeader(in, header->data_page_header);
+                header->__isset.data_page_header = true;
+            } else if (id == 7 && type == STRUCT) {
+                parseDictionaryPageHeader(in, header->dictionary_page_header);
+                header->__isset.dictionary_page_header = true;
+            } else {
+                in.skip(type);
+            }
+        });
+        if (required != 7) {
+            throw runtime_error("Corrupt page header: missing type or size");
+        }
+        if (header->compressed_page_size < 0 || header->uncompressed_page_size < 0) {
+            throw runtime_error("Corrupt page header: negative page size");
+        }
+        return in.length();
+    }
+}
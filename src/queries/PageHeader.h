@@ -0,0 +1,23 @@
+#ifndef HDFS_BENCHMARK_PAGEHEADER_H
+#define HDFS_BENCHMARK_PAGEHEADER_H
+
+#include <parquet/parquet.h>
+
+#include <stdint.h>
+
+namespace benchmark {
+    /**
+     * Parses the Thrift compact encoded page header at `data` into `header`
+     * and returns its length. Unlike `DeserializeThriftMsg()`, which sets up
+     * a transport and protocol for every message, it does not allocate once
+     * the statistics strings of `header` are large enough, so that a header
+     * can be reused for all pages of a reader.
+     *
+     * Reads the fields of parquet-format's `PageHeader`, `DataPageHeader`,
+     * `DictionaryPageHeader` and `Statistics` that parquet-cpp knows of and
+     * skips all others. Throws on corrupt headers.
+     */
+    uint32_t parsePageHeader(const uint8_t *data, size_t length, parquet::PageHeader *header);
+};
+
+#endif //HDFS_BENCHMARK_PAGEHEADER_H
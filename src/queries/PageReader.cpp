@@ -0,0 +1,354 @@
+#include "PageReader.h"
+
+#include <stdexcept>
+#include <string>
+
+#include "Compression.h"
+#include "PageHeader.h"
+
+namespace benchmark {
+    void PageReader::reset(const uint8_t *data, size_t length, const parquet::ColumnMetaData *metaData,
+                           const parquet::SchemaElement *schema) {
+        if (schema->repetition_type == parquet::FieldRepetitionType::REPEATED) {
+            throw runtime_error("Repeated columns are not supported (" + schema->name + ")");
+        }
+        this->metaData = metaData;
+        this->schema = schema;
+        this->begin = data;
+        this->position = data;
+        this->end = data + length;
+        this->peekedPage = 0;
+        this->allDictionaryEncoded = -1;
+        this->maxDefinitionLevel = schema->repetition_type == parquet::FieldRepetitionType::OPTIONAL ? 1 : 0;
+
+        this->pageValuesLeft = 0;
+        this->dictionaryEncoded = false;
+        this->values = 0;
+        this->valuesEnd = 0;
+        this->dictionaryData = 0;
+        this->dictionarySize = 0;
+        this->byteArrayDictionary.clear();
+        this->decompressed.reset();
+
+        // Keep the buffers for the next column chunk
+        this->releaseRetired();
+        if (!this->pageBuffer.empty()) {
+            this->freeBuffers.push_back(move(this->pageBuffer));
+            this->pageBuffer.clear();
+        }
+    }
+
+    bool PageReader::nextPage() {
+        while (this->position < this->end) {
+            uint32_t headerLength = parsePageHeader(this->position, this->end - this->position, &this->pageHeader);
+
+            const uint8_t *page = this->position + headerLength;
+            this->position = page + this->pageHeader.compressed_page_size;
+            if (this->position > this->end) {
+                throw runtime_error("Corrupt page: exceeds column chunk");
+            }
+
+            switch (this->pageHeader.type) {
+                case parquet::PageType::DICTIONARY_PAGE:
+                    this->readDictionaryPage(page);
+                    break;
+                case parquet::PageType::DATA_PAGE:
+                    this->readDataPage(page);
+                    if (this->pageValuesLeft > 0) {
+                        return true;
+                    }
+                    break;
+                case parquet::PageType::DATA_PAGE_V2:
+                    throw runtime_error("DATA_PAGE_V2 is not supported");
+                default:
+                    // Index pages are skipped
+                    break;
+            }
+        }
+        return false;
+    }
+
+    const parquet::PageHeader *PageReader::peekDataPage() {
+        while (this->position < this->end) {
+            uint32_t headerLength = parsePageHeader(this->position, this->end - this->position, &this->pageHeader);
+
+            const uint8_t *page = this->position + headerLength;
+            if (page + this->pageHeader.compressed_page_size > this->end) {
+                throw runtime_error("Corrupt page: exceeds column chunk");
+            }
+
+            switch (this->pageHeader.type) {
+                case parquet::PageType::DATA_PAGE:
+                    this->peekedPage = page;
+                    return &this->pageHeader;
+                case parquet::PageType::DICTIONARY_PAGE:
+                    this->readDictionaryPage(page);
+                    break;
+                case parquet::PageType::DATA_PAGE_V2:
+                    throw runtime_error("DATA_PAGE_V2 is not supported");
+                default:
+                    break;
+            }
+            this->position = page + this->pageHeader.compressed_page_size;
+        }
+        return 0;
+    }
+
+    void PageReader::skipPage() {
+        if (this->decompressed) {
+            this->decompressed->skip(this->peekedPage);
+        }
+        this->position = this->peekedPage + this->pageHeader.compressed_page_size;
+    }
+
+    void PageReader::skip(size_t n) {
+        while (n > 0) {
+            if (this->pageValuesLeft == 0) {
+                while (const parquet::PageHeader *header = this->peekDataPage()) {
+                    if ((size_t) header->data_page_header.num_values > n) {
+                        break;
+                    }
+                    n -= header->data_page_header.num_values;
+                    this->skipPage();
+                }
+                if (n == 0) {
+                    break;
+                }
+                if (!this->nextPage()) {
+                    throw runtime_error("Skipping past the end of the column chunk");
+                }
+            }
+
+            size_t count = min(n, this->pageValuesLeft);
+            this->skipValues(count);
+            this->pageValuesLeft -= count;
+            n -= count;
+        }
+    }
+
+    void PageReader::skipValues(size_t n) {
+        size_t present = n;
+        if (this->maxDefinitionLevel > 0) {
+            if (this->skippedLevels.size() < n) {
+                this->skippedLevels.resize(n);
+            }
+            this->definitionLevels.get(this->skippedLevels.data(), n);
+            present = 0;
+            for (size_t i = 0; i < n; i++) {
+                present += this->skippedLevels[i] == (uint32_t) this->maxDefinitionLevel;
+            }
+        }
+
+        if (this->dictionaryEncoded) {
+            this->dictionaryIndices.skip(present);
+            return;
+        }
+
+        switch (this->metaData->type) {
+            case parquet::Type::INT32:
+            case parquet::Type::FLOAT:
+                this->values += 4 * present;
+                break;
+            case parquet::Type::INT64:
+            case parquet::Type::DOUBLE:
+                this->values += 8 * present;
+                break;
+            case parquet::Type::BYTE_ARRAY:
+                for (size_t i = 0; i < present; i++) {
+                    if (this->values + 4 > this->valuesEnd) {
+                        throw runtime_error("Corrupt page: not enough values");
+                    }
+                    this->values += 4 + *reinterpret_cast<const uint32_t *>(this->values);
+                }
+                break;
+            default:
+                throw runtime_error("Skipping is not supported for type " + to_string((int) this->metaData->type));
+        }
+        if (this->values > this->valuesEnd) {
+            throw runtime_error("Corrupt page: not enough values");
+        }
+    }
+
+    bool PageReader::allPagesDictionaryEncoded() {
+        if (this->allDictionaryEncoded >= 0) {
+            return this->allDictionaryEncoded;
+        }
+
+        bool dictionary = false, allDictionary = true;
+        const uint8_t *p = this->begin;
+        while (p < this->end && allDictionary) {
+            parquet::PageHeader &header = this->scratchHeader;
+            uint32_t headerLength = parsePageHeader(p, this->end - p, &header);
+            p += headerLength + header.compressed_page_size;
+
+            switch (header.type) {
+                case parquet::PageType::DICTIONARY_PAGE:
+                    dictionary = true;
+                    break;
+                case parquet::PageType::DATA_PAGE:
+                    allDictionary = header.data_page_header.encoding == parquet::Encoding::PLAIN_DICTIONARY ||
+                                    header.data_page_header.encoding == parquet::Encoding::RLE_DICTIONARY;
+                    break;
+                case parquet::PageType::DATA_PAGE_V2:
+                    allDictionary = false;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        this->allDictionaryEncoded = dictionary && allDictionary;
+        return this->allDictionaryEncoded;
+    }
+
+    const uint8_t *PageReader::decompressPage(const uint8_t *page, vector<uint8_t> &buffer) {
+        if (this->metaData->codec == parquet::CompressionCodec::UNCOMPRESSED) {
+            return page;
+        }
+        if (this->decompressed) {
+            if (const uint8_t *data = this->decompressed->get(page)) {
+                return data;
+            }
+        }
+        buffer.resize(this->pageHeader.uncompressed_page_size);
+        decompress(this->metaData->codec, page, this->pageHeader.compressed_page_size,
+                   buffer.data(), buffer.size());
+        return buffer.data();
+    }
+
+    void PageReader::readDictionaryPage(const uint8_t *page) {
+        auto encoding = this->pageHeader.dictionary_page_header.encoding;
+        if (encoding != parquet::Encoding::PLAIN && encoding != parquet::Encoding::PLAIN_DICTIONARY) {
+            throw runtime_error("Unsupported dictionary encoding " + to_string((int) encoding));
+        }
+
+        this->dictionaryData = this->decompressPage(page, this->dictionaryBuffer);
+        this->dictionarySize = this->pageHeader.dictionary_page_header.num_values;
+        this->byteArrayDictionary.clear();
+
+        // Decode byte arrays once, fixed width values are used in place
+        if (this->metaData->type == parquet::Type::BYTE_ARRAY) {
+            this->values = this->dictionaryData;
+            this->valuesEnd = this->dictionaryData + this->pageHeader.uncompressed_page_size;
+            this->byteArrayDictionary.resize(this->dictionarySize);
+            this->readPlain(this->byteArrayDictionary.data(), this->dictionarySize);
+        }
+    }
+
+    void PageReader::readDataPage(const uint8_t *page) {
+        auto &header = this->pageHeader.data_page_header;
+
+        // Keep the previous page alive until the current batch is done
+        if (!this->pageBuffer.empty()) {
+            this->retiredBuffers.push_back(move(this->pageBuffer));
+            this->pageBuffer.clear();
+        }
+        if (this->pageBuffer.capacity() == 0 && !this->freeBuffers.empty()) {
+            this->pageBuffer = move(this->freeBuffers.back());
+            this->freeBuffers.pop_back();
+        }
+
+        const uint8_t *data = this->decompressPage(page, this->pageBuffer);
+        const uint8_t *dataEnd = data + this->pageHeader.uncompressed_page_size;
+
+        if (this->maxDefinitionLevel > 0) {
+            if (header.definition_level_encoding != parquet::Encoding::RLE) {
+                throw runtime_error("Unsupported definition level encoding");
+            }
+            uint32_t length = *reinterpret_cast<const uint32_t *>(data);
+            if (data + 4 + length > dataEnd) {
+                throw runtime_error("Corrupt definition levels");
+            }
+            this->definitionLevels.reset(data + 4, length, 1);
+            data += 4 + length;
+        }
+
+        switch (header.encoding) {
+            case parquet::Encoding::PLAIN:
+                this->dictionaryEncoded = false;
+                break;
+            case parquet::Encoding::PLAIN_DICTIONARY:
+            case parquet::Encoding::RLE_DICTIONARY:
+                if (this->dictionaryData == 0) {
+                    throw runtime_error("Dictionary encoded page without dictionary");
+                }
+                this->dictionaryEncoded = true;
+                this->dictionaryIndices.reset(data + 1, dataEnd - data - 1, *data);
+                break;
+            default:
+                throw runtime_error("Unsupported encoding " + to_string((int) header.encoding));
+        }
+
+        this->values = data;
+        this->valuesEnd = dataEnd;
+        this->pageValuesLeft = header.num_values;
+    }
+
+    void PageReader::releaseRetired() {
+        for (auto &buffer : this->retiredBuffers) {
+            this->freeBuffers.push_back(move(buffer));
+        }
+        this->retiredBuffers.clear();
+    }
+
+    template<typename T>
+    static void readFixed(const uint8_t *&values, const uint8_t *valuesEnd, T *out, size_t n) {
+        if (values + n * sizeof(T) > valuesEnd) {
+            throw runtime_error("Corrupt page: not enough values");
+        }
+        memcpy(out, values, n * sizeof(T));
+        values += n * sizeof(T);
+    }
+
+    template<>
+    void PageReader::readPlain(int32_t *out, size_t n) {
+        readFixed(this->values, this->valuesEnd, out, n);
+    }
+
+    template<>
+    void PageReader::readPlain(int64_t *out, size_t n) {
+        readFixed(this->values, this->valuesEnd, out, n);
+    }
+
+    template<>
+    void PageReader::readPlain(float *out, size_t n) {
+        readFixed(this->values, this->valuesEnd, out, n);
+    }
+
+    template<>
+    void PageReader::readPlain(double *out, size_t n) {
+        readFixed(this->values, this->valuesEnd, out, n);
+    }
+
+    template<>
+    void PageReader::readPlain(ByteArray *out, size_t n) {
+        const uint8_t *v = this->values;
+        for (size_t i = 0; i < n; i++) {
+            if (v + 4 > this->valuesEnd) {
+                throw runtime_error("Corrupt page: not enough values");
+            }
+            out[i].len = *reinterpret_cast<const uint32_t *>(v);
+            out[i].ptr = v + 4;
+            v += 4 + out[i].len;
+        }
+        if (v > this->valuesEnd) {
+            throw runtime_error("Corrupt page: not enough values");
+        }
+        this->values = v;
+    }
+
+    template<typename T>
+    const T *PageReader::getDictionary() {
+        return reinterpret_cast<const T *>(this->dictionaryData);
+    }
+
+    template<>
+    const ByteArray *PageReader::getDictionary() {
+        return this->byteArrayDictionary.data();
+    }
+
+    template const int32_t *PageReader::getDictionary();
+    template const int64_t *PageReader::getDictionary();
+    template const float *PageReader::getDictionary();
+    template const double *PageReader::getDictionary();
+}
@@ -0,0 +1,208 @@
+#ifndef HDFS_BENCHMARK_PAGEREADER_H
+#define HDFS_BENCHMARK_PAGEREADER_H
+
+#include <memory>
+#include <vector>
+
+#include <parquet/parquet.h>
+
+#include <stdint.h>
+
+#include "Decompression.h"
+#include "Rle.h"
+
+using namespace std;
+using namespace parquet_cpp;
+
+namespace benchmark {
+    /**
+     * Iterates over the data pages of a flat (non-nested) column chunk held
+     * in memory. Decompresses each page, reads the dictionary page if there
+     * is one, and decodes definition levels, dictionary indices and PLAIN
+     * values of the current page in batches.
+     *
+     * Decompressed pages are kept alive until `releaseRetired()`, so that
+     * `ByteArray`s pointing into a page remain valid after the reader moved
+     * on to the next page.
+     *
+     * A reader can be `reset()` to another column chunk, keeping its page
+     * and dictionary buffers.
+     */
+    class PageReader {
+    public:
+        PageReader() {
+
+        }
+
+        PageReader(const uint8_t *data, size_t length, const parquet::ColumnMetaData *metaData,
+                   const parquet::SchemaElement *schema) {
+            this->reset(data, length, metaData, schema);
+        }
+
+        PageReader(const PageReader &) = delete;
+
+        PageReader &operator=(const PageReader &) = delete;
+
+        /**
+         * Starts over at the beginning of the column chunk `[data, data + length)`.
+         */
+        void reset(const uint8_t *data, size_t length, const parquet::ColumnMetaData *metaData,
+                   const parquet::SchemaElement *schema);
+
+        /**
+         * Advances to the next data page, returns false at the end of the
+         * column chunk.
+         */
+        bool nextPage();
+
+        /**
+         * Parses the header of the next data page without loading the page,
+         * reads a dictionary page on the way. Returns null at the end of the
+         * column chunk. Only valid when no values are left in the current
+         * page.
+         */
+        const parquet::PageHeader *peekDataPage();
+
+        /**
+         * Skips the data page returned by `peekDataPage()`.
+         */
+        void skipPage();
+
+        /**
+         * Skips `n` values, whole pages without decompressing them.
+         */
+        void skip(size_t n);
+
+        /**
+         * Number of values (including nulls) left in the current page.
+         */
+        size_t valuesLeft() const {
+            return this->pageValuesLeft;
+        }
+
+        /**
+         * Marks `n` values of the current page as read.
+         */
+        void consume(size_t n) {
+            this->pageValuesLeft -= n;
+        }
+
+        int getMaxDefinitionLevel() const {
+            return this->maxDefinitionLevel;
+        }
+
+        size_t readDefinitionLevels(uint32_t *levels, size_t n) {
+            return this->definitionLevels.get(levels, n);
+        }
+
+        /**
+         * True if the current page is dictionary encoded.
+         */
+        bool isDictionaryEncoded() const {
+            return this->dictionaryEncoded;
+        }
+
+        /**
+         * True if the chunk has a dictionary page and all its data pages are
+         * dictionary encoded. Parses all page headers the first time.
+         */
+        bool allPagesDictionaryEncoded();
+
+        size_t readIndices(uint32_t *indices, size_t n) {
+            return this->dictionaryIndices.get(indices, n);
+        }
+
+        /**
+         * Decodes `n` PLAIN encoded values of the current page.
+         */
+        template<typename T>
+        void readPlain(T *out, size_t n);
+
+        /**
+         * The values of the column chunk's dictionary page.
+         */
+        template<typename T>
+        const T *getDictionary();
+
+        size_t getDictionarySize() const {
+            return this->dictionarySize;
+        }
+
+        const parquet::PageHeader &getPageHeader() const {
+            return this->pageHeader;
+        }
+
+        /**
+         * Allows the buffers of pages before the current one to be reused.
+         */
+        void releaseRetired();
+
+        /**
+         * Takes the following pages from `pages`, which decompresses them
+         * ahead of the reader, instead of decompressing them itself.
+         */
+        void decompressAhead(shared_ptr<DecompressedPages> pages) {
+            this->decompressed = pages;
+        }
+
+        /**
+         * Start of the next page header.
+         */
+        const uint8_t *getPosition() const {
+            return this->position;
+        }
+
+        const uint8_t *getEnd() const {
+            return this->end;
+        }
+
+    private:
+        const uint8_t *decompressPage(const uint8_t *page, vector<uint8_t> &buffer);
+
+        void readDictionaryPage(const uint8_t *page);
+
+        void readDataPage(const uint8_t *page);
+
+        void skipValues(size_t n);
+
+        const parquet::ColumnMetaData *metaData = 0;
+        const parquet::SchemaElement *schema = 0;
+        const uint8_t *begin = 0;
+        const uint8_t *position = 0;
+        const uint8_t *end = 0;
+        const uint8_t *peekedPage = 0;
+        int allDictionaryEncoded = -1;
+
+        int maxDefinitionLevel = 0;
+        parquet::PageHeader pageHeader;
+        parquet::PageHeader scratchHeader;
+        size_t pageValuesLeft = 0;
+
+        RleDecoder definitionLevels;
+        bool dictionaryEncoded = false;
+        RleDecoder dictionaryIndices;
+        const uint8_t *values = 0;
+        const uint8_t *valuesEnd = 0;
+
+        vector<uint8_t> dictionaryBuffer;
+        const uint8_t *dictionaryData = 0;
+        size_t dictionarySize = 0;
+        vector<ByteArray> byteArrayDictionary;
+        vector<uint32_t> skippedLevels;
+
+        shared_ptr<DecompressedPages> decompressed;
+        vector<uint8_t> pageBuffer;
+        vector<vector<uint8_t>> retiredBuffers;
+        vector<vector<uint8_t>> freeBuffers;
+    };
+
+    template<> void PageReader::readPlain(int32_t *out, size_t n);
+    template<> void PageReader::readPlain(int64_t *out, size_t n);
+    template<> void PageReader::readPlain(float *out, size_t n);
+    template<> void PageReader::readPlain(double *out, size_t n);
+    template<> void PageReader::readPlain(ByteArray *out, size_t n);
+
+    template<> const ByteArray *PageReader::getDictionary();
+};
+
+#endif //HDFS_BENCHMARK_PAGEREADER_H
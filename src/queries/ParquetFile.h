@@ -28,15 +28,23 @@ class ParquetFile {
 public:
     /**
      * Constructs a new instance of `ParquetReader` and parses the files meta data.
+     * Row groups and column chunks are views of the parsed meta data, they
+     * are valid as long as the file.
      */
     ParquetFile(const uint8_t *buffer, size_t bufferLength) : buffer(buffer), bufferLength(bufferLength) {
         this->readMetaData();
 
+        this->rowGroups.reserve(this->fileMetaData.row_groups.size());
         for(auto &rowGroup : this->fileMetaData.row_groups) {
-            this->rowGroups.push_back(benchmark::RowGroup(this, rowGroup));
+            this->rowGroups.emplace_back(this, rowGroup);
         }
     }
 
+    // Row groups point into the file's meta data and back to the file
+    ParquetFile(const ParquetFile &) = delete;
+
+    ParquetFile &operator=(const ParquetFile &) = delete;
+
     const uint8_t *getBuffer() {
         return this->buffer;
     }
@@ -0,0 +1,222 @@
+#ifndef HDFS_BENCHMARK_PERFCOUNTERS_H
+#define HDFS_BENCHMARK_PERFCOUNTERS_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+/**
+ * Hardware and software performance counters per phase, backed by
+ * perf_event_open. Counters only count the calling thread and are opened
+ * lazily per thread. Enabled by setting the environment variable
+ * PERF_COUNTERS, since every phase boundary costs a few syscalls.
+ */
+namespace perf {
+    enum Counter {
+        Cycles = 0, Instructions, LLCMisses, DTLBMisses, BranchMisses, PageFaults, ContextSwitches, CounterCount
+    };
+
+    static const char *counterNames[] = {
+            "cycles", "instructions", "llc_misses", "dtlb_misses", "branch_misses", "page_faults", "ctx_switches"
+    };
+
+    struct Values {
+        uint64_t counters[CounterCount] = {0};
+        uint64_t bytes = 0;
+        uint64_t calls = 0;
+
+        void add(const Values &other) {
+            for (unsigned c = 0; c < CounterCount; c++) {
+                counters[c] += other.counters[c];
+            }
+            bytes += other.bytes;
+            calls += other.calls;
+        }
+    };
+
+    inline bool enabled() {
+        static bool enabled = getenv("PERF_COUNTERS") != 0;
+        return enabled;
+    }
+
+    class Registry {
+    public:
+        /**
+         * The counters of one thread and the values it accumulated per phase.
+         */
+        struct Local {
+            Local() {
+                static const uint32_t types[] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE,
+                                                 PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE, PERF_TYPE_SOFTWARE,
+                                                 PERF_TYPE_SOFTWARE};
+                static const uint64_t configs[] = {
+                        PERF_COUNT_HW_CPU_CYCLES,
+                        PERF_COUNT_HW_INSTRUCTIONS,
+                        PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+                        PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+                        PERF_COUNT_HW_BRANCH_MISSES,
+                        PERF_COUNT_SW_PAGE_FAULTS,
+                        PERF_COUNT_SW_CONTEXT_SWITCHES
+                };
+
+                for (unsigned c = 0; c < CounterCount; c++) {
+                    struct perf_event_attr attr;
+                    memset(&attr, 0, sizeof(attr));
+                    attr.size = sizeof(attr);
+                    attr.type = types[c];
+                    attr.config = configs[c];
+                    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+                    attr.exclude_kernel = attr.type != PERF_TYPE_SOFTWARE;
+                    attr.exclude_hv = 1;
+                    fds[c] = (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+                }
+                Registry::get().attach(this);
+            }
+
+            ~Local() {
+                Registry::get().detach(this);
+                for (unsigned c = 0; c < CounterCount; c++) {
+                    if (fds[c] >= 0) {
+                        close(fds[c]);
+                    }
+                }
+            }
+
+            /**
+             * Reads all counters, scaled for the time they were multiplexed.
+             * Counters that could not be opened read as 0.
+             */
+            void read(uint64_t *values) {
+                for (unsigned c = 0; c < CounterCount; c++) {
+                    uint64_t data[3] = {0, 0, 0};
+                    if (fds[c] < 0 || ::read(fds[c], data, sizeof(data)) != sizeof(data)) {
+                        values[c] = 0;
+                    } else {
+                        values[c] = data[2] > 0 ? (uint64_t) ((double) data[0] * data[1] / data[2]) : data[0];
+                    }
+                }
+            }
+
+            int fds[CounterCount];
+            std::map<std::string, Values> phases;
+        };
+
+        static Registry &get() {
+            static Registry registry;
+            return registry;
+        }
+
+        /**
+         * Prints the counters, IPC and bytes per cycle of every phase.
+         */
+        void print(FILE *out) {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            std::map<std::string, Values> merged(totals);
+            for (auto local : locals) {
+                for (auto &phase : local->phases) {
+                    merged[phase.first].add(phase.second);
+                }
+            }
+
+            fprintf(out, "%-22s %8s", "phase", "calls");
+            for (unsigned c = 0; c < CounterCount; c++) {
+                fprintf(out, " %14s", counterNames[c]);
+            }
+            fprintf(out, " %6s %12s\n", "ipc", "bytes/cycle");
+            for (auto &phase : merged) {
+                Values &v = phase.second;
+                fprintf(out, "%-22s %8lu", phase.first.c_str(), (unsigned long) v.calls);
+                for (unsigned c = 0; c < CounterCount; c++) {
+                    fprintf(out, " %14lu", (unsigned long) v.counters[c]);
+                }
+                double cycles = v.counters[Cycles];
+                fprintf(out, " %6.2f", cycles > 0 ? v.counters[Instructions] / cycles : 0.0);
+                if (v.bytes > 0 && cycles > 0) {
+                    fprintf(out, " %12.3f\n", v.bytes / cycles);
+                } else {
+                    fprintf(out, " %12s\n", "-");
+                }
+            }
+        }
+
+    private:
+        void attach(Local *local) {
+            std::lock_guard<std::mutex> lock(mutex);
+            locals.insert(local);
+        }
+
+        void detach(Local *local) {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto &phase : local->phases) {
+                totals[phase.first].add(phase.second);
+            }
+            locals.erase(local);
+        }
+
+        std::mutex mutex;
+        std::set<Local *> locals;
+        std::map<std::string, Values> totals;
+    };
+
+    inline Registry::Local &local() {
+        static thread_local Registry::Local local;
+        return local;
+    }
+
+    inline void print(FILE *out = stderr) {
+        if (enabled()) {
+            Registry::get().print(out);
+        }
+    }
+
+    /**
+     * Attributes the counter deltas between construction and destruction,
+     * and `bytes` processed, to `phase`. Phases may nest.
+     */
+    class Phase {
+    public:
+        Phase(const char *phase, uint64_t bytes = 0) : phase(phase), bytes(bytes) {
+            if (enabled()) {
+                local().read(start);
+            }
+        }
+
+        void addBytes(uint64_t bytes) {
+            this->bytes += bytes;
+        }
+
+        ~Phase() {
+            if (!enabled()) {
+                return;
+            }
+            uint64_t end[CounterCount];
+            Registry::Local &l = local();
+            l.read(end);
+
+            Values &values = l.phases[phase];
+            for (unsigned c = 0; c < CounterCount; c++) {
+                values.counters[c] += end[c] - start[c];
+            }
+            values.bytes += bytes;
+            values.calls++;
+        }
+
+    private:
+        const char *phase;
+        uint64_t bytes;
+        uint64_t start[CounterCount];
+    };
+}
+
+#endif //HDFS_BENCHMARK_PERFCOUNTERS_H
@@ -0,0 +1,489 @@
+#ifndef HDFS_BENCHMARK_PIPELINE_H
+#define HDFS_BENCHMARK_PIPELINE_H
+
+#include <functional>
+#include <map>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <stdint.h>
+
+#include "HashJoin.h"
+#include "HdfsReader.h"
+#include "Latency.h"
+#include "Morsel.h"
+#include "Operators.h"
+#include "PerfCounters.h"
+#include "Scan.h"
+#include "Trace.h"
+
+using namespace std;
+
+/**
+ * Query pipelines that are composed of typed stages at compile time. Unlike
+ * the operators of `Operators.h`, which push batches through virtual calls,
+ * all stages of a pipeline are template parameters, so the compiler inlines
+ * them into the loop over the qualifying rows of each batch, like the hand
+ * written queries:
+ *
+ *     struct DiscPrice : pipeline::Value<double> {};
+ *
+ *     auto sums = pipeline::reduce<double, DiscPrice>(pool, [](double &sum, double discPrice) {
+ *         sum += discPrice;
+ *     }, [](double &sum, const double &other) { sum += other; });
+ *     pipeline::scan<tpch::Lineitem, tpch::l_extendedprice, tpch::l_discount>()
+ *             .between<tpch::l_shipdate>(Date(19950901), Date(19950930))
+ *             .map<DiscPrice, tpch::l_extendedprice, tpch::l_discount>([](double price, double discount) {
+ *                 return price * (1 - discount);
+ *             })
+ *             .run(hdfsReader, pool, lineitemPath, "lineitem_scan", sums);
+ *
+ * Columns are the types declared in a schema such as `Tpch.h`, so their
+ * index and value type are known at compile time. Scanning a column that
+ * is not part of the table or reading a value that is neither scanned nor
+ * computed by an earlier stage does not compile, and stages are called
+ * with the declared types of the values they ask for.
+ */
+namespace pipeline {
+    /**
+     * A value of type `T` of a row, the base of columns and of the values
+     * computed by `map()` and `probe()` stages.
+     */
+    template<typename T>
+    struct Value {
+        typedef T type;
+    };
+
+    /**
+     * Column `Index` of a table, stored as `T`.
+     */
+    template<unsigned Index, typename T>
+    struct Column : Value<T> {
+        static const unsigned index = Index;
+    };
+
+    template<typename C, typename... Cs>
+    struct Contains : false_type {
+    };
+
+    template<typename C, typename Head, typename... Tail>
+    struct Contains<C, Head, Tail...> :
+            conditional<is_same<C, Head>::value, true_type, Contains<C, Tail...>>::type {
+    };
+
+    /**
+     * The columns of a table, see `Tpch.h`.
+     */
+    template<typename... Cs>
+    struct Schema {
+        template<typename C>
+        struct Has : Contains<C, Cs...> {
+        };
+    };
+
+    template<typename C, typename... Cs>
+    struct IndexOf {
+        static_assert(sizeof(C) == 0, "Value is neither scanned nor computed by an earlier stage");
+    };
+
+    template<typename C, typename... Tail>
+    struct IndexOf<C, C, Tail...> : integral_constant<size_t, 0> {
+    };
+
+    template<typename C, typename Head, typename... Tail>
+    struct IndexOf<C, Head, Tail...> : integral_constant<size_t, 1 + IndexOf<C, Tail...>::value> {
+    };
+
+    /**
+     * Row `i` of the current batch of a scan of the columns `Cs`.
+     */
+    template<typename... Cs>
+    class ScanRow {
+    public:
+        ScanRow(unsigned worker, const typename Cs::type *... columns) : columns(columns...), w(worker) {
+
+        }
+
+        template<typename C>
+        const typename C::type &get() const {
+            return std::get<IndexOf<C, Cs...>::value>(this->columns)[this->i];
+        }
+
+        unsigned worker() const {
+            return this->w;
+        }
+
+        uint32_t i = 0;
+
+    private:
+        tuple<const typename Cs::type *...> columns;
+        unsigned w;
+    };
+
+    /**
+     * A row extended with the value `Tag` computed by a stage.
+     */
+    template<typename Row, typename Tag>
+    class DerivedRow {
+    public:
+        DerivedRow(const Row &row, const typename Tag::type &value) : row(row), value(value) {
+
+        }
+
+        template<typename C>
+        const typename C::type &get() const {
+            return this->get<C>(is_same<C, Tag>());
+        }
+
+        unsigned worker() const {
+            return this->row.worker();
+        }
+
+    private:
+        template<typename C>
+        const typename C::type &get(true_type) const {
+            return this->value;
+        }
+
+        template<typename C>
+        const typename C::type &get(false_type) const {
+            return this->row.template get<C>();
+        }
+
+        const Row &row;
+        typename Tag::type value;
+    };
+
+    template<typename F, typename... Cs>
+    struct FilterStage {
+        F predicate;
+
+        template<typename Row, typename Next>
+        void push(const Row &row, const Next &next) const {
+            if (this->predicate(row.template get<Cs>()...)) {
+                next(row);
+            }
+        }
+    };
+
+    template<typename Tag, typename F, typename... Cs>
+    struct MapStage {
+        F f;
+
+        template<typename Row, typename Next>
+        void push(const Row &row, const Next &next) const {
+            next(DerivedRow<Row, Tag>(row, this->f(row.template get<Cs>()...)));
+        }
+    };
+
+    template<typename Tag, typename Key>
+    struct ProbeStage {
+        typedef typename Tag::type V;
+
+        const benchmark::CsrIndex<V> *index;
+
+        template<typename Row, typename Next>
+        void push(const Row &row, const Next &next) const {
+            this->index->find(row.template get<Key>(), [&](const V *begin, const V *end) {
+                for (const V *value = begin; value != end; value++) {
+                    next(DerivedRow<Row, Tag>(row, *value));
+                }
+            });
+        }
+    };
+
+    /**
+     * Pushes a row to stage `I` of `Stages`, or to the sink after the last.
+     */
+    template<size_t I, typename Stages, typename Sink, bool End = (I == tuple_size<Stages>::value)>
+    struct Push {
+        const Stages &stages;
+        Sink &sink;
+
+        template<typename Row>
+        void operator()(const Row &row) const {
+            std::get<I>(this->stages).push(row, Push<I + 1, Stages, Sink>{this->stages, this->sink});
+        }
+    };
+
+    template<size_t I, typename Stages, typename Sink>
+    struct Push<I, Stages, Sink, true> {
+        const Stages &stages;
+        Sink &sink;
+
+        template<typename Row>
+        void operator()(const Row &row) const {
+            this->sink.push(row);
+        }
+    };
+
+    template<typename... Cs>
+    struct Columns {
+    };
+
+    template<typename Table, typename Scanned, typename... Stages>
+    class Pipeline;
+
+    /**
+     * Scans the columns `Cs` of `Table`, see `scan()`. Every stage returns
+     * a new pipeline that ends with it.
+     */
+    template<typename Table, typename... Cs, typename... Stages>
+    class Pipeline<Table, Columns<Cs...>, Stages...> {
+    public:
+        Pipeline(const vector<function<void(benchmark::Scan &)>> &predicates, const tuple<Stages...> &stages) :
+                predicates(predicates), stages(stages) {
+
+        }
+
+        /**
+         * Selects rows with lower <= value <= upper in the scan, see
+         * `Scan::between()`.
+         */
+        template<typename C>
+        Pipeline between(const typename C::type &lower, const typename C::type &upper) const {
+            static_assert(Table::template Has<C>::value, "Column is not part of the table");
+            Pipeline pipeline = *this;
+            pipeline.predicates.push_back([lower, upper](benchmark::Scan &scan) {
+                scan.between(C::index, lower, upper);
+            });
+            return pipeline;
+        }
+
+        /**
+         * Selects rows for which `predicate(value)` is true in the scan, see
+         * `Scan::where()`.
+         */
+        template<typename C, typename P>
+        Pipeline where(P predicate) const {
+            static_assert(Table::template Has<C>::value, "Column is not part of the table");
+            Pipeline pipeline = *this;
+            pipeline.predicates.push_back([predicate](benchmark::Scan &scan) {
+                scan.where<typename C::type>(C::index, predicate);
+            });
+            return pipeline;
+        }
+
+        /**
+         * Keeps the rows for which `predicate(values of Args...)` is true.
+         */
+        template<typename... Args, typename F>
+        Pipeline<Table, Columns<Cs...>, Stages..., FilterStage<F, Args...>> filter(F predicate) const {
+            return this->append(FilterStage<F, Args...>{predicate});
+        }
+
+        /**
+         * Adds the value `Tag` as `f(values of Args...)` to the rows.
+         */
+        template<typename Tag, typename... Args, typename F>
+        Pipeline<Table, Columns<Cs...>, Stages..., MapStage<Tag, F, Args...>> map(F f) const {
+            return this->append(MapStage<Tag, F, Args...>{f});
+        }
+
+        /**
+         * Probes `index` with the value `Key`, adds the value of every
+         * match as `Tag` to a copy of the row.
+         */
+        template<typename Tag, typename Key>
+        Pipeline<Table, Columns<Cs...>, Stages..., ProbeStage<Tag, Key>> probe(
+                const benchmark::CsrIndex<typename Tag::type> &index) const {
+            return this->append(ProbeStage<Tag, Key>{&index});
+        }
+
+        /**
+         * Scans all files at `path` on `pool`, pushes the rows through all
+         * stages into `sink` and finishes it.
+         */
+        template<typename Sink>
+        void run(HdfsReader &hdfsReader, MorselPool &pool, const string &path, const char *phase, Sink &sink) const {
+            hdfsReader.read(path, [](vector<string> &paths) {
+            }, [&](Block block) {
+                pool.scan(openFile(block), [&](unsigned worker, benchmark::RowGroup &rowGroup, uint64_t firstRow) {
+                    perf::Phase p(phase, rowGroup.getCompressedSize());
+                    latency::Scoped decode(latency::RowGroupDecode);
+                    trace::Scoped traced("rowgroup_decode");
+                    this->scan(worker, rowGroup, sink);
+                });
+            }, pool.getWorkerCount());
+            pool.wait();
+            sink.finish();
+        }
+
+        /**
+         * Pushes the rows at the `count` positions in `selection` of a batch
+         * of the scanned columns through all stages into `sink`, as `run()`
+         * does for every batch of the scan. The sink is not finished.
+         */
+        template<typename Sink>
+        void push(Sink &sink, unsigned worker, const uint32_t *selection, size_t count,
+                  const typename Cs::type *... columns) const {
+            this->pushRows(sink, ScanRow<Cs...>(worker, columns...), selection, count);
+        }
+
+    private:
+        template<typename Stage>
+        Pipeline<Table, Columns<Cs...>, Stages..., Stage> append(const Stage &stage) const {
+            return Pipeline<Table, Columns<Cs...>, Stages..., Stage>(
+                    this->predicates, tuple_cat(this->stages, make_tuple(stage)));
+        }
+
+        template<typename Sink>
+        void scan(unsigned worker, benchmark::RowGroup &rowGroup, Sink &sink) const {
+            benchmark::Scan scan(rowGroup);
+            for (auto &predicate : this->predicates) {
+                predicate(scan);
+            }
+            ScanRow<Cs...> row(worker, scan.column<typename Cs::type>(Cs::index)...);
+            scan.run([&](const uint32_t *selection, size_t count) {
+                this->pushRows(sink, row, selection, count);
+            });
+        }
+
+        template<typename Sink>
+        void pushRows(Sink &sink, ScanRow<Cs...> row, const uint32_t *selection, size_t count) const {
+            Push<0, tuple<Stages...>, Sink> push{this->stages, sink};
+            for (size_t k = 0; k < count; k++) {
+                row.i = selection[k];
+                push(row);
+            }
+        }
+
+        vector<function<void(benchmark::Scan &)>> predicates;
+        tuple<Stages...> stages;
+    };
+
+    /**
+     * A pipeline that scans the columns `Cs` of `Table`.
+     */
+    template<typename Table, typename... Cs>
+    Pipeline<Table, Columns<Cs...>> scan() {
+        static_assert(sizeof...(Cs) <= benchmark::MAX_COLUMNS, "Too many columns");
+        static_assert(!Contains<false_type, typename Table::template Has<Cs>::type...>::value,
+                      "Column is not part of the table");
+        return Pipeline<Table, Columns<Cs...>>(vector<function<void(benchmark::Scan &)>>(), tuple<>());
+    }
+
+    /**
+     * Sink that folds the rows into one `A` per worker with
+     * `update(a, values of Cs...)`, combined with `merge(a, other)`.
+     */
+    template<typename A, typename U, typename M, typename... Cs>
+    class Reduce {
+    public:
+        Reduce(MorselPool &pool, U update, M merge) : update(update), merge(merge), partial(pool) {
+
+        }
+
+        template<typename Row>
+        void push(const Row &row) {
+            this->update(this->partial[row.worker()], row.template get<Cs>()...);
+        }
+
+        void finish() {
+            for (unsigned worker = 0; worker < this->partial.size(); worker++) {
+                this->merge(this->result, this->partial[worker]);
+            }
+        }
+
+        const A &getResult() const {
+            return this->result;
+        }
+
+    private:
+        U update;
+        M merge;
+        PerWorker<A> partial;
+        A result = A();
+    };
+
+    template<typename A, typename... Cs, typename U, typename M>
+    Reduce<A, U, M, Cs...> reduce(MorselPool &pool, U update, M merge) {
+        return Reduce<A, U, M, Cs...>(pool, update, merge);
+    }
+
+    /**
+     * Sink that groups the rows by the value `Key` and folds them into an
+     * `A` per group with `update(a, values of Cs...)`. The groups of the
+     * workers are combined with `merge(a, other)`.
+     */
+    template<typename Key, typename A, typename U, typename M, typename... Cs>
+    class Aggregate {
+    public:
+        typedef typename Key::type K;
+
+        Aggregate(MorselPool &pool, U update, M merge) : update(update), merge(merge), tables(pool) {
+
+        }
+
+        template<typename Row>
+        void push(const Row &row) {
+            A &a = this->tables[row.worker()].get(row.template get<Key>());
+            this->update(a, row.template get<Cs>()...);
+        }
+
+        void finish() {
+            for (unsigned worker = 0; worker < this->tables.size(); worker++) {
+                for (auto &group : this->tables[worker].getGroups()) {
+                    auto it = this->result.find(group.first);
+                    if (it == this->result.end()) {
+                        this->result.insert(group);
+                    } else {
+                        this->merge(it->second, group.second);
+                    }
+                }
+            }
+        }
+
+        /**
+         * The groups ordered by key.
+         */
+        const map<K, A> &getResult() const {
+            return this->result;
+        }
+
+    private:
+        U update;
+        M merge;
+        PerWorker<benchmark::GroupTable<K, A>> tables;
+        map<K, A> result;
+    };
+
+    template<typename Key, typename A, typename... Cs, typename U, typename M>
+    Aggregate<Key, A, U, M, Cs...> aggregate(MorselPool &pool, U update, M merge) {
+        return Aggregate<Key, A, U, M, Cs...>(pool, update, merge);
+    }
+
+    /**
+     * Sink that collects the pairs of the values `Key` and `V` of all rows
+     * per worker, e.g. for `buildCsrIndex()`.
+     */
+    template<typename Key, typename V>
+    class Collect {
+    public:
+        typedef pair<typename Key::type, typename V::type> Entry;
+
+        explicit Collect(MorselPool &pool) : entries(pool) {
+
+        }
+
+        template<typename Row>
+        void push(const Row &row) {
+            this->entries[row.worker()].push_back(Entry(row.template get<Key>(), row.template get<V>()));
+        }
+
+        void finish() {
+        }
+
+        PerWorker<vector<Entry>> &getEntries() {
+            return this->entries;
+        }
+
+    private:
+        PerWorker<vector<Entry>> entries;
+    };
+}
+
+#endif //HDFS_BENCHMARK_PIPELINE_H
@@ -0,0 +1,117 @@
+#ifndef HDFS_BENCHMARK_PRUNING_H
+#define HDFS_BENCHMARK_PRUNING_H
+
+#include <atomic>
+#include <cstdio>
+
+#include <parquet/parquet.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include "Date.h"
+
+/**
+ * Min/max statistics of column chunks and pages, used to skip row groups
+ * and pages that cannot contain values of a range, and counters of what
+ * was skipped.
+ */
+namespace pruning {
+    /**
+     * Decodes the min and max value of `statistics`, returns false if they
+     * are not set.
+     */
+    template<typename T>
+    inline bool decode(const parquet::Statistics &statistics, T *min, T *max) {
+        if (!statistics.__isset.min || !statistics.__isset.max ||
+            statistics.min.size() != sizeof(T) || statistics.max.size() != sizeof(T)) {
+            return false;
+        }
+        memcpy(min, statistics.min.data(), sizeof(T));
+        memcpy(max, statistics.max.data(), sizeof(T));
+        return true;
+    }
+
+    template<>
+    inline bool decode(const parquet::Statistics &statistics, benchmark::Date *min, benchmark::Date *max) {
+        if (!statistics.__isset.min || !statistics.__isset.max) {
+            return false;
+        }
+        ByteArray minArray, maxArray;
+        minArray.len = statistics.min.size();
+        minArray.ptr = reinterpret_cast<const uint8_t *>(statistics.min.data());
+        maxArray.len = statistics.max.size();
+        maxArray.ptr = reinterpret_cast<const uint8_t *>(statistics.max.data());
+        try {
+            *min = benchmark::parseDate(minArray);
+            *max = benchmark::parseDate(maxArray);
+        } catch (std::runtime_error &) {
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * False if the statistics show that no value lies in [lower, upper].
+     */
+    template<typename T>
+    inline bool mayContain(const parquet::Statistics &statistics, const T &lower, const T &upper) {
+        T min, max;
+        if (!decode(statistics, &min, &max)) {
+            return true;
+        }
+        return !(max < lower || upper < min);
+    }
+
+    struct Counters {
+        std::atomic<uint64_t> rowGroups{0};
+        std::atomic<uint64_t> rowGroupsSkipped{0};
+        std::atomic<uint64_t> rowGroupBytesSkipped{0};
+        std::atomic<uint64_t> pagesSkipped{0};
+        std::atomic<uint64_t> pageBytesSkipped{0};
+        std::atomic<uint64_t> valuesDecoded{0};
+        std::atomic<uint64_t> valuesSkipped{0};
+    };
+
+    inline Counters &counters() {
+        static Counters counters;
+        return counters;
+    }
+
+    inline void rowGroup(bool skipped, uint64_t bytes) {
+        counters().rowGroups++;
+        if (skipped) {
+            counters().rowGroupsSkipped++;
+            counters().rowGroupBytesSkipped += bytes;
+        }
+    }
+
+    inline void pageSkipped(uint64_t bytes) {
+        counters().pagesSkipped++;
+        counters().pageBytesSkipped += bytes;
+    }
+
+    /**
+     * Values decoded and skipped by a scan, over all of its columns.
+     */
+    inline void values(uint64_t decoded, uint64_t skipped) {
+        counters().valuesDecoded += decoded;
+        counters().valuesSkipped += skipped;
+    }
+
+    inline void print(FILE *out = stderr) {
+        Counters &c = counters();
+        if (c.rowGroups > 0) {
+            fprintf(out, "pruning: skipped %lu of %lu row groups (%.1f MB), %lu pages (%.1f MB)\n",
+                    (unsigned long) c.rowGroupsSkipped, (unsigned long) c.rowGroups,
+                    c.rowGroupBytesSkipped / (1024.0 * 1024.0), (unsigned long) c.pagesSkipped,
+                    c.pageBytesSkipped / (1024.0 * 1024.0));
+        }
+        if (c.valuesDecoded + c.valuesSkipped > 0) {
+            fprintf(out, "scan: decoded %lu values, skipped %lu values\n", (unsigned long) c.valuesDecoded,
+                    (unsigned long) c.valuesSkipped);
+        }
+    }
+}
+
+#endif //HDFS_BENCHMARK_PRUNING_H
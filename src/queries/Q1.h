@@ -0,0 +1,92 @@
+#ifndef HDFS_BENCHMARK_Q1_H
+#define HDFS_BENCHMARK_Q1_H
+
+#include <vector>
+
+#include <stdint.h>
+
+#include <parquet/parquet.h>
+
+using namespace std;
+
+/**
+ * The grouping and aggregation of q1's lineitems, shared by q1,
+ * q1_operators, q1_pipeline and the microbenchmarks.
+ */
+namespace q1 {
+    struct Group {
+        double sum1 = 0, sum2 = 0, sum3 = 0, sum4 = 0, sum5 = 0, count = 0;
+    };
+
+    /**
+     * The groups (l_returnflag, l_linestatus) in the order of q1's ORDER BY.
+     */
+    const unsigned GROUP_COUNT = 4;
+    const unsigned GROUP_IDS[GROUP_COUNT] = {('A' << 8) | 'F', ('N' << 8) | 'F', ('N' << 8) | 'O', ('R' << 8) | 'F'};
+
+    /**
+     * The group of flags that TPC-H does not combine, such as A and O.
+     */
+    const unsigned NO_GROUP = GROUP_COUNT;
+
+    inline unsigned groupOf(const ByteArray &returnflag, const ByteArray &linestatus) {
+        unsigned f = ((returnflag.ptr[0] << 8) | linestatus.ptr[0]);
+        for (unsigned g = 0; g < GROUP_COUNT; g++) {
+            if (f == GROUP_IDS[g]) {
+                return g;
+            }
+        }
+        return NO_GROUP;
+    }
+
+    /**
+     * The group of every combination of the dictionary entries of
+     * l_returnflag and l_linestatus, the group of the codes `r` and `l` is
+     * `groupIds[r * linestatusSize + l]`.
+     */
+    inline void groupIdsByCode(const ByteArray *returnflags, size_t returnflagSize, const ByteArray *linestatuses,
+                               size_t linestatusSize, vector<uint8_t> &groupIds) {
+        groupIds.resize(returnflagSize * linestatusSize);
+        for (size_t r = 0; r < returnflagSize; r++) {
+            for (size_t l = 0; l < linestatusSize; l++) {
+                groupIds[r * linestatusSize + l] = groupOf(returnflags[r], linestatuses[l]);
+            }
+        }
+    }
+
+    /**
+     * Adds the rows at the `count` positions in `selection` to their group
+     * `groups[groupId(i)]`, rows of `NO_GROUP` are skipped.
+     */
+    template<typename GroupIdF>
+    inline void aggregate(Group *groups, const uint32_t *selection, size_t count, const double *quantity,
+                          const double *extendedprice, const double *discount, const double *tax, GroupIdF groupId) {
+        for (size_t k = 0; k < count; k++) {
+            size_t i = selection[k];
+            unsigned g = groupId(i);
+            if (g == NO_GROUP) {
+                continue;
+            }
+            Group &s = groups[g];
+            double v1 = extendedprice[i] * (1.0 - discount[i]);
+            double v2 = v1 * (1.0 + tax[i]);
+            s.sum1 += quantity[i];
+            s.sum2 += extendedprice[i];
+            s.sum3 += v1;
+            s.sum4 += v2;
+            s.sum5 += discount[i];
+            s.count++;
+        }
+    }
+
+    inline void merge(Group &s, const Group &other) {
+        s.sum1 += other.sum1;
+        s.sum2 += other.sum2;
+        s.sum3 += other.sum3;
+        s.sum4 += other.sum4;
+        s.sum5 += other.sum5;
+        s.count += other.count;
+    }
+}
+
+#endif //HDFS_BENCHMARK_Q1_H
@@ -0,0 +1,84 @@
+#ifndef HDFS_BENCHMARK_Q14_H
+#define HDFS_BENCHMARK_Q14_H
+
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include <stdint.h>
+
+#include <parquet/parquet.h>
+
+#include "HashJoin.h"
+
+using namespace std;
+
+/**
+ * The build and probe of q14's join of lineitem and part, shared by q14,
+ * q14_operators, q14_pipeline and the microbenchmarks.
+ */
+namespace q14 {
+    struct Revenue {
+        double promo = 0, total = 0;
+    };
+
+    inline void merge(Revenue &r, const Revenue &other) {
+        r.promo += other.promo;
+        r.total += other.total;
+    }
+
+    inline bool isPromo(const ByteArray &type) {
+        return type.len >= 5 && memcmp(type.ptr, "PROMO", 5) == 0;
+    }
+
+    /**
+     * Appends (l_partkey, l_extendedprice * (1 - l_discount)) of the rows
+     * at the `count` positions in `selection` to `matches`.
+     */
+    inline void collect(vector<pair<int32_t, double>> &matches, const uint32_t *selection, size_t count,
+                        const int32_t *partkey, const double *extendedprice, const double *discount) {
+        for (size_t k = 0; k < count; k++) {
+            size_t i = selection[k];
+            matches.push_back(make_pair(partkey[i], extendedprice[i] * (1 - discount[i])));
+        }
+    }
+
+    /**
+     * Adds the revenue of the lineitems of the parts at the `count`
+     * positions in `selection` to `r`.
+     */
+    inline void probe(const benchmark::CsrIndex<double> &index, Revenue &r, const uint32_t *selection, size_t count,
+                      const int32_t *partkey, const ByteArray *type) {
+        index.findBatch(partkey, selection, count, [&](uint32_t i, const double *begin, const double *end) {
+            double a = 0;
+            for (const double *revenue = begin; revenue != end; revenue++) {
+                a += *revenue;
+            }
+            if (isPromo(type[i])) {
+                r.promo += a;
+            }
+            r.total += a;
+        });
+    }
+
+    inline void probe(const benchmark::JoinIndex<double> &index, Revenue &r, const uint32_t *selection, size_t count,
+                      const int32_t *partkey, const ByteArray *type) {
+        for (size_t k = 0; k < count; k++) {
+            size_t i = selection[k];
+            uint32_t tuple = index.find(partkey[i]);
+            if (tuple == benchmark::NO_ENTRY) {
+                continue;
+            }
+            bool promoted = isPromo(type[i]);
+            for (; tuple != benchmark::NO_ENTRY; tuple = index.next(tuple)) {
+                double a = index.value(tuple);
+                if (promoted) {
+                    r.promo += a;
+                }
+                r.total += a;
+            }
+        }
+    }
+}
+
+#endif //HDFS_BENCHMARK_Q14_H
@@ -0,0 +1,89 @@
+#ifndef HDFS_BENCHMARK_Q17_H
+#define HDFS_BENCHMARK_Q17_H
+
+#include <algorithm>
+#include <vector>
+
+#include <stdint.h>
+
+#include "Morsel.h"
+
+using namespace std;
+
+/**
+ * The aggregation of q17 over its lineitem matches sorted by part key,
+ * shared by q17, q17_operators and the microbenchmarks.
+ */
+namespace q17 {
+    struct LineitemMatch {
+        int32_t partkey;
+        double quantity;
+        double extendedprice;
+    };
+
+    /**
+     * sum(extendedprice) of the matches in [begin, end) whose quantity is
+     * below 0.2 * avg(quantity) of their part. The range must not split
+     * the matches of a part.
+     */
+    inline double aggregate(const vector<LineitemMatch> &matched, size_t begin, size_t end) {
+        double sum = 0;
+        for (size_t index = begin; index != end;) {
+            int32_t partkey = matched[index].partkey;
+            size_t last = index;
+            double avgQuantity = 0;
+            while (true) {
+                if ((last == end) || (matched[last].partkey != partkey)) break;
+                avgQuantity += matched[last].quantity;
+                ++last;
+            }
+            avgQuantity = 0.2 * avgQuantity / (last - index);
+            for (; index != last; ++index) {
+                if (matched[index].quantity < avgQuantity)
+                    sum += matched[index].extendedprice;
+            }
+        }
+        return sum;
+    }
+
+    /**
+     * Splits `matched` into `ranges` ranges of about equal size that start
+     * and end at part key boundaries, range `r` is [bounds[r], bounds[r + 1]).
+     */
+    inline vector<size_t> splitAtPartkeys(const vector<LineitemMatch> &matched, unsigned ranges) {
+        size_t limit = matched.size();
+        vector<size_t> bounds(ranges + 1, limit);
+        bounds[0] = 0;
+        for (unsigned r = 1; r < ranges; r++) {
+            size_t bound = max(bounds[r - 1], limit * r / ranges);
+            while (bound > 0 && bound < limit && matched[bound].partkey == matched[bound - 1].partkey) {
+                bound++;
+            }
+            bounds[r] = bound;
+        }
+        return bounds;
+    }
+
+    /**
+     * `aggregate()` over all of `matched`, one range per worker of `pool`.
+     */
+    inline double parallelAggregate(benchmark::MorselPool &pool, const vector<LineitemMatch> &matched) {
+        benchmark::PerWorker<double> sums(pool);
+        unsigned workers = sums.size();
+        vector<size_t> bounds = splitAtPartkeys(matched, workers);
+        for (unsigned w = 0; w < workers; w++) {
+            pool.push([&, w](unsigned worker) {
+                sums[worker] += aggregate(matched, bounds[w], bounds[w + 1]);
+            });
+        }
+        pool.wait();
+
+        double sum = 0;
+        for (unsigned worker = 0; worker < workers; worker++) {
+            sum += sums[worker];
+        }
+        return sum;
+    }
+}
+
+#endif //HDFS_BENCHMARK_Q17_H
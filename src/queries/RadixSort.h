@@ -0,0 +1,125 @@
+#ifndef HDFS_BENCHMARK_RADIXSORT_H
+#define HDFS_BENCHMARK_RADIXSORT_H
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <stdint.h>
+
+#include "Morsel.h"
+
+using namespace std;
+
+namespace benchmark {
+    /**
+     * Sorts the elements that the workers of `pool` collected by the 32 bit
+     * key `key(element)` with a parallel, stable LSD radix sort, 8 bits per
+     * pass, and returns them in one vector. Only as many passes run as the
+     * largest key has significant bytes. The first pass reads the workers'
+     * vectors in place, so they are not concatenated first; they are empty
+     * when the sort returns.
+     *
+     * In every pass each worker counts the digits of one chunk of the
+     * input, the counts are prefix-summed digit by digit and chunk by
+     * chunk, and each worker scatters its chunk to the resulting offsets.
+     */
+    template<typename T, typename KeyF>
+    vector<T> radixSort(MorselPool &pool, PerWorker<vector<T>> &input, KeyF key) {
+        static const unsigned RADIX_BITS = 8;
+        static const unsigned BUCKETS = 1 << RADIX_BITS;
+
+        unsigned workers = input.size();
+        size_t size = 0;
+        for (unsigned w = 0; w < workers; w++) {
+            size += input[w].size();
+        }
+
+        vector<uint32_t> maxKeys(workers, 0);
+        for (unsigned w = 0; w < workers; w++) {
+            pool.push([&, w](unsigned worker) {
+                uint32_t maxKey = 0;
+                for (auto &element : input[w]) {
+                    maxKey = max(maxKey, (uint32_t) key(element));
+                }
+                maxKeys[w] = maxKey;
+            });
+        }
+        pool.wait();
+        uint32_t maxKey = *max_element(maxKeys.begin(), maxKeys.end());
+        unsigned passes = 0;
+        while (passes * RADIX_BITS < 32 && (maxKey >> (passes * RADIX_BITS)) != 0) {
+            passes++;
+        }
+
+        vector<T> sorted(size), buffer(passes > 1 ? size : 0);
+        if (passes == 0) {
+            // All keys are 0
+            size_t position = 0;
+            for (unsigned w = 0; w < workers; w++) {
+                copy(input[w].begin(), input[w].end(), sorted.begin() + position);
+                position += input[w].size();
+                vector<T>().swap(input[w]);
+            }
+            return sorted;
+        }
+
+        // The chunks of the first pass are the workers' vectors, later
+        // passes split the output of the previous one into equal chunks
+        vector<pair<const T *, size_t>> chunks(workers);
+        for (unsigned w = 0; w < workers; w++) {
+            chunks[w] = make_pair(input[w].data(), input[w].size());
+        }
+        vector<vector<size_t>> offsets(workers, vector<size_t>(BUCKETS));
+
+        for (unsigned pass = 0; pass < passes; pass++) {
+            unsigned shift = pass * RADIX_BITS;
+            // The last pass writes to `sorted`
+            T *out = (passes - pass) % 2 == 1 ? sorted.data() : buffer.data();
+
+            for (unsigned w = 0; w < workers; w++) {
+                pool.push([&, w, shift](unsigned worker) {
+                    vector<size_t> &counts = offsets[w];
+                    fill(counts.begin(), counts.end(), 0);
+                    const T *chunk = chunks[w].first;
+                    for (size_t i = 0; i < chunks[w].second; i++) {
+                        counts[(key(chunk[i]) >> shift) & (BUCKETS - 1)]++;
+                    }
+                });
+            }
+            pool.wait();
+
+            size_t position = 0;
+            for (unsigned digit = 0; digit < BUCKETS; digit++) {
+                for (unsigned w = 0; w < workers; w++) {
+                    size_t count = offsets[w][digit];
+                    offsets[w][digit] = position;
+                    position += count;
+                }
+            }
+
+            for (unsigned w = 0; w < workers; w++) {
+                pool.push([&, w, shift, out](unsigned worker) {
+                    vector<size_t> &position = offsets[w];
+                    const T *chunk = chunks[w].first;
+                    for (size_t i = 0; i < chunks[w].second; i++) {
+                        out[position[(key(chunk[i]) >> shift) & (BUCKETS - 1)]++] = chunk[i];
+                    }
+                });
+            }
+            pool.wait();
+
+            if (pass == 0) {
+                for (unsigned w = 0; w < workers; w++) {
+                    vector<T>().swap(input[w]);
+                }
+            }
+            for (unsigned w = 0; w < workers; w++) {
+                chunks[w] = make_pair(out + size * w / workers, size * (w + 1) / workers - size * w / workers);
+            }
+        }
+        return sorted;
+    }
+};
+
+#endif //HDFS_BENCHMARK_RADIXSORT_H
@@ -0,0 +1,157 @@
+#ifndef HDFS_BENCHMARK_RLE_H
+#define HDFS_BENCHMARK_RLE_H
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <stdint.h>
+
+namespace benchmark {
+    /**
+     * Decoder of Parquet's RLE/bit-packing hybrid encoding, used for
+     * definition levels and dictionary indices. Each run starts with a
+     * ULEB128 header: its lowest bit selects a bit-packed run of
+     * (header >> 1) groups of 8 values or an RLE run repeating one value
+     * (header >> 1) times.
+     */
+    class RleDecoder {
+    public:
+        RleDecoder() {
+
+        }
+
+        RleDecoder(const uint8_t *data, size_t length, unsigned bitWidth) {
+            reset(data, length, bitWidth);
+        }
+
+        void reset(const uint8_t *data, size_t length, unsigned bitWidth) {
+            if (bitWidth > 32) {
+                throw std::runtime_error("Invalid RLE bit width");
+            }
+            this->data = data;
+            this->end = data + length;
+            this->bitWidth = bitWidth;
+            this->mask = bitWidth == 32 ? 0xFFFFFFFFu : ((1u << bitWidth) - 1);
+            this->repeatCount = 0;
+            this->literalCount = 0;
+        }
+
+        /**
+         * Decodes up to `n` values into `out` and returns how many were
+         * decoded, which is less than `n` only at the end of the data.
+         */
+        size_t get(uint32_t *out, size_t n) {
+            size_t decoded = 0;
+            while (decoded < n) {
+                if (repeatCount == 0 && literalCount == 0 && !nextRun()) {
+                    break;
+                }
+                if (repeatCount > 0) {
+                    size_t k = std::min((size_t) repeatCount, n - decoded);
+                    std::fill(out + decoded, out + decoded + k, currentValue);
+                    repeatCount -= k;
+                    decoded += k;
+                } else {
+                    size_t k = std::min((size_t) literalCount, n - decoded);
+                    for (size_t i = 0; i < k; i++) {
+                        out[decoded + i] = unpack(literalPosition + i);
+                    }
+                    literalPosition += k;
+                    literalCount -= k;
+                    decoded += k;
+                }
+            }
+            return decoded;
+        }
+
+        /**
+         * Skips up to `n` values without decoding them and returns how many
+         * were skipped.
+         */
+        size_t skip(size_t n) {
+            size_t skipped = 0;
+            while (skipped < n) {
+                if (repeatCount == 0 && literalCount == 0 && !nextRun()) {
+                    break;
+                }
+                if (repeatCount > 0) {
+                    size_t k = std::min((size_t) repeatCount, n - skipped);
+                    repeatCount -= k;
+                    skipped += k;
+                } else {
+                    size_t k = std::min((size_t) literalCount, n - skipped);
+                    literalPosition += k;
+                    literalCount -= k;
+                    skipped += k;
+                }
+            }
+            return skipped;
+        }
+
+    private:
+        bool nextRun() {
+            if (data >= end) {
+                return false;
+            }
+
+            uint32_t header = 0;
+            unsigned shift = 0;
+            while (true) {
+                if (data >= end || shift > 28) {
+                    throw std::runtime_error("Corrupt RLE run header");
+                }
+                uint8_t byte = *data++;
+                header |= ((uint32_t) (byte & 0x7F)) << shift;
+                if ((byte & 0x80) == 0) {
+                    break;
+                }
+                shift += 7;
+            }
+
+            if (header & 1) {
+                size_t groups = header >> 1;
+                literalData = data;
+                literalPosition = 0;
+                literalCount = groups * 8;
+                data += std::min((size_t) (end - data), groups * bitWidth);
+            } else {
+                repeatCount = header >> 1;
+                unsigned bytes = (bitWidth + 7) / 8;
+                if ((size_t) (end - data) < bytes) {
+                    throw std::runtime_error("Corrupt RLE run");
+                }
+                currentValue = 0;
+                memcpy(&currentValue, data, bytes);
+                data += bytes;
+            }
+            return true;
+        }
+
+        uint32_t unpack(size_t idx) {
+            uint64_t bit = idx * bitWidth;
+            const uint8_t *p = literalData + (bit >> 3);
+            uint64_t word = 0;
+            if (p + 8 <= end) {
+                memcpy(&word, p, 8);
+            } else if (p < end) {
+                memcpy(&word, p, end - p);
+            }
+            return (uint32_t) (word >> (bit & 7)) & mask;
+        }
+
+        const uint8_t *data = 0;
+        const uint8_t *end = 0;
+        unsigned bitWidth = 0;
+        uint32_t mask = 0;
+
+        size_t repeatCount = 0;
+        uint32_t currentValue = 0;
+
+        const uint8_t *literalData = 0;
+        size_t literalPosition = 0;
+        size_t literalCount = 0;
+    };
+}
+
+#endif //HDFS_BENCHMARK_RLE_H
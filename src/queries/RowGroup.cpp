@@ -8,12 +8,23 @@
 
 namespace benchmark {
     vector<benchmark::ColumnChunk>& RowGroup::allColumns() {
-        static vector<ColumnChunk> cols;
-        if (cols.size() == 0) {
-            for (unsigned i = 0; i < parquetFile->getFileMetaData()->schema.size()-1; i++) {
-                cols.push_back(move(getColumn(i)));
-            }
+        vector<ColumnChunk> *cols = this->columns.load(memory_order_acquire);
+        if (cols != 0) {
+            return *cols;
         }
-        return cols;
+
+        // Threads racing here build their own vector, only one is kept
+        cols = new vector<ColumnChunk>();
+        cols->reserve(this->getNumberOfColumns());
+        for (unsigned i = 0; i < this->getNumberOfColumns(); i++) {
+            cols->push_back(getColumn(i));
+        }
+
+        vector<ColumnChunk> *expected = 0;
+        if (!this->columns.compare_exchange_strong(expected, cols, memory_order_acq_rel)) {
+            delete cols;
+            return *expected;
+        }
+        return *cols;
     }
 }
@@ -5,36 +5,87 @@
 #ifndef HDFS_BENCHMARK_ROWGROUP_H
 #define HDFS_BENCHMARK_ROWGROUP_H
 
+#include <atomic>
 #include <vector>
 
 #include <parquet/parquet.h>
 
 #include "ColumnChunk.h"
+#include "Pruning.h"
 
 class ParquetFile;
 
 using namespace std;
 
 namespace benchmark {
+    /**
+     * A view of a row group of the `FileMetaData` of a `ParquetFile`, which
+     * it borrows rather than copies. Column chunks are created on demand.
+     * Safe to use from several threads at once.
+     */
     class RowGroup {
     public:
-        RowGroup(ParquetFile *parquetFile, parquet::RowGroup &rowGroup) : rowGroup(rowGroup), parquetFile(parquetFile) {
+        RowGroup(ParquetFile *parquetFile, parquet::RowGroup &rowGroup) : rowGroup(&rowGroup), parquetFile(parquetFile) {
 
         }
 
+        RowGroup(RowGroup &&r) noexcept : rowGroup(r.rowGroup), parquetFile(r.parquetFile), columns(r.columns.exchange(0)) {
+
+        }
+
+        RowGroup(const RowGroup &) = delete;
+
+        RowGroup &operator=(const RowGroup &) = delete;
+
+        ~RowGroup() {
+            delete this->columns.load();
+        }
+
         ColumnChunk getColumn(unsigned int col) {
-            return ColumnChunk(parquetFile, this, this->rowGroup.columns[col], col);
+            return ColumnChunk(parquetFile, this, this->rowGroup->columns[col], col);
         }
 
         unsigned getNumberOfColumns() {
-            return this->rowGroup.columns.size();
+            return this->rowGroup->columns.size();
+        }
+
+        int64_t getNumRows() {
+            return this->rowGroup->num_rows;
+        }
+
+        /**
+         * Size of all column chunks on disk.
+         */
+        int64_t getCompressedSize() {
+            int64_t size = 0;
+            for (auto &column : this->rowGroup->columns) {
+                size += column.meta_data.total_compressed_size;
+            }
+            return size;
+        }
+
+        /**
+         * False if the statistics of column `col` show that none of its
+         * values lies in [lower, upper], i.e. the row group can be skipped.
+         */
+        template<typename T>
+        bool mayContain(unsigned col, const T &lower, const T &upper) {
+            auto &metaData = this->rowGroup->columns[col].meta_data;
+            if (!metaData.__isset.statistics) {
+                return true;
+            }
+            return pruning::mayContain(metaData.statistics, lower, upper);
         }
 
+        /**
+         * The column chunks of all columns, created on the first call.
+         */
         vector<ColumnChunk>& allColumns();
 
     private:
-        parquet::RowGroup rowGroup;
+        parquet::RowGroup *rowGroup;
         ParquetFile *parquetFile;
+        atomic<vector<ColumnChunk> *> columns{0};
     };
 };
 
@@ -0,0 +1,425 @@
+#ifndef HDFS_BENCHMARK_SCAN_H
+#define HDFS_BENCHMARK_SCAN_H
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <stdint.h>
+
+#include "Arena.h"
+#include "ColumnChunk.h"
+#include "Decompression.h"
+#include "Pruning.h"
+#include "RowGroup.h"
+
+using namespace std;
+
+namespace benchmark {
+    /**
+     * Scans a row group in batches. Predicates on columns are evaluated
+     * batch by batch into a selection vector, and the query's compute
+     * function is only called with the positions of qualifying rows.
+     * Columns after the first predicate's are only decoded at the positions
+     * that qualified so far, the others are skipped:
+     *
+     *     Scan scan(rowGroup);
+     *     scan.between(10, Date(19950901), Date(19950930));
+     *     const double *price = scan.column<double>(5);
+     *     scan.run([&](const uint32_t *selection, size_t count) {
+     *         for (size_t k = 0; k < count; k++) sum += price[selection[k]];
+     *     });
+     *
+     * The values of the current batch are indexed by their position in the
+     * batch, values of rows that were filtered out are undefined. The pointers returned by `column()` and `codes()` stay valid
+     * for the lifetime of the scan.
+     *
+     * With `DECOMPRESSION_THREADS` set, `run()` has the pages of its columns
+     * decompressed ahead of it into the arena of the calling thread, which
+     * it resets when it returns. Then `ByteArray`s of a batch are only valid
+     * until `run()` returns, and a thread can only run one scan at a time.
+     */
+    class Scan {
+    public:
+        explicit Scan(RowGroup &rowGroup, size_t batchSize = BATCH_SIZE) :
+                rowGroup(rowGroup), batchSize(batchSize), selection(batchSize) {
+
+        }
+
+        Scan(const Scan &) = delete;
+
+        Scan &operator=(const Scan &) = delete;
+
+        /**
+         * Selects rows with lower <= value <= upper. The range also prunes
+         * the row group and, if it is the first predicate, pages by their
+         * min/max statistics.
+         */
+        template<typename T>
+        Scan &between(unsigned col, const T &lower, const T &upper) {
+            ValueColumn<T> *column = this->valueColumn<T>(col);
+            RowGroup *rowGroup = &this->rowGroup;
+
+            Filter filter;
+            filter.column = column;
+            filter.apply = [column, lower, upper](uint32_t *selection, size_t count) {
+                const T *values = column->values.data();
+                size_t selected = 0;
+                for (size_t k = 0; k < count; k++) {
+                    uint32_t i = selection[k];
+                    selection[selected] = i;
+                    selected += !(values[i] < lower) & !(upper < values[i]);
+                }
+                return selected;
+            };
+            filter.mayContain = [rowGroup, col, lower, upper]() {
+                return rowGroup->mayContain(col, lower, upper);
+            };
+            filter.skipPages = [column, lower, upper]() {
+                return column->reader.skipPages(lower, upper);
+            };
+            this->filters.push_back(filter);
+            return *this;
+        }
+
+        /**
+         * Selects rows for which `predicate(value)` is true. On dictionary
+         * encoded byte array columns the predicate is evaluated once per
+         * dictionary entry.
+         */
+        template<typename T, typename P>
+        Scan &where(unsigned col, P predicate) {
+            this->addWhere(col, predicate, (T *) 0);
+            return *this;
+        }
+
+        /**
+         * The values of column `col` in the current batch.
+         */
+        template<typename T>
+        const T *column(unsigned col) {
+            return this->valueColumn<T>(col)->values.data();
+        }
+
+        /**
+         * The dictionary codes of column `col` in the current batch, see
+         * `getDictionary()`.
+         */
+        const uint32_t *codes(unsigned col) {
+            return this->codeColumn(col)->codes.data();
+        }
+
+        bool isDictionaryEncoded(unsigned col) {
+            auto it = this->dictionaryEncoded.find(col);
+            if (it == this->dictionaryEncoded.end()) {
+                it = this->dictionaryEncoded.insert(
+                        make_pair(col, this->rowGroup.getColumn(col).getReader().isDictionaryEncoded())).first;
+            }
+            return it->second;
+        }
+
+        template<typename T>
+        const T *getDictionary(unsigned col, size_t *size) {
+            return this->codeColumn(col)->reader.template getDictionary<T>(size);
+        }
+
+        /**
+         * Calls `f(selection, count)` for every batch with qualifying rows.
+         */
+        template<typename F>
+        void run(F f) {
+            bool ranges = false;
+            for (auto &filter : this->filters) {
+                if (!filter.mayContain) {
+                    continue;
+                }
+                ranges = true;
+                if (!filter.mayContain()) {
+                    pruning::rowGroup(true, this->rowGroup.getCompressedSize());
+                    return;
+                }
+            }
+            if (ranges) {
+                pruning::rowGroup(false, this->rowGroup.getCompressedSize());
+            }
+            if (this->columns.empty()) {
+                return;
+            }
+
+            Prefetch prefetch;
+            if (DecompressionPool *pool = DecompressionPool::get()) {
+                prefetch.arena = &Arena::local();
+                for (auto &column : this->columns) {
+                    if (auto pages = column->reader.decompressAhead(*prefetch.arena)) {
+                        prefetch.chunks.push_back(pages);
+                    }
+                }
+                pool->submit(prefetch.chunks);
+            }
+
+            ScanColumn *driver = this->filters.empty() ? this->columns.front().get() : this->filters.front().column;
+            function<size_t()> skipPages = this->filters.empty() ? nullptr : this->filters.front().skipPages;
+
+            uint64_t decoded = 0, skipped = 0;
+            for (size_t batch = 1;; batch++) {
+                for (auto &column : this->columns) {
+                    column->reader.releasePages();
+                }
+
+                size_t limit = this->batchSize;
+                if (skipPages) {
+                    if (driver->reader.pageValuesLeft() == 0) {
+                        if (size_t pageValues = skipPages()) {
+                            for (auto &column : this->columns) {
+                                if (column.get() != driver) {
+                                    column->reader.skip(pageValues);
+                                }
+                            }
+                            skipped += pageValues * this->columns.size();
+                        }
+                    }
+                    // Batches end at page boundaries, so that every page can be pruned
+                    limit = min(limit, driver->reader.pageValuesLeft());
+                }
+
+                size_t n = driver->read(0, limit);
+                if (n == 0) {
+                    break;
+                }
+                driver->batch = batch;
+                decoded += n;
+
+                size_t count = n;
+                for (size_t i = 0; i < n; i++) {
+                    this->selection[i] = i;
+                }
+
+                // Columns are decoded when first needed, and then only at
+                // the positions that are still selected
+                for (auto &filter : this->filters) {
+                    decoded += filter.column->load(batch, this->selection.data(), count, n, &skipped);
+                    count = filter.apply(this->selection.data(), count);
+                }
+                for (auto &column : this->columns) {
+                    decoded += column->load(batch, this->selection.data(), count, n, &skipped);
+                }
+
+                if (count > 0) {
+                    f(const_cast<const uint32_t *>(this->selection.data()), count);
+                }
+            }
+
+            pruning::values(decoded, skipped);
+        }
+
+    private:
+        class ScanColumn {
+        public:
+            ScanColumn(ColumnChunk::Reader &&reader) : reader(move(reader)) {
+                // A batch may be read with several calls
+                this->reader.holdPages(true);
+            }
+
+            virtual ~ScanColumn() {
+
+            }
+
+            /**
+             * Decodes up to `n` values into the batch, starting at `offset`.
+             */
+            virtual size_t read(size_t offset, size_t n) = 0;
+
+            /**
+             * Unless already done for `batch`, decodes the values at the
+             * `count` selected positions of the next `n` values and skips
+             * the others. Returns the number of values decoded.
+             */
+            size_t load(size_t batch, const uint32_t *selection, size_t count, size_t n, uint64_t *skipped) {
+                if (this->batch == batch) {
+                    return 0;
+                }
+                this->batch = batch;
+
+                // Dense selections are cheaper to decode completely
+                if (count * 2 > n) {
+                    if (this->read(0, n) != n) {
+                        throw runtime_error("Column chunks of a row group differ in length");
+                    }
+                    return n;
+                }
+
+                size_t position = 0;
+                for (size_t k = 0; k < count;) {
+                    size_t start = selection[k], end = start + 1;
+                    while (++k < count && selection[k] == end) {
+                        end++;
+                    }
+                    if (start > position) {
+                        this->reader.skip(start - position);
+                    }
+                    if (this->read(start, end - start) != end - start) {
+                        throw runtime_error("Column chunks of a row group differ in length");
+                    }
+                    position = end;
+                }
+                if (n > position) {
+                    this->reader.skip(n - position);
+                }
+                *skipped += n - count;
+                return count;
+            }
+
+            ColumnChunk::Reader reader;
+            size_t batch = 0;
+        };
+
+        template<typename T>
+        class ValueColumn : public ScanColumn {
+        public:
+            ValueColumn(ColumnChunk::Reader &&reader, size_t batchSize) : ScanColumn(move(reader)), values(batchSize) {
+
+            }
+
+            size_t read(size_t offset, size_t n) override {
+                return this->reader.readBatch(this->values.data() + offset, n);
+            }
+
+            vector<T> values;
+        };
+
+        class CodeColumn : public ScanColumn {
+        public:
+            CodeColumn(ColumnChunk::Reader &&reader, size_t batchSize) : ScanColumn(move(reader)), codes(batchSize) {
+
+            }
+
+            size_t read(size_t offset, size_t n) override {
+                return this->reader.readCodes(this->codes.data() + offset, n);
+            }
+
+            vector<uint32_t> codes;
+        };
+
+        struct Filter {
+            ScanColumn *column;
+            // Keeps the selected positions, returns their number
+            function<size_t(uint32_t *selection, size_t count)> apply;
+            // Only set for ranges
+            function<bool()> mayContain;
+            function<size_t()> skipPages;
+        };
+
+        /**
+         * Pages decompressed ahead of a `run()`. The arena is reset once
+         * no worker writes to it anymore.
+         */
+        struct Prefetch {
+            vector<shared_ptr<DecompressedPages>> chunks;
+            Arena *arena = 0;
+
+            ~Prefetch() {
+                for (auto &chunk : this->chunks) {
+                    chunk->cancel();
+                }
+                if (this->arena) {
+                    this->arena->reset();
+                }
+            }
+        };
+
+        template<typename T>
+        ValueColumn<T> *valueColumn(unsigned col) {
+            auto it = this->values.find(col);
+            if (it != this->values.end()) {
+                auto column = dynamic_cast<ValueColumn<T> *>(it->second);
+                if (column == 0) {
+                    throw runtime_error("Column " + to_string(col) + " is scanned with different types");
+                }
+                return column;
+            }
+            auto column = new ValueColumn<T>(this->rowGroup.getColumn(col).getReader(), this->batchSize);
+            this->columns.push_back(unique_ptr<ScanColumn>(column));
+            this->values[col] = column;
+            return column;
+        }
+
+        CodeColumn *codeColumn(unsigned col) {
+            auto it = this->codeColumns.find(col);
+            if (it != this->codeColumns.end()) {
+                return it->second;
+            }
+            auto column = new CodeColumn(this->rowGroup.getColumn(col).getReader(), this->batchSize);
+            this->columns.push_back(unique_ptr<ScanColumn>(column));
+            this->codeColumns[col] = column;
+            return column;
+        }
+
+        template<typename T, typename P>
+        void addWhere(unsigned col, P predicate, T *) {
+            this->addValueWhere<T>(col, predicate);
+        }
+
+        template<typename T, typename P>
+        void addValueWhere(unsigned col, P predicate) {
+            ValueColumn<T> *column = this->valueColumn<T>(col);
+
+            Filter filter;
+            filter.column = column;
+            filter.apply = [column, predicate](uint32_t *selection, size_t count) {
+                const T *values = column->values.data();
+                size_t selected = 0;
+                for (size_t k = 0; k < count; k++) {
+                    uint32_t i = selection[k];
+                    selection[selected] = i;
+                    selected += predicate(values[i]) ? 1 : 0;
+                }
+                return selected;
+            };
+            this->filters.push_back(filter);
+        }
+
+        template<typename P>
+        void addWhere(unsigned col, P predicate, ByteArray *) {
+            if (!this->isDictionaryEncoded(col)) {
+                this->addValueWhere<ByteArray>(col, predicate);
+                return;
+            }
+
+            CodeColumn *column = this->codeColumn(col);
+            size_t size;
+            const ByteArray *dictionary = column->reader.getDictionary<ByteArray>(&size);
+            auto matches = make_shared<vector<uint8_t>>(size);
+            for (size_t i = 0; i < size; i++) {
+                (*matches)[i] = predicate(dictionary[i]) ? 1 : 0;
+            }
+
+            Filter filter;
+            filter.column = column;
+            filter.apply = [column, matches](uint32_t *selection, size_t count) {
+                const uint32_t *codes = column->codes.data();
+                const uint8_t *match = matches->data();
+                size_t selected = 0;
+                for (size_t k = 0; k < count; k++) {
+                    uint32_t i = selection[k];
+                    selection[selected] = i;
+                    selected += match[codes[i]];
+                }
+                return selected;
+            };
+            this->filters.push_back(filter);
+        }
+
+        RowGroup &rowGroup;
+        size_t batchSize;
+        vector<uint32_t> selection;
+        vector<unique_ptr<ScanColumn>> columns;
+        map<unsigned, ScanColumn *> values;
+        map<unsigned, CodeColumn *> codeColumns;
+        map<unsigned, bool> dictionaryEncoded;
+        vector<Filter> filters;
+    };
+};
+
+#endif //HDFS_BENCHMARK_SCAN_H
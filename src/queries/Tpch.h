@@ -0,0 +1,52 @@
+#ifndef HDFS_BENCHMARK_TPCH_H
+#define HDFS_BENCHMARK_TPCH_H
+
+#include <parquet/parquet.h>
+
+#include "Date.h"
+#include "Pipeline.h"
+
+/**
+ * The TPC-H tables as the queries read them from Parquet, for `Pipeline.h`.
+ * Dates are stored as strings and decoded into `Date`s.
+ */
+namespace tpch {
+    using pipeline::Column;
+    using benchmark::Date;
+
+    struct l_orderkey : Column<0, int32_t> {};
+    struct l_partkey : Column<1, int32_t> {};
+    struct l_suppkey : Column<2, int32_t> {};
+    struct l_linenumber : Column<3, int32_t> {};
+    struct l_quantity : Column<4, double> {};
+    struct l_extendedprice : Column<5, double> {};
+    struct l_discount : Column<6, double> {};
+    struct l_tax : Column<7, double> {};
+    struct l_returnflag : Column<8, ByteArray> {};
+    struct l_linestatus : Column<9, ByteArray> {};
+    struct l_shipdate : Column<10, Date> {};
+    struct l_commitdate : Column<11, Date> {};
+    struct l_receiptdate : Column<12, Date> {};
+    struct l_shipinstruct : Column<13, ByteArray> {};
+    struct l_shipmode : Column<14, ByteArray> {};
+    struct l_comment : Column<15, ByteArray> {};
+
+    struct Lineitem : pipeline::Schema<l_orderkey, l_partkey, l_suppkey, l_linenumber, l_quantity, l_extendedprice,
+            l_discount, l_tax, l_returnflag, l_linestatus, l_shipdate, l_commitdate, l_receiptdate, l_shipinstruct,
+            l_shipmode, l_comment> {};
+
+    struct p_partkey : Column<0, int32_t> {};
+    struct p_name : Column<1, ByteArray> {};
+    struct p_mfgr : Column<2, ByteArray> {};
+    struct p_brand : Column<3, ByteArray> {};
+    struct p_type : Column<4, ByteArray> {};
+    struct p_size : Column<5, int32_t> {};
+    struct p_container : Column<6, ByteArray> {};
+    struct p_retailprice : Column<7, double> {};
+    struct p_comment : Column<8, ByteArray> {};
+
+    struct Part : pipeline::Schema<p_partkey, p_name, p_mfgr, p_brand, p_type, p_size, p_container, p_retailprice,
+            p_comment> {};
+}
+
+#endif //HDFS_BENCHMARK_TPCH_H
@@ -0,0 +1,196 @@
+#ifndef HDFS_BENCHMARK_TRACE_H
+#define HDFS_BENCHMARK_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Records begin/end and instant events into per-thread ring buffers and
+ * writes them as Chrome trace event JSON (chrome://tracing, Perfetto).
+ * Enabled by setting TRACE_FILE to the path of the trace to write. Only
+ * the owning thread writes to a buffer, so recording is a timestamp and a
+ * store; when a buffer is full the oldest events are overwritten.
+ */
+namespace trace {
+    struct Event {
+        const char *name;
+        uint64_t ts;
+        char phase;
+    };
+
+    class Buffer {
+    public:
+        static const size_t CAPACITY = 1 << 18;
+
+        Buffer(unsigned tid) : tid(tid), events(CAPACITY) {
+
+        }
+
+        void push(const char *name, char phase, uint64_t ts) {
+            uint64_t h = head.load(std::memory_order_relaxed);
+            Event &e = events[h & (CAPACITY - 1)];
+            e.name = name;
+            e.ts = ts;
+            e.phase = phase;
+            head.store(h + 1, std::memory_order_release);
+        }
+
+        unsigned tid;
+        std::string name;
+        std::vector<Event> events;
+        std::atomic<uint64_t> head{0};
+    };
+
+    inline const char *path() {
+        static const char *path = getenv("TRACE_FILE");
+        return path;
+    }
+
+    inline bool enabled() {
+        return path() != 0;
+    }
+
+    inline uint64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    inline std::string escape(const std::string &s) {
+        std::string result;
+        for (char c : s) {
+            if (c == '"' || c == '\\') {
+                result += '\\';
+            }
+            result += c;
+        }
+        return result;
+    }
+
+    class Registry {
+    public:
+        static Registry &get() {
+            static Registry registry;
+            return registry;
+        }
+
+        /**
+         * Creates the buffer of a new thread. Buffers outlive their threads so
+         * that they can be written at exit.
+         */
+        Buffer *create() {
+            std::lock_guard<std::mutex> lock(mutex);
+            buffers.push_back(std::unique_ptr<Buffer>(new Buffer(buffers.size() + 1)));
+            return buffers.back().get();
+        }
+
+        /**
+         * Writes all events to TRACE_FILE. Must be called after all traced
+         * threads finished.
+         */
+        void write() {
+            std::lock_guard<std::mutex> lock(mutex);
+            FILE *out = fopen(path(), "w");
+            if (out == NULL) {
+                fprintf(stderr, "Cannot write trace to %s\n", path());
+                return;
+            }
+
+            fprintf(out, "{\"traceEvents\":[\n");
+            bool first = true;
+            for (auto &buffer : buffers) {
+                if (!buffer->name.empty()) {
+                    fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                            "\"args\":{\"name\":\"%s\"}}", first ? "" : ",\n", buffer->tid,
+                            escape(buffer->name).c_str());
+                    first = false;
+                }
+
+                uint64_t head = buffer->head.load(std::memory_order_acquire);
+                uint64_t begin = head > Buffer::CAPACITY ? head - Buffer::CAPACITY : 0;
+                for (uint64_t i = begin; i < head; i++) {
+                    Event &e = buffer->events[i & (Buffer::CAPACITY - 1)];
+                    uint64_t ts = e.ts > start ? e.ts - start : 0;
+                    fprintf(out, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u%s}",
+                            first ? "" : ",\n", escape(e.name).c_str(), e.phase, ts / 1000.0, buffer->tid,
+                            e.phase == 'i' ? ",\"s\":\"t\"" : "");
+                    first = false;
+                }
+            }
+            fprintf(out, "\n]}\n");
+            fclose(out);
+        }
+
+        // Taken before the first buffer is created, and so before any event
+        const uint64_t start = now();
+
+    private:
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Buffer>> buffers;
+    };
+
+    inline Buffer &local() {
+        static thread_local Buffer *buffer = Registry::get().create();
+        return *buffer;
+    }
+
+    inline void begin(const char *name) {
+        if (enabled()) {
+            // The buffer, and with it the registry's start, exists before
+            // the timestamp is taken
+            Buffer &buffer = local();
+            buffer.push(name, 'B', now());
+        }
+    }
+
+    inline void end(const char *name) {
+        if (enabled()) {
+            Buffer &buffer = local();
+            buffer.push(name, 'E', now());
+        }
+    }
+
+    inline void instant(const char *name) {
+        if (enabled()) {
+            Buffer &buffer = local();
+            buffer.push(name, 'i', now());
+        }
+    }
+
+    inline void setThreadName(const std::string &name) {
+        if (enabled()) {
+            local().name = name;
+        }
+    }
+
+    inline void write() {
+        if (enabled()) {
+            Registry::get().write();
+        }
+    }
+
+    /**
+     * Records a begin event on construction and an end event on destruction.
+     * `name` must be a string literal.
+     */
+    class Scoped {
+    public:
+        Scoped(const char *name) : name(name) {
+            begin(name);
+        }
+
+        ~Scoped() {
+            end(name);
+        }
+
+    private:
+        const char *name;
+    };
+}
+
+#endif //HDFS_BENCHMARK_TRACE_H
@@ -11,20 +11,26 @@
 #include <boost/log/expressions.hpp>
 #include <boost/log/trivial.hpp>
 
+#include "BinaryLog.h"
+
 namespace logging = boost::log;
 
 void initLogging() {
     logging::trivial::severity_level level = logging::trivial::info;
+    int blogLevel = BLOG_LEVEL_INFO;
     const char *levelStr = getenv("LOG_LEVEL");
     if(levelStr != 0) {
         if(strcmp(levelStr, "DEBUG") == 0) {
             level = logging::trivial::debug;
+            blogLevel = BLOG_LEVEL_DEBUG;
         } else if(strcmp(levelStr, "WARNING") == 0) {
             level = logging::trivial::warning;
+            blogLevel = BLOG_LEVEL_WARNING;
         }
     }
 
     logging::core::get()->set_filter(logging::trivial::severity >= level);
+    blog::setLevel(blogLevel);
 }
 
 #endif //HDFS_BENCHMARK_LOG_H
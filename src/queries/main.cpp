@@ -3,6 +3,8 @@
 
 #include "../queries/HdfsReader.h"
 #include "../queries/log.h"
+#include "../queries/PerfCounters.h"
+#include "../queries/Trace.h"
 
 using namespace std;
 
@@ -28,7 +30,7 @@ int main(int argc, char **argv) {
     size_t len = 0;
     hdfsReader.read(path, nullptr, [&](Block &block) {
         len += block.fileInfo.mSize;
-        BOOST_LOG_TRIVIAL(debug) << "Read block " << block.idx;
+        BLOG_DEBUG("Read block %u", block.idx);
     }, threadCount);
 
     auto stop = std::chrono::high_resolution_clock::now();
@@ -36,4 +38,7 @@ int main(int argc, char **argv) {
     double d_sec2 = ((double)std::chrono::duration_cast<std::chrono::milliseconds>(stop - start2).count())/1000.0;
 
     cout << ((double)len)/(1024.*1024.)/d_sec << " " << ((double)len)/(1024.*1024.)/d_sec2 << endl;
+    latency::print();
+    perf::print();
+    trace::write();
 }
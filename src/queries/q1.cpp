@@ -6,7 +6,12 @@
 
 #include "HdfsReader.h"
 #include "ParquetFile.h"
+#include "Morsel.h"
+#include "Scan.h"
 #include "log.h"
+#include "PerfCounters.h"
+#include "Q1.h"
+#include "Trace.h"
 #include "sha256.h"
 
 static void print(const char *header, double *values) {
@@ -31,90 +36,75 @@ int main(int argc, char **argv) {
     hdfsReader.connect();
 
     // Intermediate and result data structures
-    struct Group {
-        double sum1 = 0, sum2 = 0, sum3 = 0, sum4 = 0, sum5 = 0, count = 0;
-    };
-    Group groups[4];
-    //memset(groups, 0, sizeof(Group)*4);
+    q1::Group groups[q1::GROUP_COUNT];
     double results[4 * 8];
-    unsigned groupIds[4] = {('A' << 8) | 'F', ('N' << 8) | 'F', ('N' << 8) | 'O', ('R' << 8) | 'F'};
-    std::mutex groupsMutex;
 
     auto start = std::chrono::high_resolution_clock::now();
 
-    vector<vector<Group>> _groups;
-    boost::atomic<unsigned> idxCounter(0);
+    MorselPool pool(threadCount);
+    PerWorker<vector<q1::Group>> _groups(pool);
+    for (unsigned worker = 0; worker < _groups.size(); worker++) {
+        _groups[worker].resize(q1::GROUP_COUNT);
+    }
+
+    const Date minDate(0), maxDate(19980811);
 
-    // Start Reading the directory of parquet files, process the files as
-    // they are available
+    // Start Reading the directory of parquet files, process the row groups
+    // of the files on the workers as they are available
     hdfsReader.read(lineitemPath, [&](vector<string> &paths){
-        _groups.resize(paths.size());
     },[&](Block block) {
-        ParquetFile file(static_cast<const uint8_t *>(block.data.get()), block.fileInfo.mSize);
-
-        unsigned idx = idxCounter++;
-        _groups[idx].resize(4);
-
-        for (auto &rowGroup : file.getRowGroups()) {
-            auto quantityColumn = rowGroup.getColumn(4).getReader();
-            auto extendedpriceColumn = rowGroup.getColumn(5).getReader();
-            auto discountColumn = rowGroup.getColumn(6).getReader();
-            auto taxColumn = rowGroup.getColumn(7).getReader();
-            auto returnflagColumn = rowGroup.getColumn(8).getReader();
-            auto linestatusColumn = rowGroup.getColumn(9).getReader();
-            auto dateColumn = rowGroup.getColumn(10).getReader();
-
-            while (dateColumn.hasNext()) {
-                assert(returnflagColumn.hasNext() && linestatusColumn.hasNext() &&
-                       extendedpriceColumn.hasNext() && discountColumn.hasNext() &&
-                       taxColumn.hasNext() && quantityColumn.hasNext());
-
-                string dateStr = dateColumn.read < string > ();
-                int a = 0, b = 0, c = 0;
-                sscanf(reinterpret_cast<const char *>(dateStr.c_str()), "%d-%d-%d", &a, &b, &c);
-                unsigned date = (a * 10000) + (b * 100) + c;
-
-                char returnflag = returnflagColumn.read < ByteArray > ().ptr[0];
-                char linestatus = linestatusColumn.read < ByteArray > ().ptr[0];
-                double quantity = quantityColumn.read < double > ();
-                double extendedprice = extendedpriceColumn.read < double > ();
-                double discount = discountColumn.read < double > ();
-                double tax = taxColumn.read < double > ();
-
-                if (date > 19980811) {
-                    continue;
-                }
-
-                int f = ((returnflag << 8) | linestatus);
-                int groupId = -1;
-                for (unsigned i = 0; i < 4; i++) {
-                    if (f == groupIds[i]) {
-                        groupId = i;
-                        break;
-                    }
-                }
-                assert(groupId >= 0 && groupId < 4);
-                Group &s = _groups[idx][groupId];
-                double v1 = extendedprice * (1.0 - discount);
-                double v2 = v1 * (1.0 + tax);
-                s.sum1 += quantity;
-                s.sum2 += extendedprice;
-                s.sum3 += v1;
-                s.sum4 += v2;
-                s.sum5 += discount;
-                s.count++;
+        pool.scan(openFile(block), [&](unsigned worker, benchmark::RowGroup &rowGroup, uint64_t firstRow) {
+            perf::Phase phase("q1_lineitem_scan", rowGroup.getCompressedSize());
+            latency::Scoped decode(latency::RowGroupDecode);
+            trace::Scoped traced("rowgroup_decode");
+            vector<uint8_t> groupIdByCode;
+
+            Scan scan(rowGroup);
+            scan.between(10, minDate, maxDate);
+            const double *quantity = scan.column<double>(4);
+            const double *extendedprice = scan.column<double>(5);
+            const double *discount = scan.column<double>(6);
+            const double *tax = scan.column<double>(7);
+
+            q1::Group *workerGroups = _groups[worker].data();
+
+            // Group by the dictionary codes if possible, look up the group of
+            // each code combination once per row group
+            if (scan.isDictionaryEncoded(8) && scan.isDictionaryEncoded(9)) {
+                size_t returnflagSize, linestatusSize;
+                auto returnflagDictionary = scan.getDictionary<ByteArray>(8, &returnflagSize);
+                auto linestatusDictionary = scan.getDictionary<ByteArray>(9, &linestatusSize);
+                q1::groupIdsByCode(returnflagDictionary, returnflagSize, linestatusDictionary, linestatusSize,
+                                   groupIdByCode);
+
+                const uint32_t *returnflag = scan.codes(8);
+                const uint32_t *linestatus = scan.codes(9);
+                scan.run([&](const uint32_t *selection, size_t count) {
+                    q1::aggregate(workerGroups, selection, count, quantity, extendedprice, discount, tax,
+                                  [&](size_t i) {
+                                      return groupIdByCode[returnflag[i] * linestatusSize + linestatus[i]];
+                                  });
+                });
+            } else {
+                const ByteArray *returnflag = scan.column<ByteArray>(8);
+                const ByteArray *linestatus = scan.column<ByteArray>(9);
+                scan.run([&](const uint32_t *selection, size_t count) {
+                    q1::aggregate(workerGroups, selection, count, quantity, extendedprice, discount, tax,
+                                  [&](size_t i) {
+                                      return q1::groupOf(returnflag[i], linestatus[i]);
+                                  });
+                });
             }
-        }
+        });
     }, threadCount);
+    pool.wait();
 
-    for(unsigned x=0; x<_groups.size(); x++) {
-        for (unsigned i = 0; i < 4; i++) {
-            groups[i].sum1 += _groups[x][i].sum1;
-            groups[i].sum2 += _groups[x][i].sum2;
-            groups[i].sum3 += _groups[x][i].sum3;
-            groups[i].sum4 += _groups[x][i].sum4;
-            groups[i].sum5 += _groups[x][i].sum5;
-            groups[i].count += _groups[x][i].count;
+    {
+        perf::Phase phase("q1_merge");
+        for(unsigned x=0; x<_groups.size(); x++) {
+            for (unsigned i = 0; i < q1::GROUP_COUNT; i++) {
+                q1::merge(groups[i], _groups[x][i]);
+            }
         }
     }
 
@@ -138,6 +128,11 @@ int main(int argc, char **argv) {
     print("R F", results + 24);
 
     cout << "duration " << std::chrono::duration_cast<std::chrono::milliseconds>(stop - start).count() << "ms" << endl;
+    latency::print();
+    pruning::print();
+    decompression::print();
+    perf::print();
+    trace::write();
 
     return 0;
 }
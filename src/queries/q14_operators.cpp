@@ -0,0 +1,85 @@
+#include <iostream>
+#include <string>
+
+#include "HdfsReader.h"
+#include "ParquetFile.h"
+#include "Morsel.h"
+#include "Operators.h"
+#include "log.h"
+#include "PerfCounters.h"
+#include "Q14.h"
+#include "Trace.h"
+
+// q14 composed of the operators of Operators.h, see q14.cpp for the hand
+// written pipeline it is compared against
+
+using q14::Revenue;
+
+int main(int argc, char **argv) {
+    initLogging();
+    if (argc != 1+5) {
+        cout << "Usage: " << argv[0] << " #THREADS NAMENODE SOCKET LINEITEM-PATH PART-PATH" << endl;
+        exit(1);
+    }
+
+    const unsigned threadCount = atoi(argv[1]);
+    string namenode = argv[2];
+    string socket = (strcmp(argv[3], "-") == 0 ? "" : argv[3]);
+    string lineitemPath = argv[4];
+    string partPath = argv[5];
+
+    HdfsReader hdfsReader(namenode, 9000, socket);
+    hdfsReader.connect();
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    MorselPool pool(threadCount);
+
+    // lineitem scan -> build on l_partkey with the revenue as payload
+    ParquetScan lineitem(hdfsReader, pool, lineitemPath, "q14_lineitem_scan");
+    lineitem.between(10, Date(19950901), Date(19950930));
+    const unsigned l_partkey = lineitem.column<int32_t>(1);
+    const unsigned l_extendedprice = lineitem.column<double>(5);
+    const unsigned l_discount = lineitem.column<double>(6);
+
+    auto build = hashJoinBuild<int32_t, double>(pool, [=](const Batch &batch, uint32_t i) {
+        return batch.column<int32_t>(l_partkey)[i];
+    }, [=](const Batch &batch, uint32_t i) {
+        return batch.column<double>(l_extendedprice)[i] * (1 - batch.column<double>(l_discount)[i]);
+    }, "q14_hash_build");
+    lineitem.run(build);
+
+    // part scan -> probe on p_partkey -> sum of the (promo) revenue
+    ParquetScan part(hdfsReader, pool, partPath, "q14_part_probe");
+    const unsigned p_partkey = part.column<int32_t>(0);
+    const unsigned p_type = part.column<ByteArray>(4);
+
+    unsigned type, revenue;
+    auto sums = reduce<Revenue>(pool, [&](Revenue &r, const Batch &batch, uint32_t i) {
+        double a = batch.column<double>(revenue)[i];
+        if (q14::isPromo(batch.column<ByteArray>(type)[i])) {
+            r.promo += a;
+        }
+        r.total += a;
+    }, q14::merge);
+
+    auto probe = hashJoinProbe<int32_t>(pool, build.getIndex(), p_partkey, sums);
+    type = probe.carry<ByteArray>(p_type);
+    revenue = probe.valueSlot();
+    part.run(probe);
+
+    double result = 100 * (sums.getResult().promo / sums.getResult().total);
+
+    auto stop = std::chrono::high_resolution_clock::now();
+
+    cout << result << endl;
+
+    cout << "duration " << std::chrono::duration_cast<std::chrono::milliseconds>(stop - start).count() << "ms" << endl;
+    latency::print();
+    pruning::print();
+    decompression::print();
+    perf::print();
+    trace::write();
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include <iostream>
+#include <string>
+
+#include "HashJoin.h"
+#include "HdfsReader.h"
+#include "ParquetFile.h"
+#include "Morsel.h"
+#include "Pipeline.h"
+#include "Tpch.h"
+#include "log.h"
+#include "PerfCounters.h"
+#include "Q14.h"
+#include "Trace.h"
+
+// q14 as pipelines of Pipeline.h, see q14.cpp for the hand written loops
+// they are compared against
+
+using namespace tpch;
+
+using q14::Revenue;
+
+struct l_revenue : pipeline::Value<double> {};
+struct p_promo : pipeline::Value<bool> {};
+
+int main(int argc, char **argv) {
+    initLogging();
+    if (argc != 1+5) {
+        cout << "Usage: " << argv[0] << " #THREADS NAMENODE SOCKET LINEITEM-PATH PART-PATH" << endl;
+        exit(1);
+    }
+
+    const unsigned threadCount = atoi(argv[1]);
+    string namenode = argv[2];
+    string socket = (strcmp(argv[3], "-") == 0 ? "" : argv[3]);
+    string lineitemPath = argv[4];
+    string partPath = argv[5];
+
+    HdfsReader hdfsReader(namenode, 9000, socket);
+    hdfsReader.connect();
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    MorselPool pool(threadCount);
+
+    // Collect the revenue of the lineitems of September 1995 by part
+    pipeline::Collect<l_partkey, l_revenue> revenues(pool);
+    pipeline::scan<Lineitem, l_partkey, l_extendedprice, l_discount>()
+            .between<l_shipdate>(Date(19950901), Date(19950930))
+            .map<l_revenue, l_extendedprice, l_discount>([](double extendedprice, double discount) {
+                return extendedprice * (1 - discount);
+            })
+            .run(hdfsReader, pool, lineitemPath, "q14_lineitem_scan", revenues);
+
+    unique_ptr<CsrIndex<double>> revenueByPart;
+    {
+        perf::Phase phase("q14_hash_build");
+        revenueByPart = buildCsrIndex(pool, revenues.getEntries());
+    }
+
+    // Probe with part, sum the revenue of all and of the promo parts; only
+    // the parts that matched are tested for PROMO
+    auto sums = pipeline::reduce<Revenue, l_revenue, p_promo>(pool, [](Revenue &r, double revenue, bool isPromo) {
+        if (isPromo) {
+            r.promo += revenue;
+        }
+        r.total += revenue;
+    }, q14::merge);
+    pipeline::scan<Part, p_partkey, p_type>()
+            .probe<l_revenue, p_partkey>(*revenueByPart)
+            .map<p_promo, p_type>([](const ByteArray &type) {
+                return q14::isPromo(type);
+            })
+            .run(hdfsReader, pool, partPath, "q14_part_probe", sums);
+
+    double result = 100 * (sums.getResult().promo / sums.getResult().total);
+
+    auto stop = std::chrono::high_resolution_clock::now();
+
+    cout << result << endl;
+
+    cout << "duration " << std::chrono::duration_cast<std::chrono::milliseconds>(stop - start).count() << "ms" << endl;
+    latency::print();
+    pruning::print();
+    decompression::print();
+    perf::print();
+    trace::write();
+
+    return 0;
+}
@@ -2,7 +2,13 @@
 
 #include "HdfsReader.h"
 #include "ParquetFile.h"
+#include "Morsel.h"
+#include "Scan.h"
 #include "log.h"
+#include "PerfCounters.h"
+#include "Q17.h"
+#include "RadixSort.h"
+#include "Trace.h"
 
 struct P_brand {
     char data[10];
@@ -11,11 +17,7 @@ struct P_container {
     char data[10];
 };
 
-struct LineitemMatch {
-    int32_t partkey;
-    double quantity;
-    double extendedprice;
-};
+using q17::LineitemMatch;
 
 int main(int argc, char **argv) {
     initLogging();
@@ -48,98 +50,106 @@ int main(int argc, char **argv) {
     vector<bool> partMatches;
     partMatches.resize(20000000);
 
+    MorselPool pool(threadCount);
+    auto isBrand = [&](const ByteArray &byteArray) {
+        P_brand brand;
+        memset(brand.data, 0, 10);
+        memcpy(brand.data, byteArray.ptr, MIN(byteArray.len, 10));
+        uint64_t b1 = *reinterpret_cast<const uint64_t *>(brand.data);
+        uint16_t b2 = *reinterpret_cast<const uint16_t *>(brand.data + 8);
+        return (b1 == brandPattern1) && (b2 == brandPattern2);
+    };
+    auto isContainer = [&](const ByteArray &byteArray) {
+        P_container container;
+        memset(container.data, 0, 10);
+        memcpy(container.data, byteArray.ptr, MIN(byteArray.len, 10));
+        uint64_t c1 = *reinterpret_cast<const uint64_t *>(container.data);
+        uint64_t c2 = *reinterpret_cast<const uint16_t *>(container.data + 8);
+        return (c1 == containerPattern1) && (c2 == containerPattern2);
+    };
+
+    // Matching partkeys are collected per worker, vector<bool> is not safe for concurrent writes
+    PerWorker<vector<int32_t>> partkeys(pool);
     hdfsReader.read(partPath, [&](vector<string> &paths) {
 
     }, [&](Block block) {
-        ParquetFile file(static_cast<const uint8_t *>(block.data.get()), block.fileInfo.mSize);
-        for (auto &rowGroup : file.getRowGroups()) {
-            auto partkeyColumn = rowGroup.getColumn(0).getReader();
-            auto brandColumn = rowGroup.getColumn(3).getReader();
-            auto containerColumn = rowGroup.getColumn(6).getReader();
-
-            P_container container;
-            P_brand brand;
-
-            while (partkeyColumn.hasNext()) {
-                assert(brandColumn.hasNext() && containerColumn.hasNext());
-
-                auto partkey = partkeyColumn.read<int32_t>();
-                auto brandByteArray = brandColumn.read<ByteArray>();
-                auto containerByteArray = containerColumn.read<ByteArray>();
-
-                memset(brand.data, 0, 10);
-                memcpy(brand.data, brandByteArray.ptr, MIN(brandByteArray.len, 10));
-
-                memset(container.data, 0, 10);
-                memcpy(container.data, containerByteArray.ptr, MIN(containerByteArray.len, 10));
-
-                uint64_t b1 = *reinterpret_cast<const uint64_t *>(brand.data);
-                uint16_t b2 = *reinterpret_cast<const uint16_t *>(brand.data + 8);
-                uint64_t c1 = *reinterpret_cast<const uint64_t *>(container.data);
-                uint64_t c2 = *reinterpret_cast<const uint16_t *>(container.data + 8);
-                if ((b1 == brandPattern1) && (b2 == brandPattern2) && (c1 == containerPattern1) &&
-                    (c2 == containerPattern2)) {
-                    partMatches[partkey] = true;
+        pool.scan(openFile(block), [&](unsigned worker, benchmark::RowGroup &rowGroup, uint64_t firstRow) {
+            perf::Phase phase("q17_part_scan", rowGroup.getCompressedSize());
+            latency::Scoped decode(latency::RowGroupDecode);
+            trace::Scoped traced("rowgroup_decode");
+
+            // Evaluated once per dictionary entry for dictionary encoded columns
+            Scan scan(rowGroup);
+            scan.where<ByteArray>(3, isBrand).where<ByteArray>(6, isContainer);
+            const int32_t *partkey = scan.column<int32_t>(0);
+
+            scan.run([&](const uint32_t *selection, size_t count) {
+                for (size_t k = 0; k < count; k++) {
+                    partkeys[worker].push_back(partkey[selection[k]]);
                 }
-            }
-        }
+            });
+        });
     }, threadCount);
+    pool.wait();
+
+    for (unsigned worker = 0; worker < partkeys.size(); worker++) {
+        for (int32_t partkey : partkeys[worker]) {
+            partMatches[partkey] = true;
+        }
+    }
 
     // Read lineitem
-    vector<LineitemMatch> matched;
-    mutex matchedMutex;
+    PerWorker<vector<LineitemMatch>> matches(pool);
     hdfsReader.read(lineitemPath, [&](vector<string> &paths) {
 
     }, [&](Block block) {
-        ParquetFile file(static_cast<const uint8_t *>(block.data.get()), block.fileInfo.mSize);
-        for (auto &rowGroup : file.getRowGroups()) {
-            auto partkeyColumn = rowGroup.getColumn(1).getReader();
-            auto quantityColumn = rowGroup.getColumn(4).getReader();
-            auto extendedpriceColumn = rowGroup.getColumn(5).getReader();
-
-            while (partkeyColumn.hasNext()) {
-                assert(quantityColumn.hasNext() && extendedpriceColumn.hasNext());
-
-                auto partkey = partkeyColumn.read<int32_t>();
-                auto quantity = quantityColumn.read<double>();
-                auto extendedprice = extendedpriceColumn.read<double>();
-
-                if (partMatches[partkey]) {
-                    matchedMutex.lock();
-                    matched.push_back({partkey, quantity, extendedprice});
-                    matchedMutex.unlock();
+        pool.scan(openFile(block), [&](unsigned worker, benchmark::RowGroup &rowGroup, uint64_t firstRow) {
+            perf::Phase phase("q17_lineitem_scan", rowGroup.getCompressedSize());
+            latency::Scoped decode(latency::RowGroupDecode);
+            trace::Scoped traced("rowgroup_decode");
+
+            Scan scan(rowGroup);
+            scan.where<int32_t>(1, [&](int32_t partkey) { return partMatches[partkey]; });
+            const int32_t *partkey = scan.column<int32_t>(1);
+            const double *quantity = scan.column<double>(4);
+            const double *extendedprice = scan.column<double>(5);
+
+            scan.run([&](const uint32_t *selection, size_t count) {
+                for (size_t k = 0; k < count; k++) {
+                    size_t i = selection[k];
+                    matches[worker].push_back({partkey[i], quantity[i], extendedprice[i]});
                 }
-            }
-        }
+            });
+        });
     }, threadCount);
+    pool.wait();
 
-    sort(matched.begin(), matched.end(), [](const LineitemMatch &a, const LineitemMatch &b) {
-        return a.partkey < b.partkey;
-    });
-
-    double sum = 0;
-    for (unsigned index = 0, limit = matched.size(); index != limit;) {
-        unsigned partkey = matched[index].partkey;
-        unsigned end = index;
-        double avgQuantity = 0;
-        while (true) {
-            if ((end == limit) || (matched[end].partkey != partkey)) break;
-            avgQuantity += matched[end].quantity;
-            ++end;
-        }
-        avgQuantity = 0.2 * avgQuantity / (end - index);
-        for (; index != end; ++index) {
-            if (matched[index].quantity < avgQuantity)
-                sum += matched[index].extendedprice;
-        }
+    // Radix sort the workers' matches by partkey
+    vector<LineitemMatch> matched;
+    {
+        perf::Phase phase("q17_sort");
+        matched = radixSort(pool, matches, [](const LineitemMatch &match) {
+            return (uint32_t) match.partkey;
+        });
+    }
 
-        index = end;
+    // Split the matches into one range per worker at partkey boundaries
+    // and aggregate the ranges in parallel
+    double sum;
+    {
+        perf::Phase phase("q17_aggregate");
+        sum = q17::parallelAggregate(pool, matched);
     }
     double result = sum / 7.0;
 
     auto stop = std::chrono::high_resolution_clock::now();
     cout << result << endl;
     cout << "duration " << std::chrono::duration_cast<std::chrono::milliseconds>(stop - start).count() << "ms" << endl;
+    latency::print();
+    pruning::print();
+    decompression::print();
+    perf::print();
+    trace::write();
 
     return 0;
 }
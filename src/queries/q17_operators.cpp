@@ -0,0 +1,85 @@
+#include <iostream>
+
+#include "HdfsReader.h"
+#include "ParquetFile.h"
+#include "Morsel.h"
+#include "Operators.h"
+#include "log.h"
+#include "PerfCounters.h"
+#include "Q17.h"
+#include "Trace.h"
+
+// q17 composed of the operators of Operators.h, see q17.cpp for the hand
+// written pipeline it is compared against
+
+using q17::LineitemMatch;
+
+static bool equals(const ByteArray &byteArray, const char *value) {
+    size_t length = strlen(value);
+    return byteArray.len == length && memcmp(byteArray.ptr, value, length) == 0;
+}
+
+int main(int argc, char **argv) {
+    initLogging();
+    if (argc != 1+5) {
+        cout << "Usage: " << argv[0] << " #THREADS NAMENODE SOCKET LINEITEM-PATH PART-PATH" << endl;
+        exit(1);
+    }
+
+    const unsigned threadCount = atoi(argv[1]);
+    string namenode = argv[2];
+    string socket = (strcmp(argv[3], "-") == 0 ? "" : argv[3]);
+    string lineitemPath = argv[4];
+    string partPath = argv[5];
+
+    HdfsReader hdfsReader(namenode, 9000, socket);
+    hdfsReader.connect();
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    MorselPool pool(threadCount);
+
+    // part scan, brand and container evaluated per dictionary entry -> bitmap of p_partkey
+    ParquetScan part(hdfsReader, pool, partPath, "q17_part_scan");
+    part.where<ByteArray>(3, [](const ByteArray &brand) { return equals(brand, "Brand#23"); });
+    part.where<ByteArray>(6, [](const ByteArray &container) { return equals(container, "MED BOX"); });
+    const unsigned p_partkey = part.column<int32_t>(0);
+
+    auto parts = bitmapBuild(pool, [=](const Batch &batch, uint32_t i) {
+        return (uint32_t) batch.column<int32_t>(p_partkey)[i];
+    }, "q17_bitmap_build");
+    part.run(parts);
+
+    // lineitem scan, semi join on l_partkey pushed into the scan -> radix sort by l_partkey
+    ParquetScan lineitem(hdfsReader, pool, lineitemPath, "q17_lineitem_scan");
+    lineitem.semiJoin<int32_t>(1, parts.getBitmap());
+    const unsigned l_partkey = lineitem.column<int32_t>(1);
+    const unsigned l_quantity = lineitem.column<double>(4);
+    const unsigned l_extendedprice = lineitem.column<double>(5);
+
+    auto sorted = sortBy<LineitemMatch>(pool, [=](const Batch &batch, uint32_t i) {
+        return LineitemMatch{batch.column<int32_t>(l_partkey)[i], batch.column<double>(l_quantity)[i],
+                             batch.column<double>(l_extendedprice)[i]};
+    }, [](const LineitemMatch &match) {
+        return (uint32_t) match.partkey;
+    }, "q17_sort");
+    lineitem.run(sorted);
+
+    double sum;
+    {
+        perf::Phase phase("q17_aggregate");
+        sum = q17::parallelAggregate(pool, sorted.getResult());
+    }
+    double result = sum / 7.0;
+
+    auto stop = std::chrono::high_resolution_clock::now();
+    cout << result << endl;
+    cout << "duration " << std::chrono::duration_cast<std::chrono::milliseconds>(stop - start).count() << "ms" << endl;
+    latency::print();
+    pruning::print();
+    decompression::print();
+    perf::print();
+    trace::write();
+
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include <iostream>
+#include <iomanip>
+
+#include "HdfsReader.h"
+#include "ParquetFile.h"
+#include "Morsel.h"
+#include "Operators.h"
+#include "log.h"
+#include "PerfCounters.h"
+#include "Q1.h"
+#include "Trace.h"
+
+// q1 composed of the operators of Operators.h, see q1.cpp for the hand
+// written pipeline it is compared against
+
+static void print(const char *header, double *values) {
+    cout << header;
+    for (unsigned index = 0; index != 8; ++index) cout << fixed << setprecision(2) << " " << values[index];
+    cout << endl;
+}
+
+using q1::Group;
+
+int main(int argc, char **argv) {
+    initLogging();
+    if (argc != 1+4) {
+        cout << "Usage: " << argv[0] << " #THREADS NAMENODE SOCKET LINEITEM-PATH" << endl;
+        exit(1);
+    }
+
+    const unsigned threadCount = atoi(argv[1]);
+    string namenode = argv[2];
+    string socket = (strcmp(argv[3], "-") == 0 ? "" : argv[3]);
+    string lineitemPath = argv[4];
+
+    HdfsReader hdfsReader(namenode, 9000, socket);
+    hdfsReader.connect();
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    MorselPool pool(threadCount);
+
+    // scan -> project -> aggregate
+    ParquetScan lineitem(hdfsReader, pool, lineitemPath, "q1_lineitem_scan");
+    lineitem.between(10, Date(0), Date(19980811));
+    const unsigned quantity = lineitem.column<double>(4);
+    const unsigned extendedprice = lineitem.column<double>(5);
+    const unsigned discount = lineitem.column<double>(6);
+    const unsigned tax = lineitem.column<double>(7);
+    const unsigned returnflag = lineitem.column<ByteArray>(8);
+    const unsigned linestatus = lineitem.column<ByteArray>(9);
+
+    // The slots of the projected columns are known once the projection is
+    // set up, which needs the aggregate as its consumer
+    unsigned discPrice, charge;
+    auto aggregate = hashAggregate<unsigned, Group>(pool, [&](const Batch &batch, uint32_t i) {
+        return (unsigned) ((batch.column<ByteArray>(returnflag)[i].ptr[0] << 8) |
+                           batch.column<ByteArray>(linestatus)[i].ptr[0]);
+    }, [&](Group &s, const Batch &batch, uint32_t i) {
+        s.sum1 += batch.column<double>(quantity)[i];
+        s.sum2 += batch.column<double>(extendedprice)[i];
+        s.sum3 += batch.column<double>(discPrice)[i];
+        s.sum4 += batch.column<double>(charge)[i];
+        s.sum5 += batch.column<double>(discount)[i];
+        s.count++;
+    }, q1::merge);
+
+    Project project(pool, 6, aggregate);
+    discPrice = project.add<double>([=](const Batch &batch, uint32_t i) {
+        return batch.column<double>(extendedprice)[i] * (1.0 - batch.column<double>(discount)[i]);
+    });
+    charge = project.add<double>([=](const Batch &batch, uint32_t i) {
+        return batch.column<double>(discPrice)[i] * (1.0 + batch.column<double>(tax)[i]);
+    });
+
+    lineitem.run(project);
+
+    // Groups are ordered by key, which is the order of q1's ORDER BY
+    const char *headers[4] = {"A F", "N F", "N O", "R F"};
+    double results[4 * 8] = {0};
+    unsigned index = 0;
+    for (auto &group : aggregate.getResult()) {
+        if (index == 4) {
+            throw runtime_error("More than 4 groups in q1");
+        }
+        const Group &g = group.second;
+        results[8 * index + 0] = g.sum1;
+        results[8 * index + 1] = g.sum2;
+        results[8 * index + 2] = g.sum3;
+        results[8 * index + 3] = g.sum4;
+        results[8 * index + 4] = g.sum1 / g.count;
+        results[8 * index + 5] = g.sum2 / g.count;
+        results[8 * index + 6] = g.sum5 / g.count;
+        results[8 * index + 7] = g.count;
+        index++;
+    }
+
+    auto stop = std::chrono::high_resolution_clock::now();
+
+    for (unsigned g = 0; g < 4; g++) {
+        print(headers[g], results + 8 * g);
+    }
+
+    cout << "duration " << std::chrono::duration_cast<std::chrono::milliseconds>(stop - start).count() << "ms" << endl;
+    latency::print();
+    pruning::print();
+    decompression::print();
+    perf::print();
+    trace::write();
+
+    return 0;
+}
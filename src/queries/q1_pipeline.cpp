@@ -0,0 +1,108 @@
+#include <iostream>
+#include <iomanip>
+
+#include "HdfsReader.h"
+#include "ParquetFile.h"
+#include "Morsel.h"
+#include "Pipeline.h"
+#include "Tpch.h"
+#include "log.h"
+#include "PerfCounters.h"
+#include "Q1.h"
+#include "Trace.h"
+
+// q1 as a pipeline of Pipeline.h, see q1.cpp for the hand written loop it
+// is compared against
+
+using namespace tpch;
+
+static void print(const char *header, double *values) {
+    cout << header;
+    for (unsigned index = 0; index != 8; ++index) cout << fixed << setprecision(2) << " " << values[index];
+    cout << endl;
+}
+
+using q1::Group;
+
+struct GroupKey : pipeline::Value<unsigned> {};
+struct DiscPrice : pipeline::Value<double> {};
+struct Charge : pipeline::Value<double> {};
+
+int main(int argc, char **argv) {
+    initLogging();
+    if (argc != 1+4) {
+        cout << "Usage: " << argv[0] << " #THREADS NAMENODE SOCKET LINEITEM-PATH" << endl;
+        exit(1);
+    }
+
+    const unsigned threadCount = atoi(argv[1]);
+    string namenode = argv[2];
+    string socket = (strcmp(argv[3], "-") == 0 ? "" : argv[3]);
+    string lineitemPath = argv[4];
+
+    HdfsReader hdfsReader(namenode, 9000, socket);
+    hdfsReader.connect();
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    MorselPool pool(threadCount);
+
+    auto groups = pipeline::aggregate<GroupKey, Group, l_quantity, l_extendedprice, DiscPrice, Charge, l_discount>(
+            pool, [](Group &s, double quantity, double extendedprice, double discPrice, double charge,
+                     double discount) {
+                s.sum1 += quantity;
+                s.sum2 += extendedprice;
+                s.sum3 += discPrice;
+                s.sum4 += charge;
+                s.sum5 += discount;
+                s.count++;
+            }, q1::merge);
+
+    pipeline::scan<Lineitem, l_quantity, l_extendedprice, l_discount, l_tax, l_returnflag, l_linestatus>()
+            .between<l_shipdate>(Date(0), Date(19980811))
+            .map<GroupKey, l_returnflag, l_linestatus>([](const ByteArray &returnflag, const ByteArray &linestatus) {
+                return (unsigned) ((returnflag.ptr[0] << 8) | linestatus.ptr[0]);
+            })
+            .map<DiscPrice, l_extendedprice, l_discount>([](double extendedprice, double discount) {
+                return extendedprice * (1.0 - discount);
+            })
+            .map<Charge, DiscPrice, l_tax>([](double discPrice, double tax) {
+                return discPrice * (1.0 + tax);
+            })
+            .run(hdfsReader, pool, lineitemPath, "q1_lineitem_scan", groups);
+
+    // Groups are ordered by key, which is the order of q1's ORDER BY
+    const char *headers[4] = {"A F", "N F", "N O", "R F"};
+    double results[4 * 8] = {0};
+    unsigned index = 0;
+    for (auto &group : groups.getResult()) {
+        if (index == 4) {
+            throw runtime_error("More than 4 groups in q1");
+        }
+        const Group &g = group.second;
+        results[8 * index + 0] = g.sum1;
+        results[8 * index + 1] = g.sum2;
+        results[8 * index + 2] = g.sum3;
+        results[8 * index + 3] = g.sum4;
+        results[8 * index + 4] = g.sum1 / g.count;
+        results[8 * index + 5] = g.sum2 / g.count;
+        results[8 * index + 6] = g.sum5 / g.count;
+        results[8 * index + 7] = g.count;
+        index++;
+    }
+
+    auto stop = std::chrono::high_resolution_clock::now();
+
+    for (unsigned g = 0; g < 4; g++) {
+        print(headers[g], results + 8 * g);
+    }
+
+    cout << "duration " << std::chrono::duration_cast<std::chrono::milliseconds>(stop - start).count() << "ms" << endl;
+    latency::print();
+    pruning::print();
+    decompression::print();
+    perf::print();
+    trace::write();
+
+    return 0;
+}